@@ -0,0 +1,417 @@
+#include "Benchmarks.h"
+#include "ImageScaler.h"
+#include "MediaProbe.h"
+#include "FfmpegUtil.h"
+#include "ImageHeader.h"
+#include "LibraryIndex.h"
+#include "SessionSnapshot.h"
+#include "YouTubeStyleManager.h"
+#include "SingleInstance.h"
+#include "ThumbnailDelegate.h"
+
+#include <QImage>
+#include <QImageReader>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QFile>
+#include <QTimer>
+#include <QEventLoop>
+#include <QListWidget>
+#include <QCoreApplication>
+#include <QProcess>
+#include <QPainter>
+#include <QStyleOptionViewItem>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+// 生成带渐变和噪点的测试图，避免纯色图让两种实现都走捷径
+QImage makeTestImage(const QSize &size, bool alpha)
+{
+    QImage img(size, alpha ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    QRandomGenerator rng(42);
+    for (int y = 0; y < img.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(img.scanLine(y));
+        for (int x = 0; x < img.width(); ++x) {
+            const int a = alpha ? 128 + int(rng.bounded(128)) : 255;
+            const int r = (x * 255 / img.width() + int(rng.bounded(32))) & 0xff;
+            const int g = (y * 255 / img.height() + int(rng.bounded(32))) & 0xff;
+            const int b = int(rng.bounded(256));
+            line[x] = qRgba(r * a / 255, g * a / 255, b * a / 255, a);
+        }
+    }
+    return img;
+}
+
+// 多次运行取中位数（毫秒）
+double medianMs(int runs, const std::function<void()> &fn)
+{
+    QVector<double> samples;
+    QElapsedTimer timer;
+    for (int i = 0; i < runs; ++i) {
+        timer.start();
+        fn();
+        samples.append(timer.nsecsElapsed() / 1e6);
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples.at(samples.size() / 2);
+}
+
+// 两张同尺寸图片的平均通道差，用来确认质量没有明显偏离 Qt
+double meanAbsDiff(const QImage &a, const QImage &b)
+{
+    if (a.size() != b.size())
+        return -1.0;
+    const QImage ca = a.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const QImage cb = b.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    qint64 sum = 0;
+    for (int y = 0; y < ca.height(); ++y) {
+        const uchar *pa = ca.constScanLine(y);
+        const uchar *pb = cb.constScanLine(y);
+        for (int x = 0; x < ca.width() * 4; ++x)
+            sum += qAbs(int(pa[x]) - int(pb[x]));
+    }
+    return double(sum) / (qint64(ca.width()) * ca.height() * 4);
+}
+
+// 第一帧的预算：从进程启动到网格第一次画完
+const double FirstFrameBudgetMs = 200.0;
+
+// 网格视口收到第一个 Paint 后，等这一轮事件处理完（画完并刷到屏幕）再记时间
+class FirstPaintProbe : public QObject {
+public:
+    explicit FirstPaintProbe(std::function<void()> done) : m_done(std::move(done)) {}
+
+    bool eventFilter(QObject *obj, QEvent *event) override {
+        if (event->type() == QEvent::Paint && m_done) {
+            QTimer::singleShot(0, this, m_done);
+            m_done = nullptr;
+        }
+        return QObject::eventFilter(obj, event);
+    }
+
+private:
+    std::function<void()> m_done;
+};
+
+} // namespace
+
+int runScalerBenchmark()
+{
+    QTextStream out(stdout);
+    out << "image scaler backend: " << imageScalerBackend() << "\n";
+
+    struct Case {
+        const char *name;
+        QSize source;
+        QSize target;
+        bool alpha;
+        ScaleKernel kernel;
+    };
+    // 网格缩略图（DPR 1 / 2）与详情页封面两类典型负载
+    const Case cases[] = {
+        { "jpeg 4000x3000 -> grid",      QSize(4000, 3000), QSize(144, 108), false, ScaleKernel::AreaAverage },
+        { "jpeg 4000x3000 -> grid@2x",   QSize(4000, 3000), QSize(288, 216), false, ScaleKernel::AreaAverage },
+        { "dct 1000x750 -> grid@2x",     QSize(1000, 750),  QSize(288, 216), false, ScaleKernel::AreaAverage },
+        { "png 2048x2048 argb -> grid",  QSize(2048, 2048), QSize(108, 108), true,  ScaleKernel::AreaAverage },
+        { "frame 1920x1080 -> cover",    QSize(1920, 1080), QSize(1280, 720), false, ScaleKernel::Lanczos3 },
+        { "thumb 320x180 -> cover (up)", QSize(320, 180),   QSize(1280, 720), false, ScaleKernel::Lanczos3 },
+    };
+
+    const int runs = 15;
+    for (const Case &c : cases) {
+        const QImage src = makeTestImage(c.source, c.alpha);
+        QImage mine, qt;
+        const double mineMs = medianMs(runs, [&]() { mine = scaleImage(src, c.target, c.kernel); });
+        const double qtMs = medianMs(runs, [&]() {
+            qt = src.scaled(c.target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        });
+
+        out << QString("%1  xsm %2 ms  qt %3 ms  speedup %4x  diff %5\n")
+                   .arg(QString::fromLatin1(c.name), -30)
+                   .arg(mineMs, 7, 'f', 2)
+                   .arg(qtMs, 7, 'f', 2)
+                   .arg(mineMs > 0 ? qtMs / mineMs : 0.0, 5, 'f', 2)
+                   .arg(meanAbsDiff(mine, qt), 0, 'f', 2);
+    }
+    out.flush();
+    return 0;
+}
+
+int runProbeBenchmark(const QStringList &files)
+{
+    QTextStream out(stdout);
+    if (files.isEmpty()) {
+        out << "usage: --bench-probe <media files...>\n";
+        return 1;
+    }
+
+    for (const QString &file : files) {
+        // 图片：文件头解析 vs QImageReader 读头
+        const ImageHeaderInfo header = readImageHeader(file);
+        if (header.valid) {
+            ImageHeaderInfo h;
+            const double headerMs = medianMs(200, [&]() { h = readImageHeader(file); });
+            QSize readerSize;
+            const double readerMs = medianMs(50, [&]() { readerSize = QImageReader(file).size(); });
+
+            out << QString("%1\n  %2 %3x%4  orientation %5  (reader %6x%7)\n"
+                           "  header %8 us   QImageReader %9 us\n")
+                       .arg(QFileInfo(file).fileName())
+                       .arg(h.format)
+                       .arg(h.size.width())
+                       .arg(h.size.height())
+                       .arg(h.orientation)
+                       .arg(readerSize.width())
+                       .arg(readerSize.height())
+                       .arg(headerMs * 1000.0, 0, 'f', 1)
+                       .arg(readerMs * 1000.0, 0, 'f', 1);
+            continue;
+        }
+
+        MediaInfo info;
+        const double probeMs = medianMs(50, [&]() { info = probeMedia(file); });
+        double ffmpegDuration = 0.0;
+        const double ffmpegMs = medianMs(3, [&]() { ffmpegDuration = probeDurationSeconds(file); });
+
+        out << QString("%1\n  %2 %3 %4x%5  %6 s  %7 keyframes\n"
+                       "  native %8 us   ffmpeg %9 ms (%10 s)\n")
+                   .arg(QFileInfo(file).fileName())
+                   .arg(info.valid ? info.container : QString("unsupported"))
+                   .arg(info.videoCodec)
+                   .arg(info.resolution.width())
+                   .arg(info.resolution.height())
+                   .arg(info.durationSeconds, 0, 'f', 2)
+                   .arg(info.keyframes.size())
+                   .arg(probeMs * 1000.0, 0, 'f', 1)
+                   .arg(ffmpegMs, 0, 'f', 1)
+                   .arg(ffmpegDuration, 0, 'f', 2);
+    }
+    out.flush();
+    return 0;
+}
+
+int runRescanBenchmark(const QString &root)
+{
+    QTextStream out(stdout);
+    if (root.isEmpty() || !QFileInfo(root).isDir()) {
+        out << "usage: --bench-rescan <library folder>\n";
+        return 1;
+    }
+
+    // 完整遍历：每个目录 readdir + 每个文件 stat，同时把结果写进目录索引
+    LibraryIndex &index = LibraryIndex::instance();
+    int dirCount = 0, fileCount = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QStringList stack { QDir::cleanPath(root) };
+    while (!stack.isEmpty()) {
+        const QString dir = stack.takeLast();
+        const qint64 mtime = QFileInfo(dir).lastModified().toMSecsSinceEpoch();
+        QStringList files, subdirs;
+        const QFileInfoList entries = QDir(dir).entryInfoList(
+            QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+        for (const QFileInfo &e : entries) {
+            if (e.isDir()) {
+                subdirs << e.fileName();
+                stack << e.absoluteFilePath();
+            } else {
+                e.lastModified();   // 与爬虫一样逐个 stat
+                files << e.fileName();
+            }
+        }
+        index.update(dir, mtime, files, subdirs);
+        ++dirCount;
+        fileCount += files.size();
+    }
+    const double fullMs = timer.nsecsElapsed() / 1e6;
+
+    // 增量重扫：只 stat 目录，mtime 没变的目录沿记录的子目录往下走
+    QStringList stale;
+    const double incrementalMs = medianMs(5, [&]() { stale = index.staleDirectories(root); });
+
+    out << QString("%1 dirs, %2 files\n  full walk %3 ms   incremental %4 ms   %5 stale dirs\n"
+                   "  tree hash %6\n")
+               .arg(dirCount)
+               .arg(fileCount)
+               .arg(fullMs, 0, 'f', 1)
+               .arg(incrementalMs, 0, 'f', 1)
+               .arg(stale.size())
+               .arg(QString::fromLatin1(index.treeHash(QDir::cleanPath(root)).toHex()));
+    out.flush();
+    return 0;
+}
+
+int runStartupBenchmark(const QElapsedTimer &sinceLaunch)
+{
+    QTextStream out(stdout);
+    const QString snapshotPath = sessionSnapshotPath();
+    const bool warm = QFile::exists(snapshotPath);
+
+    // 窗口析构时会保存快照：跑完把原来的放回去，基准本身不改变下次启动的状态
+    QByteArray original;
+    if (warm) {
+        QFile f(snapshotPath);
+        if (f.open(QIODevice::ReadOnly))
+            original = f.readAll();
+    }
+
+    const double appMs = sinceLaunch.nsecsElapsed() / 1e6;
+    double constructedMs = 0.0, firstFrameMs = -1.0;
+    {
+        YouTubeStyleManager window;
+        constructedMs = sinceLaunch.nsecsElapsed() / 1e6;
+
+        QEventLoop loop;
+        FirstPaintProbe probe([&]() {
+            firstFrameMs = sinceLaunch.nsecsElapsed() / 1e6;
+            loop.quit();
+        });
+        window.findChild<QListWidget *>("contentGrid")->viewport()->installEventFilter(&probe);
+        QTimer::singleShot(10000, &loop, &QEventLoop::quit);   // 画不出来也不要一直挂着
+
+        window.show();
+        loop.exec();
+    }
+
+    if (warm) {
+        QFile f(snapshotPath);
+        if (f.open(QIODevice::WriteOnly))
+            f.write(original);
+    } else {
+        QFile::remove(snapshotPath);
+    }
+
+    const bool pass = firstFrameMs >= 0 && firstFrameMs < FirstFrameBudgetMs;
+    out << (warm ? "warm start (session snapshot)\n"
+                 : "cold start (no session snapshot, run the app and close it once for a warm start)\n");
+    // 可执行文件越大，加载和常驻内存越多；以前 ffmpeg 整个编在里面
+    out << QString("  executable %1 MB\n")
+               .arg(QFileInfo(QCoreApplication::applicationFilePath()).size() / 1048576.0, 0, 'f', 1);
+    out << QString("  QApplication %1 ms   window constructed %2 ms   first frame %3 ms   budget %4 ms   %5\n")
+               .arg(appMs, 0, 'f', 1)
+               .arg(constructedMs, 0, 'f', 1)
+               .arg(firstFrameMs, 0, 'f', 1)
+               .arg(FirstFrameBudgetMs, 0, 'f', 0)
+               .arg(pass ? "PASS" : "FAIL");
+    out.flush();
+    return pass ? 0 : 1;
+}
+
+int runFfmpegLocateBenchmark()
+{
+    QTextStream out(stdout);
+    // 只有第一次调用会真正查找 / 释放 / 校验，之后是缓存的路径
+    QElapsedTimer timer;
+    timer.start();
+    const QString path = ffmpegExecutablePath();
+    const double locateMs = timer.nsecsElapsed() / 1e6;
+
+    out << QString("ffmpeg: %1\n  located in %2 ms\n")
+               .arg(path.isEmpty() ? QString("(not found)") : path)
+               .arg(locateMs, 0, 'f', 1);
+    out.flush();
+    return path.isEmpty() ? 1 : 0;
+}
+
+int runInstanceBenchmark(const QElapsedTimer &sinceLaunch, const QString &path)
+{
+    QTextStream out(stdout);
+    if (path.isEmpty()) {
+        out << "usage: --bench-instance <folder>   (with MediaManager already running)\n";
+        return 1;
+    }
+
+    // 热路径：转给正在运行的实例，对方打开目录后才回复
+    QElapsedTimer ipcTimer;
+    ipcTimer.start();
+    if (SingleInstance::forwardToRunning(path) != SingleInstance::Forwarded) {
+        out << "no running instance to forward to; start MediaManager first\n";
+        return 1;
+    }
+    const double ipcMs = ipcTimer.nsecsElapsed() / 1e6;
+    const double forwardedMs = sinceLaunch.nsecsElapsed() / 1e6;
+
+    out << QString("reuse running instance\n  launch -> folder shown %1 ms   (ipc round trip %2 ms)\n")
+               .arg(forwardedMs, 0, 'f', 1)
+               .arg(ipcMs, 0, 'f', 1);
+    out.flush();
+
+    // 对比：另起一个进程，从启动到第一帧（子进程里跑 --bench-startup）
+    QProcess cold;
+    cold.setProcessChannelMode(QProcess::MergedChannels);
+    cold.start(QCoreApplication::applicationFilePath(), QStringList() << "--bench-startup");
+    if (cold.waitForFinished(60000)) {
+        out << "new process\n" << QString::fromLocal8Bit(cold.readAll());
+    } else {
+        cold.kill();
+        out << "new process: timed out\n";
+    }
+    out.flush();
+    return 0;
+}
+
+int runPaintBenchmark()
+{
+    QTextStream out(stdout);
+
+    // 一屏 60 个格子：视频和图片各半，都有分辨率角标，视频带时长
+    const int tiles = 60;
+    const int columns = 10;
+    QListWidget list;
+    ThumbnailDelegate delegate;
+    list.setItemDelegate(&delegate);
+    for (int i = 0; i < tiles; ++i) {
+        const bool isVideo = i % 2 == 0;
+        const QSize media = isVideo ? QSize(1920, 1080) : QSize(3000, 4000);
+        auto *item = new QListWidgetItem(QString("sample_media_file_with_a_long_name_%1.%2")
+                                             .arg(i).arg(isVideo ? "mp4" : "jpg"));
+        // mip 档位的缩略图比格子大，绘制时还要缩一次
+        item->setData(Qt::DecorationRole,
+                      QPixmap::fromImage(makeTestImage(media.scaled(QSize(512, 512), Qt::KeepAspectRatio),
+                                                       false)));
+        item->setData(Qt::UserRole, QString("/bench/%1").arg(i));
+        item->setData(Qt::UserRole + 1, isVideo);
+        item->setData(Qt::UserRole + 4, isVideo ? 125.0 + i : 0.0);
+        item->setData(Qt::UserRole + 5, media);
+        list.addItem(item);
+    }
+
+    QStyleOptionViewItem option;
+    option.initFrom(&list);
+    option.widget = &list;
+    const QSize cell = delegate.sizeHint(option, QModelIndex());
+    QImage frame(cell.width() * columns, cell.height() * ((tiles + columns - 1) / columns),
+                 QImage::Format_ARGB32_Premultiplied);
+
+    auto paintFrame = [&]() {
+        frame.fill(Qt::black);
+        QPainter painter(&frame);
+        for (int i = 0; i < tiles; ++i) {
+            option.rect = QRect(QPoint((i % columns) * cell.width(), (i / columns) * cell.height()), cell);
+            option.state = QStyle::State_Enabled;
+            delegate.paint(&painter, option, list.model()->index(i, 0));
+        }
+    };
+
+    // 冷：每帧都清空绘制缓存（相当于改动前每次都缩放、省略、拼文字）；热：滚动和悬停时的常态
+    const int runs = 30;
+    const double coldMs = medianMs(runs, [&]() { delegate.clearPaintCache(); paintFrame(); });
+    paintFrame();
+    const double warmMs = medianMs(runs, paintFrame);
+
+    out << QString("paint %1 tiles (%2x%3)\n  uncached %4 ms/frame\n  cached   %5 ms/frame   speedup %6x\n")
+               .arg(tiles).arg(cell.width()).arg(cell.height())
+               .arg(coldMs, 0, 'f', 2)
+               .arg(warmMs, 0, 'f', 2)
+               .arg(warmMs > 0 ? coldMs / warmMs : 0.0, 0, 'f', 1);
+    out.flush();
+    return 0;
+}
@@ -0,0 +1,40 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#pragma once
+#include <QString>
+#include <QStringList>
+
+class QElapsedTimer;
+
+// 命令行触发的性能基准，结果打印到标准输出，返回值作为进程退出码
+// 用法：MediaManager --bench-scaler
+//       MediaManager --bench-probe <视频或图片文件...>
+//       MediaManager --bench-rescan <媒体库目录>
+//       MediaManager --bench-startup
+//       MediaManager --bench-ffmpeg
+//       MediaManager --bench-instance <目录>   （需要已有实例在运行）
+//       MediaManager --bench-paint
+
+// 自研 SIMD 缩放 vs QImage::scaled(SmoothTransformation)
+int runScalerBenchmark();
+
+// 进程内容器解析 vs 内置 ffmpeg 读取时长；图片为文件头解析 vs QImageReader
+int runProbeBenchmark(const QStringList &files);
+
+// 完整遍历 vs 基于目录 mtime 索引的增量重扫
+int runRescanBenchmark(const QString &root);
+
+// 从进程启动到内容网格第一帧的时间（有上次会话快照时为热启动），超过 200 ms 返回失败
+int runStartupBenchmark(const QElapsedTimer &sinceLaunch);
+
+// 定位 ffmpeg 的耗时（sidecar / 系统 PATH / 从资源包释放并校验）
+int runFfmpegLocateBenchmark();
+
+// 把目录转给正在运行的实例 vs 另起一个新进程，各自从启动到看到内容的时间
+int runInstanceBenchmark(const QElapsedTimer &sinceLaunch, const QString &path);
+
+// 委托绘制 60 个可见格子的单帧耗时：不用绘制缓存 vs 使用缓存
+int runPaintBenchmark();
+
+#endif // BENCHMARKS_H
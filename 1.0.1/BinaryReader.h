@@ -0,0 +1,119 @@
+#ifndef BINARYREADER_H
+#define BINARYREADER_H
+
+#pragma once
+#include <QIODevice>
+#include <QByteArray>
+#include <QtEndian>
+
+// 文件头解析共用的小工具（MediaProbe、EmbeddedPreviewUtil、ImageHeader）：
+// 定位读取、大小端整数，以及 ISO-BMFF（MP4/MOV/HEIF）的盒子遍历。
+// 只在解析器的 .cpp 里包含，不是对外接口
+
+inline quint32 fourcc(const char *s)
+{
+    return (quint32(uchar(s[0])) << 24) | (quint32(uchar(s[1])) << 16) |
+           (quint32(uchar(s[2])) << 8) | quint32(uchar(s[3]));
+}
+
+inline bool readAt(QIODevice *dev, qint64 offset, char *buf, qint64 len)
+{
+    if (offset < 0 || !dev->seek(offset))
+        return false;
+    return dev->read(buf, len) == len;
+}
+
+inline quint16 be16(const uchar *p) { return qFromBigEndian<quint16>(p); }
+inline quint32 be32(const uchar *p) { return qFromBigEndian<quint32>(p); }
+inline quint64 be64(const uchar *p) { return qFromBigEndian<quint64>(p); }
+inline quint16 le16(const uchar *p) { return qFromLittleEndian<quint16>(p); }
+inline quint32 le32(const uchar *p) { return qFromLittleEndian<quint32>(p); }
+
+// 已经读进内存的盒子内容，调用方保证 pos 处有足够的字节
+inline quint32 be32(const QByteArray &d, int pos)
+{
+    return be32(reinterpret_cast<const uchar *>(d.constData()) + pos);
+}
+
+inline quint64 be64(const QByteArray &d, int pos)
+{
+    return be64(reinterpret_cast<const uchar *>(d.constData()) + pos);
+}
+
+// ---------------------------------------------------------
+// ISO-BMFF
+// ---------------------------------------------------------
+
+// 内存中的盒子
+struct BmffBox {
+    quint32 type = 0;
+    int payload = 0; // 相对于所在 QByteArray 的偏移
+    int end = 0;
+};
+
+// 读取 [pos, end) 中的下一个盒子并推进 pos；越界或大小不合法时返回 false
+inline bool nextBox(const QByteArray &d, int &pos, int end, BmffBox *box)
+{
+    if (pos + 8 > end)
+        return false;
+    const uchar *p = reinterpret_cast<const uchar *>(d.constData()) + pos;
+    quint64 size = be32(p);
+    int header = 8;
+    if (size == 1) {
+        if (pos + 16 > end)
+            return false;
+        size = be64(p + 8);
+        header = 16;
+    } else if (size == 0) {
+        size = quint64(end - pos);
+    }
+    if (size < quint64(header) || quint64(pos) + size > quint64(end))
+        return false;
+
+    box->type = be32(p + 4);
+    box->payload = pos + header;
+    box->end = pos + int(size);
+    pos = box->end;
+    return true;
+}
+
+inline bool findChild(const QByteArray &d, const BmffBox &parent, const char *type, BmffBox *out)
+{
+    int pos = parent.payload;
+    BmffBox b;
+    while (nextBox(d, pos, parent.end, &b)) {
+        if (b.type == fourcc(type)) {
+            *out = b;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 文件中的顶层盒子：只读 8~16 字节的头部，内容由调用方决定读还是跳过
+struct BmffBoxHeader {
+    quint32 type = 0;
+    quint64 size = 0;   // 含头部
+    int header = 0;
+};
+
+inline bool readBoxHeader(QIODevice *dev, qint64 pos, qint64 fileSize, BmffBoxHeader *box)
+{
+    uchar hdr[16];
+    if (!readAt(dev, pos, reinterpret_cast<char *>(hdr), 8))
+        return false;
+    box->size = be32(hdr);
+    box->type = be32(hdr + 4);
+    box->header = 8;
+    if (box->size == 1) {
+        if (!readAt(dev, pos + 8, reinterpret_cast<char *>(hdr + 8), 8))
+            return false;
+        box->size = be64(hdr + 8);
+        box->header = 16;
+    } else if (box->size == 0) {
+        box->size = quint64(fileSize - pos);   // 延伸到文件末尾
+    }
+    return box->size >= quint64(box->header);
+}
+
+#endif // BINARYREADER_H
@@ -0,0 +1,364 @@
+#include "DirectoryWatcher.h"
+
+#include <QThread>
+#include <QTimer>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QMetaObject>
+
+#ifdef Q_OS_LINUX
+#include <QSocketNotifier>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#else
+#include <QFileSystemWatcher>
+#endif
+
+namespace {
+
+// 第一个事件到来后等这么久再统一发出，复制大量文件时几十次变化合成一次
+const int CoalesceMs = 200;
+
+bool isUnder(const QString &path, const QString &dir)
+{
+    return path == dir || path.startsWith(dir + QLatin1Char('/'));
+}
+
+} // namespace
+
+// ---------------------------------------------------------
+// 工作对象：运行在监视线程里，所有状态只在该线程访问
+// ---------------------------------------------------------
+class WatcherWorker : public QObject {
+public:
+    explicit WatcherWorker(DirectoryWatcher *owner) : m_owner(owner) {}
+    ~WatcherWorker() override;
+
+    void init();
+    void addTree(const QString &root);
+    void setCurrentDirectory(const QString &dir);
+
+private:
+    bool inTree(const QString &path) const;
+    void markChanged(const QString &dir);
+    void flush();
+    void watchTree(const QString &root);
+    void watchDir(const QString &dir);
+    void unwatchDir(const QString &dir);
+
+#ifdef Q_OS_LINUX
+    void readEvents();
+    void unwatchTree(const QString &dir);
+    void renameTree(const QString &oldDir, const QString &newDir);
+
+    // 只关心会改变目录列表或文件内容的事件；IN_MODIFY 在写大文件时会刷屏，用 IN_CLOSE_WRITE 代替
+    static const quint32 WatchMask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_ATTRIB
+                                     | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+    struct PendingMove {
+        QString path;
+        bool isDir = false;
+    };
+
+    int m_fd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QHash<int, QString> m_wdPath;
+    QHash<QString, int> m_pathWd;
+    QHash<quint32, PendingMove> m_moves;   // cookie -> MOVED_FROM，等待配对
+    bool m_limitWarned = false;
+#else
+    QFileSystemWatcher *m_fsWatcher = nullptr;
+#endif
+
+    DirectoryWatcher *m_owner;
+    QTimer *m_flushTimer = nullptr;
+    QSet<QString> m_changed;
+    QStringList m_roots;
+    QString m_current;
+};
+
+WatcherWorker::~WatcherWorker()
+{
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0)
+        ::close(m_fd);  // 关闭 fd 会一并移除所有 watch
+#endif
+}
+
+void WatcherWorker::init()
+{
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(CoalesceMs);
+    QObject::connect(m_flushTimer, &QTimer::timeout, this, [this]() { flush(); });
+
+#ifdef Q_OS_LINUX
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        qWarning("DirectoryWatcher: inotify_init1 failed (errno %d)", errno);
+        return;
+    }
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    QObject::connect(m_notifier, &QSocketNotifier::activated, this, [this]() { readEvents(); });
+#else
+    m_fsWatcher = new QFileSystemWatcher(this);
+    QObject::connect(m_fsWatcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString &dir) {
+        const QString clean = QDir::cleanPath(dir);
+        markChanged(clean);
+        // QFileSystemWatcher 不会自动监视新建的子目录，这里补上
+        if (inTree(clean) && QFileInfo(clean).isDir()) {
+            const QFileInfoList subdirs = QDir(clean).entryInfoList(
+                QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+            for (const QFileInfo &info : subdirs)
+                watchDir(info.absoluteFilePath());
+        }
+    });
+#endif
+}
+
+bool WatcherWorker::inTree(const QString &path) const
+{
+    for (const QString &root : m_roots) {
+        if (isUnder(path, root))
+            return true;
+    }
+    return false;
+}
+
+void WatcherWorker::addTree(const QString &root)
+{
+    const QString clean = QDir::cleanPath(root);
+    if (inTree(clean))
+        return;
+    m_roots << clean;
+    watchTree(clean);
+}
+
+void WatcherWorker::setCurrentDirectory(const QString &dir)
+{
+    const QString clean = QDir::cleanPath(dir);
+    if (clean == m_current)
+        return;
+
+    // 旧目录不在任何目录树里时才需要单独移除
+    if (!m_current.isEmpty() && !inTree(m_current))
+        unwatchDir(m_current);
+    m_current = clean;
+    watchDir(clean);
+}
+
+void WatcherWorker::watchTree(const QString &root)
+{
+    watchDir(root);
+    QDirIterator it(root, QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext())
+        watchDir(QDir::cleanPath(it.next()));
+}
+
+void WatcherWorker::markChanged(const QString &dir)
+{
+    m_changed.insert(dir);
+    // 不重新计时：持续的事件风暴也会每 CoalesceMs 发出一批，不会一直憋着
+    if (!m_flushTimer->isActive())
+        m_flushTimer->start();
+}
+
+void WatcherWorker::flush()
+{
+#ifdef Q_OS_LINUX
+    // 一个合并周期内都没等到 MOVED_TO：移出了监视范围，等同于删除
+    for (const PendingMove &move : std::as_const(m_moves)) {
+        if (move.isDir)
+            unwatchTree(move.path);
+    }
+    m_moves.clear();
+#endif
+
+    if (m_changed.isEmpty())
+        return;
+    const QStringList dirs(m_changed.cbegin(), m_changed.cend());
+    m_changed.clear();
+    // 在监视线程里发出，接收方在 GUI 线程时自动排队
+    emit m_owner->directoriesChanged(dirs);
+}
+
+#ifdef Q_OS_LINUX
+
+void WatcherWorker::watchDir(const QString &dir)
+{
+    if (m_fd < 0 || m_pathWd.contains(dir))
+        return;
+
+    const int wd = inotify_add_watch(m_fd, QFile::encodeName(dir).constData(), WatchMask);
+    if (wd < 0) {
+        if (errno == ENOSPC && !m_limitWarned) {
+            m_limitWarned = true;
+            qWarning("DirectoryWatcher: inotify watch limit reached, "
+                     "raise fs.inotify.max_user_watches to watch the whole library");
+        }
+        return;
+    }
+    m_wdPath.insert(wd, dir);
+    m_pathWd.insert(dir, wd);
+}
+
+void WatcherWorker::unwatchDir(const QString &dir)
+{
+    const int wd = m_pathWd.take(dir);
+    if (wd > 0) {
+        inotify_rm_watch(m_fd, wd);
+        m_wdPath.remove(wd);
+    }
+}
+
+void WatcherWorker::unwatchTree(const QString &dir)
+{
+    const QStringList watched = m_pathWd.keys();
+    for (const QString &path : watched) {
+        if (isUnder(path, dir) && path != m_current)
+            unwatchDir(path);
+    }
+}
+
+void WatcherWorker::renameTree(const QString &oldDir, const QString &newDir)
+{
+    // watch 跟着 inode 走，改名后只需要更新路径映射
+    const QStringList watched = m_pathWd.keys();
+    for (const QString &path : watched) {
+        if (!isUnder(path, oldDir))
+            continue;
+        const int wd = m_pathWd.take(path);
+        const QString moved = newDir + path.mid(oldDir.size());
+        m_pathWd.insert(moved, wd);
+        m_wdPath.insert(wd, moved);
+    }
+}
+
+void WatcherWorker::readEvents()
+{
+    alignas(inotify_event) char buf[64 * 1024];
+    for (;;) {
+        const ssize_t len = ::read(m_fd, buf, sizeof(buf));
+        if (len <= 0)
+            break;  // EAGAIN：已读完
+
+        for (char *p = buf; p < buf + len;) {
+            const inotify_event *ev = reinterpret_cast<const inotify_event *>(p);
+            p += sizeof(inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                // 内核队列满，丢了事件：整棵树都要重扫
+                for (const QString &root : std::as_const(m_roots))
+                    emit m_owner->treeInvalidated(root);
+                if (!m_current.isEmpty() && !inTree(m_current))
+                    markChanged(m_current);
+                continue;
+            }
+
+            if (ev->mask & IN_IGNORED) {    // watch 已被内核移除（目录删除、卸载）
+                m_pathWd.remove(m_wdPath.take(ev->wd));
+                continue;
+            }
+
+            const QString dir = m_wdPath.value(ev->wd);
+            if (dir.isEmpty() || ev->len == 0)
+                continue;
+
+            const QString path = dir + QLatin1Char('/') + QFile::decodeName(ev->name);
+            const bool isDir = ev->mask & IN_ISDIR;
+            markChanged(dir);
+
+            if (ev->mask & IN_MOVED_FROM) {
+                m_moves.insert(ev->cookie, PendingMove { path, isDir });
+            } else if (ev->mask & IN_MOVED_TO) {
+                auto move = m_moves.find(ev->cookie);
+                if (move != m_moves.end()) {
+                    const QString oldPath = move->path;
+                    m_moves.erase(move);
+                    emit m_owner->pathRenamed(oldPath, path);
+                    if (isDir) {
+                        renameTree(oldPath, path);
+                        if (!inTree(path))
+                            unwatchTree(path);
+                    }
+                }
+                // 从监视范围外移进来的目录树：补上 watch，里面的文件当作新增
+                if (isDir && inTree(path) && !m_pathWd.contains(path)) {
+                    watchTree(path);
+                    markChanged(path);
+                }
+            } else if ((ev->mask & IN_CREATE) && isDir && inTree(path)) {
+                // 新建目录：加 watch 之前可能已经有文件写进去了，加完后把它标成变化
+                watchTree(path);
+                markChanged(path);
+            }
+        }
+    }
+}
+
+#else // !Q_OS_LINUX
+
+void WatcherWorker::watchDir(const QString &dir)
+{
+    if (m_fsWatcher && !m_fsWatcher->directories().contains(dir))
+        m_fsWatcher->addPath(dir);
+}
+
+void WatcherWorker::unwatchDir(const QString &dir)
+{
+    if (m_fsWatcher)
+        m_fsWatcher->removePath(dir);
+}
+
+#endif
+
+// ---------------------------------------------------------
+// DirectoryWatcher
+// ---------------------------------------------------------
+DirectoryWatcher::DirectoryWatcher(QObject *parent)
+    : QObject(parent)
+{
+    m_thread = new QThread(this);
+    m_thread->setObjectName("DirectoryWatcher");
+    m_worker = new WatcherWorker(this);
+    m_worker->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread->start(QThread::LowPriority);
+
+    WatcherWorker *worker = m_worker;
+    QMetaObject::invokeMethod(m_worker, [worker]() { worker->init(); });
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+    // 先停线程，保证工作对象不会再往已析构的 this 上发信号
+    m_thread->quit();
+    m_thread->wait();
+}
+
+void DirectoryWatcher::addTree(const QString &root)
+{
+    WatcherWorker *worker = m_worker;
+    QMetaObject::invokeMethod(m_worker, [worker, root]() { worker->addTree(root); });
+}
+
+void DirectoryWatcher::setCurrentDirectory(const QString &dir)
+{
+    WatcherWorker *worker = m_worker;
+    QMetaObject::invokeMethod(m_worker, [worker, dir]() { worker->setCurrentDirectory(dir); });
+}
+
+QString DirectoryWatcher::backendName()
+{
+#ifdef Q_OS_LINUX
+    return "inotify";
+#else
+    return "QFileSystemWatcher";
+#endif
+}
@@ -0,0 +1,43 @@
+#ifndef DIRECTORYWATCHER_H
+#define DIRECTORYWATCHER_H
+
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QThread;
+class WatcherWorker;
+
+// 目录监视服务：整棵媒体库目录树 + 当前浏览的目录
+// Linux 下直接用 inotify（每个目录一个 watch，新建的子目录自动加入），
+// 其他平台退回 QFileSystemWatcher。监视和事件处理都在单独的线程里，
+// 短时间内的大量事件合并成一次 directoriesChanged
+class DirectoryWatcher : public QObject {
+    Q_OBJECT
+public:
+    explicit DirectoryWatcher(QObject *parent = nullptr);
+    ~DirectoryWatcher() override;
+
+    // 递归监视整棵目录树（媒体库根目录）
+    void addTree(const QString &root);
+    // 单独监视一个目录，不递归；再次调用会替换上一次的目录
+    void setCurrentDirectory(const QString &dir);
+
+    // "inotify" 或 "QFileSystemWatcher"
+    static QString backendName();
+
+signals:
+    // 合并后的变化目录（直接子项有增删改），不含子目录
+    void directoriesChanged(const QStringList &dirs);
+    // 事件丢失（inotify 队列溢出）：这棵树里什么都可能变了，需要递归重扫
+    void treeInvalidated(const QString &root);
+    // 同一次 rename 的 MOVED_FROM / MOVED_TO（按 cookie 配对），文件和目录都会报
+    void pathRenamed(const QString &oldPath, const QString &newPath);
+
+private:
+    QThread *m_thread = nullptr;
+    WatcherWorker *m_worker = nullptr;
+};
+
+#endif // DIRECTORYWATCHER_H
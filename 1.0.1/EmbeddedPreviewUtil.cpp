@@ -0,0 +1,856 @@
+#include "EmbeddedPreviewUtil.h"
+#include "MediaProbe.h"
+#include "BinaryReader.h"
+#include "ImageScaler.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QBuffer>
+#include <QByteArray>
+#include <QImageReader>
+#include <QTransform>
+#include <QVector>
+#include <QSet>
+#include <QtEndian>
+
+namespace {
+
+// 单个容器最多访问的 IFD 数量，防止损坏文件造成死循环
+const int MaxIfdCount = 64;
+// HEIF 的 meta 盒子一般只有几十 KB，超过这个值视为异常文件
+const qint64 MaxMetaBoxSize = 4 * 1024 * 1024;
+
+// ---------------------------------------------------------
+// JPEG：只扫描标记段，确认是 Qt 可解码的 JPEG 并拿到尺寸
+// ---------------------------------------------------------
+bool probeJpeg(QIODevice *dev, qint64 offset, qint64 length, QSize *dims)
+{
+    uchar buf[9];
+    if (length < 4 || !readAt(dev, offset, reinterpret_cast<char *>(buf), 2))
+        return false;
+    if (buf[0] != 0xFF || buf[1] != 0xD8)
+        return false;
+
+    qint64 pos = offset + 2;
+    const qint64 end = offset + length;
+    for (int i = 0; i < 64 && pos + 4 <= end; ++i) {
+        if (!readAt(dev, pos, reinterpret_cast<char *>(buf), 4) || buf[0] != 0xFF)
+            return false;
+
+        const uchar marker = buf[1];
+        const int segLen = qFromBigEndian<quint16>(buf + 2);
+
+        // SOF0/1/2：基线、扩展、渐进式 —— Qt 的 jpeg 插件都能解
+        if (marker == 0xC0 || marker == 0xC1 || marker == 0xC2) {
+            if (!readAt(dev, pos + 4, reinterpret_cast<char *>(buf), 5))
+                return false;
+            const int h = qFromBigEndian<quint16>(buf + 1);
+            const int w = qFromBigEndian<quint16>(buf + 3);
+            if (w <= 0 || h <= 0)
+                return false;
+            if (dims)
+                *dims = QSize(w, h);
+            return true;
+        }
+        // 无损 JPEG（RAW 传感器数据常用）、算术编码，或在 SOF 之前就遇到了 SOS
+        if ((marker >= 0xC3 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+            || marker == 0xDA)
+            return false;
+
+        pos += 2 + segLen;
+    }
+    return false;
+}
+
+struct PreviewCandidate {
+    qint64 offset = 0;
+    qint64 length = 0;
+    QSize size;
+};
+
+// 从候选中挑选：不小于目标尺寸的最小者；都不够大则取最大的
+const PreviewCandidate *pickCandidate(const QVector<PreviewCandidate> &list, const QSize &target)
+{
+    const PreviewCandidate *best = nullptr;
+    const PreviewCandidate *largest = nullptr;
+    for (const PreviewCandidate &c : list) {
+        const qint64 area = qint64(c.size.width()) * c.size.height();
+        if (!largest || area > qint64(largest->size.width()) * largest->size.height())
+            largest = &c;
+
+        const bool coversTarget = c.size.width() >= target.width() || c.size.height() >= target.height();
+        if (coversTarget &&
+            (!best || area < qint64(best->size.width()) * best->size.height()))
+            best = &c;
+    }
+    return best ? best : largest;
+}
+
+QImage decodeJpegRange(QIODevice *dev, const PreviewCandidate &c, const QSize &target)
+{
+    if (!dev->seek(c.offset))
+        return QImage();
+    QByteArray data = dev->read(c.length);
+    if (data.size() != c.length)
+        return QImage();
+
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer, "jpeg");
+    // 方向由容器的 Orientation 统一处理，预览自带的 EXIF 不再重复旋转
+    reader.setAutoTransform(false);
+
+    const QSize size = reader.size().isValid() ? reader.size() : c.size;
+    if (size.width() > target.width() || size.height() > target.height())
+        reader.setScaledSize(size.scaled(target, Qt::KeepAspectRatio));
+    return reader.read();
+}
+
+// ---------------------------------------------------------
+// TIFF / EXIF：遍历 IFD 链与 SubIFD，收集 JPEG 预览
+// ---------------------------------------------------------
+class TiffWalker {
+public:
+    TiffWalker(QIODevice *dev, qint64 base) : m_dev(dev), m_base(base) {}
+
+    bool init()
+    {
+        uchar hdr[8];
+        if (!readAt(m_dev, m_base, reinterpret_cast<char *>(hdr), 8))
+            return false;
+        if (hdr[0] == 'I' && hdr[1] == 'I')
+            m_little = true;
+        else if (hdr[0] == 'M' && hdr[1] == 'M')
+            m_little = false;
+        else
+            return false;
+
+        // 42 为标准 TIFF；ORF 用 0x4F52/0x5352，RW2 用 0x55
+        const quint16 magic = u16(hdr + 2);
+        if (magic != 42 && magic != 0x4F52 && magic != 0x5352 && magic != 0x55)
+            return false;
+
+        m_firstIfd = u32(hdr + 4);
+        return true;
+    }
+
+    // 收集所有可用的 JPEG 预览，并返回 IFD0 的 Orientation
+    void collect(QVector<PreviewCandidate> *out, int *orientation)
+    {
+        QVector<quint32> pending;
+        pending << m_firstIfd;
+        QSet<quint32> visited;
+        bool first = true;
+
+        while (!pending.isEmpty() && visited.size() < MaxIfdCount) {
+            const quint32 ifdOffset = pending.takeFirst();
+            if (ifdOffset == 0 || visited.contains(ifdOffset))
+                continue;
+            visited.insert(ifdOffset);
+
+            Ifd ifd;
+            if (!readIfd(ifdOffset, &ifd))
+                continue;
+
+            if (first && orientation && ifd.orientation > 0)
+                *orientation = int(ifd.orientation);
+            first = false;
+
+            if (ifd.jpegOffset > 0 && ifd.jpegLength > 0)
+                addCandidate(m_base + ifd.jpegOffset, ifd.jpegLength, out);
+
+            // CR2 的 IFD0、DNG 的 SubIFD 预览用“单条带 + JPEG 压缩”存放；
+            // 原始传感器数据同样可能是 6/7 压缩，但它是无损 JPEG，会在 probeJpeg 中被剔除
+            if ((ifd.compression == 6 || ifd.compression == 7) &&
+                ifd.stripOffsets.size() == 1 && ifd.stripCounts.size() == 1)
+                addCandidate(m_base + ifd.stripOffsets.first(), ifd.stripCounts.first(), out);
+
+            pending << ifd.subIfds;
+            pending << ifd.next;
+        }
+    }
+
+    // 只读 IFD0 的 Orientation，缺省为 1
+    int orientation()
+    {
+        Ifd ifd;
+        if (!readIfd(m_firstIfd, &ifd) || ifd.orientation == 0 || ifd.orientation > 8)
+            return 1;
+        return int(ifd.orientation);
+    }
+
+private:
+    struct Ifd {
+        quint32 compression = 0;
+        quint32 orientation = 0;
+        quint32 jpegOffset = 0;
+        quint32 jpegLength = 0;
+        QVector<quint32> stripOffsets;
+        QVector<quint32> stripCounts;
+        QVector<quint32> subIfds;
+        quint32 next = 0;
+    };
+
+    quint16 u16(const uchar *p) const
+    {
+        return m_little ? qFromLittleEndian<quint16>(p) : qFromBigEndian<quint16>(p);
+    }
+    quint32 u32(const uchar *p) const
+    {
+        return m_little ? qFromLittleEndian<quint32>(p) : qFromBigEndian<quint32>(p);
+    }
+
+    // 读取一个条目的整型数组值（SHORT/LONG/IFD），最多 maxCount 个
+    QVector<quint32> values(const uchar *entry, int maxCount)
+    {
+        QVector<quint32> result;
+        const quint16 type = u16(entry + 2);
+        const quint32 count = u32(entry + 4);
+        int unit = 0;
+        if (type == 3)
+            unit = 2;
+        else if (type == 4 || type == 13)
+            unit = 4;
+        if (unit == 0 || count == 0 || count > quint32(maxCount))
+            return result;
+
+        QByteArray raw;
+        const quint32 total = count * unit;
+        if (total <= 4) {
+            raw = QByteArray(reinterpret_cast<const char *>(entry + 8), 4);
+        } else {
+            raw.resize(total);
+            if (!readAt(m_dev, m_base + u32(entry + 8), raw.data(), total))
+                return result;
+        }
+
+        const uchar *p = reinterpret_cast<const uchar *>(raw.constData());
+        for (quint32 i = 0; i < count; ++i)
+            result << (unit == 2 ? u16(p + i * 2) : u32(p + i * 4));
+        return result;
+    }
+
+    bool readIfd(quint32 offset, Ifd *ifd)
+    {
+        uchar countBuf[2];
+        if (!readAt(m_dev, m_base + offset, reinterpret_cast<char *>(countBuf), 2))
+            return false;
+        const int count = u16(countBuf);
+        if (count <= 0 || count > 1000)
+            return false;
+
+        QByteArray entries(count * 12 + 4, Qt::Uninitialized);
+        if (!readAt(m_dev, m_base + offset + 2, entries.data(), entries.size()))
+            return false;
+
+        const uchar *p = reinterpret_cast<const uchar *>(entries.constData());
+        for (int i = 0; i < count; ++i) {
+            const uchar *e = p + i * 12;
+            switch (u16(e)) {
+            case 0x0103: // Compression
+                ifd->compression = values(e, 1).value(0);
+                break;
+            case 0x0111: // StripOffsets
+                ifd->stripOffsets = values(e, 4096);
+                break;
+            case 0x0112: // Orientation
+                ifd->orientation = values(e, 1).value(0);
+                break;
+            case 0x0117: // StripByteCounts
+                ifd->stripCounts = values(e, 4096);
+                break;
+            case 0x014A: // SubIFDs
+                ifd->subIfds = values(e, 16);
+                break;
+            case 0x0201: // JPEGInterchangeFormat
+                ifd->jpegOffset = values(e, 1).value(0);
+                break;
+            case 0x0202: // JPEGInterchangeFormatLength
+                ifd->jpegLength = values(e, 1).value(0);
+                break;
+            default:
+                break;
+            }
+        }
+        ifd->next = u32(p + count * 12);
+        return true;
+    }
+
+    void addCandidate(qint64 offset, qint64 length, QVector<PreviewCandidate> *out)
+    {
+        PreviewCandidate c;
+        c.offset = offset;
+        c.length = length;
+        if (probeJpeg(m_dev, offset, length, &c.size))
+            out->append(c);
+    }
+
+    QIODevice *m_dev;
+    qint64 m_base;
+    bool m_little = true;
+    quint32 m_firstIfd = 0;
+};
+
+QImage loadRawPreview(QFile &file, const QSize &target)
+{
+    QVector<PreviewCandidate> candidates;
+    int orientation = 1;
+
+    char magic[16];
+    if (!readAt(&file, 0, magic, 16))
+        return QImage();
+
+    if (QByteArray(magic, 15) == "FUJIFILMCCD-RAW") {
+        // RAF：固定头部第 84 字节处记录内嵌 JPEG 的偏移与长度（大端）
+        uchar loc[8];
+        if (!readAt(&file, 84, reinterpret_cast<char *>(loc), 8))
+            return QImage();
+        PreviewCandidate c;
+        c.offset = qFromBigEndian<quint32>(loc);
+        c.length = qFromBigEndian<quint32>(loc + 4);
+        if (probeJpeg(&file, c.offset, c.length, &c.size))
+            candidates << c;
+        // 方向信息保存在预览 JPEG 自身的 EXIF 里
+        orientation = 0;
+    } else {
+        TiffWalker walker(&file, 0);
+        if (!walker.init())
+            return QImage();
+        walker.collect(&candidates, &orientation);
+    }
+
+    const PreviewCandidate *best = pickCandidate(candidates, target);
+    if (!best)
+        return QImage();
+
+    if (orientation == 0) {
+        // 交给 QImageReader 读预览自带的 EXIF 方向
+        if (!file.seek(best->offset))
+            return QImage();
+        QByteArray data = file.read(best->length);
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        QImageReader reader(&buffer, "jpeg");
+        reader.setAutoTransform(true);
+        const QSize size = reader.size();
+        if (size.isValid() && (size.width() > target.width() || size.height() > target.height()))
+            reader.setScaledSize(size.scaled(target, Qt::KeepAspectRatio));
+        return reader.read();
+    }
+
+    return applyExifOrientation(decodeJpegRange(&file, *best, target), orientation);
+}
+
+// ---------------------------------------------------------
+// HEIF：解析 meta 盒子（iinf/iloc/iref/iprp），定位 thmb 与 Exif 项
+// ---------------------------------------------------------
+// 按字段宽度（0/2/4/8 字节）读取大端整数，并推进游标
+quint64 readSized(const QByteArray &d, int &pos, int bytes, int end, bool *ok)
+{
+    if (bytes == 0)
+        return 0;
+    if (pos + bytes > end) {
+        *ok = false;
+        return 0;
+    }
+    const uchar *p = reinterpret_cast<const uchar *>(d.constData()) + pos;
+    pos += bytes;
+    switch (bytes) {
+    case 2: return qFromBigEndian<quint16>(p);
+    case 4: return qFromBigEndian<quint32>(p);
+    case 8: return qFromBigEndian<quint64>(p);
+    default:
+        *ok = false;
+        return 0;
+    }
+}
+
+struct HeifItem {
+    quint32 id = 0;
+    quint32 type = 0;
+    int constructionMethod = 0;
+    quint64 baseOffset = 0;
+    QVector<QPair<quint64, quint64>> extents; // (offset, length)
+    QVector<int> properties;                  // ipco 中的属性序号（从 1 开始）
+};
+
+struct HeifMeta {
+    QByteArray data;        // meta 盒子的原始字节
+    qint64 fileOffset = 0;  // meta 盒子在文件中的起始位置
+    quint32 primaryId = 0;
+    QVector<HeifItem> items;
+    QVector<QPair<quint32, quint32>> thumbRefs; // (缩略图项, 主图项)
+    QVector<BmffBox> properties;                    // ipco 中按顺序排列的属性
+    BmffBox idat;
+
+    HeifItem *item(quint32 id)
+    {
+        for (HeifItem &it : items) {
+            if (it.id == id)
+                return &it;
+        }
+        return nullptr;
+    }
+};
+
+bool parseIinf(HeifMeta &meta, const BmffBox &box)
+{
+    const QByteArray &d = meta.data;
+    int pos = box.payload;
+    bool ok = true;
+    const int version = pos < box.end ? uchar(d[pos]) : 0;
+    pos += 4;
+    readSized(d, pos, version == 0 ? 2 : 4, box.end, &ok);
+    if (!ok)
+        return false;
+
+    BmffBox infe;
+    while (nextBox(d, pos, box.end, &infe)) {
+        if (infe.type != fourcc("infe"))
+            continue;
+        int p = infe.payload;
+        const int v = p < infe.end ? uchar(d[p]) : 0;
+        p += 4;
+        if (v < 2)
+            continue;
+        HeifItem item;
+        item.id = quint32(readSized(d, p, v == 2 ? 2 : 4, infe.end, &ok));
+        readSized(d, p, 2, infe.end, &ok); // item_protection_index
+        item.type = quint32(readSized(d, p, 4, infe.end, &ok));
+        if (!ok)
+            return false;
+        if (HeifItem *existing = meta.item(item.id))
+            existing->type = item.type;
+        else
+            meta.items << item;
+    }
+    return true;
+}
+
+bool parseIloc(HeifMeta &meta, const BmffBox &box)
+{
+    const QByteArray &d = meta.data;
+    int pos = box.payload;
+    if (pos + 6 > box.end)
+        return false;
+    const int version = uchar(d[pos]);
+    pos += 4;
+    const int offsetSize = uchar(d[pos]) >> 4;
+    const int lengthSize = uchar(d[pos]) & 0x0F;
+    const int baseOffsetSize = uchar(d[pos + 1]) >> 4;
+    const int indexSize = (version == 1 || version == 2) ? (uchar(d[pos + 1]) & 0x0F) : 0;
+    pos += 2;
+
+    bool ok = true;
+    const quint64 itemCount = readSized(d, pos, version < 2 ? 2 : 4, box.end, &ok);
+    for (quint64 i = 0; ok && i < itemCount; ++i) {
+        const quint32 id = quint32(readSized(d, pos, version < 2 ? 2 : 4, box.end, &ok));
+        int method = 0;
+        if (version == 1 || version == 2)
+            method = int(readSized(d, pos, 2, box.end, &ok) & 0x0F);
+        readSized(d, pos, 2, box.end, &ok); // data_reference_index
+        const quint64 base = readSized(d, pos, baseOffsetSize, box.end, &ok);
+        const quint64 extentCount = readSized(d, pos, 2, box.end, &ok);
+
+        QVector<QPair<quint64, quint64>> extents;
+        for (quint64 e = 0; ok && e < extentCount; ++e) {
+            readSized(d, pos, indexSize, box.end, &ok);
+            const quint64 off = readSized(d, pos, offsetSize, box.end, &ok);
+            const quint64 len = readSized(d, pos, lengthSize, box.end, &ok);
+            extents << qMakePair(off, len);
+        }
+        if (!ok)
+            return false;
+
+        HeifItem *item = meta.item(id);
+        if (!item) {
+            meta.items << HeifItem();
+            item = &meta.items.last();
+            item->id = id;
+        }
+        item->constructionMethod = method;
+        item->baseOffset = base;
+        item->extents = extents;
+    }
+    return ok;
+}
+
+bool parseIref(HeifMeta &meta, const BmffBox &box)
+{
+    const QByteArray &d = meta.data;
+    int pos = box.payload;
+    const int version = pos < box.end ? uchar(d[pos]) : 0;
+    pos += 4;
+    bool ok = true;
+
+    BmffBox ref;
+    while (nextBox(d, pos, box.end, &ref)) {
+        int p = ref.payload;
+        const quint32 from = quint32(readSized(d, p, version == 0 ? 2 : 4, ref.end, &ok));
+        const quint64 count = readSized(d, p, 2, ref.end, &ok);
+        for (quint64 i = 0; ok && i < count; ++i) {
+            const quint32 to = quint32(readSized(d, p, version == 0 ? 2 : 4, ref.end, &ok));
+            if (ok && ref.type == fourcc("thmb"))
+                meta.thumbRefs << qMakePair(from, to);
+        }
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+bool parseIprp(HeifMeta &meta, const BmffBox &box)
+{
+    const QByteArray &d = meta.data;
+    int pos = box.payload;
+    bool ok = true;
+
+    BmffBox child;
+    while (nextBox(d, pos, box.end, &child)) {
+        if (child.type == fourcc("ipco")) {
+            int p = child.payload;
+            BmffBox prop;
+            while (nextBox(d, p, child.end, &prop))
+                meta.properties << prop;
+        } else if (child.type == fourcc("ipma")) {
+            int p = child.payload;
+            if (p + 4 > child.end)
+                return false;
+            const int version = uchar(d[p]);
+            const bool wideIndex = (uchar(d[p + 3]) & 0x01) != 0;
+            p += 4;
+            const quint64 entryCount = readSized(d, p, 4, child.end, &ok);
+            for (quint64 i = 0; ok && i < entryCount; ++i) {
+                const quint32 id = quint32(readSized(d, p, version < 1 ? 2 : 4, child.end, &ok));
+                if (p >= child.end) {
+                    ok = false;
+                    break;
+                }
+                const int assocCount = uchar(d[p++]);
+                QVector<int> props;
+                for (int a = 0; ok && a < assocCount; ++a) {
+                    // 最高位是 essential 标志，其余为属性序号
+                    int index = 0;
+                    if (wideIndex) {
+                        index = int(readSized(d, p, 2, child.end, &ok) & 0x7FFF);
+                    } else if (p < child.end) {
+                        index = uchar(d[p++]) & 0x7F;
+                    } else {
+                        ok = false;
+                    }
+                    if (index > 0)
+                        props << index;
+                }
+                if (HeifItem *item = meta.item(id))
+                    item->properties = props;
+            }
+        }
+    }
+    return ok;
+}
+
+bool loadHeifMeta(QFile &file, HeifMeta *meta)
+{
+    // 顶层盒子只读 16 字节头部后跳过，直到找到 meta
+    qint64 pos = 0;
+    const qint64 fileSize = file.size();
+    bool sawFtyp = false;
+    for (int i = 0; i < 64 && pos + 8 <= fileSize; ++i) {
+        BmffBoxHeader box;
+        if (!readBoxHeader(&file, pos, fileSize, &box))
+            return false;
+        const quint32 type = box.type;
+        const quint64 size = box.size;
+        const int header = box.header;
+
+        if (type == fourcc("ftyp")) {
+            sawFtyp = true;
+        } else if (type == fourcc("meta")) {
+            if (!sawFtyp || size > quint64(MaxMetaBoxSize))
+                return false;
+            if (!file.seek(pos + header))
+                return false;
+            meta->data = file.read(qint64(size) - header);
+            meta->fileOffset = pos + header;
+            return meta->data.size() == qint64(size) - header;
+        }
+        pos += qint64(size);
+    }
+    return false;
+}
+
+bool parseHeif(QFile &file, HeifMeta *meta)
+{
+    if (!loadHeifMeta(file, meta))
+        return false;
+
+    const QByteArray &d = meta->data;
+    int pos = 4; // meta 是 FullBox
+    const int end = d.size();
+    bool ok = true;
+
+    BmffBox box;
+    while (ok && nextBox(d, pos, end, &box)) {
+        if (box.type == fourcc("pitm")) {
+            int p = box.payload;
+            const int version = p < box.end ? uchar(d[p]) : 0;
+            p += 4;
+            meta->primaryId = quint32(readSized(d, p, version == 0 ? 2 : 4, box.end, &ok));
+        } else if (box.type == fourcc("iinf")) {
+            ok = parseIinf(*meta, box);
+        } else if (box.type == fourcc("iloc")) {
+            ok = parseIloc(*meta, box);
+        } else if (box.type == fourcc("iref")) {
+            ok = parseIref(*meta, box);
+        } else if (box.type == fourcc("iprp")) {
+            ok = parseIprp(*meta, box);
+        } else if (box.type == fourcc("idat")) {
+            meta->idat = box;
+        }
+    }
+    return ok && !meta->items.isEmpty();
+}
+
+// 读取某个项的完整数据（支持文件偏移与 idat 两种构造方式）
+QByteArray readItemData(QFile &file, const HeifMeta &meta, const HeifItem &item, qint64 limit)
+{
+    QByteArray out;
+    for (const auto &extent : item.extents) {
+        const quint64 offset = item.baseOffset + extent.first;
+        quint64 length = extent.second;
+        if (item.constructionMethod == 0) {
+            if (length == 0)
+                length = quint64(file.size()) - offset;
+            if (qint64(out.size() + length) > limit || !file.seek(qint64(offset)))
+                return QByteArray();
+            out += file.read(qint64(length));
+        } else if (item.constructionMethod == 1 && meta.idat.type != 0) {
+            const quint64 begin = quint64(meta.idat.payload) + offset;
+            if (begin + length > quint64(meta.idat.end))
+                return QByteArray();
+            out += meta.data.mid(int(begin), int(length));
+        } else {
+            return QByteArray();
+        }
+    }
+    return out;
+}
+
+const HeifItem *findThumbnail(HeifMeta &meta, quint32 type)
+{
+    for (const auto &ref : meta.thumbRefs) {
+        if (meta.primaryId != 0 && ref.second != meta.primaryId)
+            continue;
+        const HeifItem *item = meta.item(ref.first);
+        if (item && item->type == type)
+            return item;
+    }
+    return nullptr;
+}
+
+QImage decodeJpegBytes(QByteArray data, const QSize &target, int orientation)
+{
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer, "jpeg");
+    reader.setAutoTransform(false);
+    const QSize size = reader.size();
+    if (size.isValid() && (size.width() > target.width() || size.height() > target.height()))
+        reader.setScaledSize(size.scaled(target, Qt::KeepAspectRatio));
+    return applyExifOrientation(reader.read(), orientation);
+}
+
+QImage loadHeifPreview(QFile &file, const QSize &target)
+{
+    HeifMeta meta;
+    if (!parseHeif(file, &meta))
+        return QImage();
+
+    // 1. JPEG 编码的 thmb 缩略图（部分相机会这样写）
+    if (const HeifItem *thumb = findThumbnail(meta, fourcc("jpeg"))) {
+        const QImage img = decodeJpegBytes(readItemData(file, meta, *thumb, 8 * 1024 * 1024),
+                                           target, 1);
+        if (!img.isNull())
+            return img;
+    }
+
+    // 2. Exif 项中的 IFD1 JPEG 缩略图
+    for (const HeifItem &item : meta.items) {
+        if (item.type != fourcc("Exif") || item.constructionMethod != 0 || item.extents.size() != 1)
+            continue;
+
+        // Exif 项开头 4 字节是到 TIFF 头的偏移
+        const qint64 start = qint64(item.baseOffset + item.extents.first().first);
+        uchar skip[4];
+        if (!readAt(&file, start, reinterpret_cast<char *>(skip), 4))
+            continue;
+
+        TiffWalker walker(&file, start + 4 + qFromBigEndian<quint32>(skip));
+        if (!walker.init())
+            continue;
+        QVector<PreviewCandidate> candidates;
+        int orientation = 1;
+        walker.collect(&candidates, &orientation);
+        if (const PreviewCandidate *best = pickCandidate(candidates, target))
+            return applyExifOrientation(decodeJpegRange(&file, *best, target), orientation);
+    }
+    return QImage();
+}
+
+} // namespace
+
+bool isRawSuffix(const QString &suffix)
+{
+    return (suffix == "cr2" || suffix == "nef" || suffix == "nrw" || suffix == "arw" ||
+            suffix == "sr2" || suffix == "dng" || suffix == "orf" || suffix == "rw2" ||
+            suffix == "pef" || suffix == "raf");
+}
+
+bool isHeifSuffix(const QString &suffix)
+{
+    return (suffix == "heic" || suffix == "heif" || suffix == "hif");
+}
+
+QImage applyExifOrientation(const QImage &img, int orientation)
+{
+    if (img.isNull())
+        return img;
+
+    QTransform t;
+    switch (orientation) {
+    case 2: return img.mirrored(true, false);
+    case 3: t.rotate(180); break;
+    case 4: return img.mirrored(false, true);
+    case 5: t.rotate(90); return img.transformed(t).mirrored(true, false);
+    case 6: t.rotate(90); break;
+    case 7: t.rotate(-90); return img.transformed(t).mirrored(true, false);
+    case 8: t.rotate(-90); break;
+    default: return img;
+    }
+    return img.transformed(t);
+}
+
+int exifOrientation(const QByteArray &exif)
+{
+    // APP1 负载以 "Exif\0\0" 开头，其后是完整的 TIFF 结构
+    if (!exif.startsWith(QByteArray("Exif\0\0", 6)))
+        return 1;
+
+    QByteArray data = exif;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    TiffWalker walker(&buffer, 6);
+    return walker.init() ? walker.orientation() : 1;
+}
+
+QImage loadEmbeddedPreview(const QString &path, const QSize &targetSize)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QImage();
+
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    if (isRawSuffix(suffix))
+        return loadRawPreview(file, targetSize);
+    if (isHeifSuffix(suffix))
+        return loadHeifPreview(file, targetSize);
+    return QImage();
+}
+
+bool writeHeifThumbnailStream(const QString &path, const QString &outFile)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    HeifMeta meta;
+    if (!parseHeif(file, &meta))
+        return false;
+
+    const HeifItem *thumb = findThumbnail(meta, fourcc("hvc1"));
+    if (!thumb)
+        return false;
+
+    // 找到缩略图项关联的 hvcC 属性（VPS/SPS/PPS 参数集）
+    const BmffBox *hvcC = nullptr;
+    for (int index : thumb->properties) {
+        if (index <= meta.properties.size() && meta.properties[index - 1].type == fourcc("hvcC")) {
+            hvcC = &meta.properties[index - 1];
+            break;
+        }
+    }
+    if (!hvcC)
+        return false;
+
+    const QByteArray &d = meta.data;
+    const QByteArray startCode("\x00\x00\x00\x01", 4);
+    QByteArray stream;
+
+    // hvcC：22 字节固定头，第 21 字节低 2 位为 NAL 长度字段字节数 - 1，随后是参数集数组
+    int pos = hvcC->payload;
+    if (pos + 23 > hvcC->end)
+        return false;
+    const int lengthSize = (uchar(d[pos + 21]) & 0x03) + 1;
+    const int arrayCount = uchar(d[pos + 22]);
+    pos += 23;
+    bool ok = true;
+    for (int a = 0; ok && a < arrayCount; ++a) {
+        pos += 1; // array_completeness + NAL_unit_type
+        const quint64 nalCount = readSized(d, pos, 2, hvcC->end, &ok);
+        for (quint64 n = 0; ok && n < nalCount; ++n) {
+            const int len = int(readSized(d, pos, 2, hvcC->end, &ok));
+            if (!ok || pos + len > hvcC->end)
+                return false;
+            stream += startCode;
+            stream += d.mid(pos, len);
+            pos += len;
+        }
+    }
+    if (!ok)
+        return false;
+
+    // 缩略图数据：长度前缀的 NAL 序列，逐个替换为起始码
+    const QByteArray sample = readItemData(file, meta, *thumb, 8 * 1024 * 1024);
+    int p = 0;
+    while (p + lengthSize <= sample.size()) {
+        quint32 len = 0;
+        for (int i = 0; i < lengthSize; ++i)
+            len = (len << 8) | uchar(sample[p + i]);
+        p += lengthSize;
+        if (len == 0 || p + int(len) > sample.size())
+            return false;
+        stream += startCode;
+        stream += sample.mid(p, int(len));
+        p += int(len);
+    }
+    if (p == 0)
+        return false;
+
+    QFile out(outFile);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    return out.write(stream) == stream.size();
+}
+
+QImage loadVideoCoverArt(const QString &path, const QSize &targetSize)
+{
+    QByteArray data = extractCoverArt(path);
+    if (data.isEmpty())
+        return QImage();
+
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer); // JPEG 或 PNG，按内容识别
+    reader.setAutoTransform(true);
+
+    // JPEG 先用 DCT 缩放粗缩，最后统一交给 SIMD 缩放
+    const QSize size = reader.size();
+    const bool tooLarge = size.width() > targetSize.width() || size.height() > targetSize.height();
+    if (reader.format() == "jpeg" && size.isValid() && tooLarge)
+        reader.setScaledSize(size.scaled(targetSize, Qt::KeepAspectRatio));
+
+    const QImage img = reader.read();
+    if (img.width() > targetSize.width() || img.height() > targetSize.height())
+        return scaleImage(img, targetSize, Qt::KeepAspectRatio);
+    return img;
+}
@@ -0,0 +1,36 @@
+#ifndef EMBEDDEDPREVIEWUTIL_H
+#define EMBEDDEDPREVIEWUTIL_H
+
+#pragma once
+#include <QString>
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+
+// RAW（CR2/NEF/ARW/DNG 等 TIFF 结构，以及 RAF）与 HEIF/HEIC 内嵌预览图提取
+// 只解析容器结构并解码相机写入的预览 JPEG，不做传感器数据解码，也不启动子进程
+
+bool isRawSuffix(const QString &suffix);
+bool isHeifSuffix(const QString &suffix);
+
+// 按 EXIF Orientation (1~8) 旋转/镜像图片
+QImage applyExifOrientation(const QImage &img, int orientation);
+
+// 从 JPEG APP1 段（以 "Exif\0\0" 开头）中读取 Orientation，缺省返回 1
+int exifOrientation(const QByteArray &exif);
+
+// 读取内嵌预览并缩放到 targetSize 以内（保持比例）；找不到可用预览时返回空图
+// RAW：在所有 IFD / SubIFD 中挑选“刚好不小于目标尺寸”的 JPEG 预览
+// HEIF：优先使用 JPEG 编码的 thmb 缩略图项，其次是 Exif 中的 JPEG 缩略图
+QImage loadEmbeddedPreview(const QString &path, const QSize &targetSize);
+
+// HEIF 的 thmb 缩略图通常是 HEVC 编码，Qt 无法直接解码。
+// 这里把缩略图项（含 hvcC 参数集）导出为 Annex-B 码流，
+// 调用方只需转码这一小段码流，而不是整张网格拼接的大图
+bool writeHeifThumbnailStream(const QString &path, const QString &outFile);
+
+// 视频容器内嵌的封面图（MKV 附件 cover.jpg、MP4 covr），缩放到 targetSize 以内
+// 有封面时可以完全跳过视频解码；没有返回空图
+QImage loadVideoCoverArt(const QString &path, const QSize &targetSize);
+
+#endif // EMBEDDEDPREVIEWUTIL_H
@@ -9,6 +9,12 @@
 #include <QMutexLocker>
 #include <QStandardPaths>
 #include <QFile>
+#include <QRegularExpression>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QResource>
+#include <QThreadPool>
+#include <QCryptographicHash>
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -20,48 +26,131 @@ static QSet<qint64> g_ffmpegPids;
 static QMutex g_ffmpegMutex;
 static QAtomicInt g_isQuitting(0); // 0=运行中, 1=正在退出
 
-// 辅助函数：将资源中的 ffmpeg 释放到本地缓存目录
-QString ensureFfmpegExtracted()
+#ifdef Q_OS_WIN
+static const QString FfmpegFileName = QStringLiteral("ffmpeg.exe");
+#else
+static const QString FfmpegFileName = QStringLiteral("ffmpeg");
+#endif
+
+static QByteArray sha256OfFile(const QString &path)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly))
+        return QByteArray();
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!hash.addData(&f))
+        return QByteArray();
+    return hash.result().toHex();
+}
+
+// 校验记录：大小 + 修改时间 + 哈希。对得上就说明文件自上次校验后没动过，不必再整文件哈希
+static QByteArray verifiedStamp(const QString &path, const QByteArray &sha256)
+{
+    const QFileInfo info(path);
+    return QByteArray::number(info.size()) + ' '
+           + QByteArray::number(info.lastModified().toMSecsSinceEpoch()) + ' ' + sha256;
+}
+
+static bool extractedCopyValid(const QString &path, const QByteArray &sha256)
+{
+    if (QFileInfo(path).size() == 0)
+        return false;
+
+    QFile stamp(path + ".verified");
+    if (stamp.open(QIODevice::ReadOnly) && stamp.readAll() == verifiedStamp(path, sha256))
+        return true;
+    stamp.close();
+
+    // 没有记录或对不上（被截断、被替换、换了版本）：整文件校验一次
+    if (sha256OfFile(path) != sha256)
+        return false;
+    if (stamp.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        stamp.write(verifiedStamp(path, sha256));
+    return true;
+}
+
+// 从外部资源包 ffmpeg.rcc 释放到本地数据目录，按构建时记录的 SHA-256 校验
+static QString extractBundledFfmpeg()
 {
-    // 获取系统的标准缓存/数据目录，例如 C:/Users/User/AppData/Local/YourApp/
-    // 或者 C:/Users/User/AppData/Local/Temp/
-    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
-    QDir dir(cacheDir);
-    if (!dir.exists()) {
+#ifdef XSM_FFMPEG_SHA256
+    const QByteArray expected(XSM_FFMPEG_SHA256);
+
+    // 获取系统的标准数据目录，例如 C:/Users/User/AppData/Local/YourApp/
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+    if (!dir.exists())
         dir.mkpath(".");
+    const QString targetPath = dir.filePath(FfmpegFileName);
+    if (extractedCopyValid(targetPath, expected))
+        return targetPath;
+
+    // 资源包不编进可执行文件，需要释放时才注册（内存映射），用完就卸载
+    const QString bundle = QCoreApplication::applicationDirPath() + "/ffmpeg.rcc";
+    if (!QResource::registerResource(bundle)) {
+        qWarning("ffmpeg: no sidecar, system or bundled ffmpeg found");
+        return QString();
     }
 
-#ifdef Q_OS_WIN
-    QString fileName = "ffmpeg.exe";
-#else
-    QString fileName = "ffmpeg";
-#endif
+    // 先写临时文件，校验通过再换上去：中途退出或资源损坏都不会留下半个可执行文件
+    const QString partPath = targetPath + ".part";
+    QFile::remove(partPath);
+    const bool copied = QFile::copy(":/ffmpeg.exe", partPath) && sha256OfFile(partPath) == expected;
+    QResource::unregisterResource(bundle);
+    if (!copied) {
+        QFile::remove(partPath);
+        qWarning("ffmpeg: bundled binary failed the checksum check");
+        return QString();
+    }
 
-    QString targetPath = dir.filePath(fileName);
-
-    // 如果文件不存在，或者大小为0（防止之前的错误），则从资源中复制
-    if (!QFile::exists(targetPath) || QFile(targetPath).size() == 0) {
-        // 从 Qt 资源系统 (:前缀) 复制到 目标路径
-        // 这里的 :/ffmpeg.exe 对应 resources.qrc 中的 alias
-        if (QFile::copy(":/ffmpeg.exe", targetPath)) {
-            // 复制成功，设置可执行权限（对 Linux/Mac 重要）
-            QFile::setPermissions(targetPath,
-                                  QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner |
-                                      QFile::ReadGroup | QFile::ExeGroup |
-                                      QFile::ReadOther | QFile::ExeOther);
-        }
+    // 设置可执行权限（对 Linux/Mac 重要）
+    QFile::setPermissions(partPath,
+                          QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner |
+                              QFile::ReadGroup | QFile::ExeGroup |
+                              QFile::ReadOther | QFile::ExeOther);
+    QFile::remove(targetPath);
+    QFile::remove(targetPath + ".verified");
+    if (!QFile::rename(partPath, targetPath)) {
+        QFile::remove(partPath);
+        return QString();
     }
 
+    QFile stamp(targetPath + ".verified");
+    if (stamp.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        stamp.write(verifiedStamp(targetPath, expected));
     return targetPath;
+#else
+    qWarning("ffmpeg: no sidecar or system ffmpeg found, and this build has no bundled copy");
+    return QString();
+#endif
+}
+
+static QString locateFfmpeg()
+{
+    // 1. 程序目录下的 ffmpeg（安装包附带，或者用户自己放的版本）
+    const QString sidecar = QCoreApplication::applicationDirPath() + '/' + FfmpegFileName;
+    if (QFileInfo(sidecar).isExecutable())
+        return sidecar;
+
+    // 2. 系统 PATH 里的 ffmpeg
+    const QString system = QStandardPaths::findExecutable("ffmpeg");
+    if (!system.isEmpty())
+        return system;
+
+    // 3. 资源包里的副本
+    return extractBundledFfmpeg();
 }
 
 QString ffmpegExecutablePath()
 {
-    // 改为使用静态变量，保证只在第一次调用时执行文件释放操作
-    static QString path = ensureFfmpegExtracted();
+    // 静态局部变量只初始化一次；其他线程同时调用会等第一次定位完成
+    static const QString path = locateFfmpeg();
     return path;
 }
 
+void prepareFfmpegAsync()
+{
+    QThreadPool::globalInstance()->start([]() { ffmpegExecutablePath(); });
+}
+
 static void registerFfmpegPid(qint64 pid)
 {
     if (pid <= 0)
@@ -78,15 +167,19 @@ static void unregisterFfmpegPid(qint64 pid)
     g_ffmpegPids.remove(pid);
 }
 
-int runFfmpegBlocking(const QStringList &args)
+int runFfmpegBlocking(const QStringList &args, QByteArray *errorOutput)
 {
     // 如果程序正在退出，直接拒绝执行，防止产生僵尸进程
     if (g_isQuitting.loadAcquire()) {
         return -1;
     }
 
+    const QString program = ffmpegExecutablePath();
+    if (program.isEmpty())
+        return -1;
+
     QProcess proc;
-    proc.setProgram(ffmpegExecutablePath());
+    proc.setProgram(program);
     proc.setArguments(args);
 
     proc.start();
@@ -101,9 +194,25 @@ int runFfmpegBlocking(const QStringList &args)
     proc.waitForFinished(-1);
 
     unregisterFfmpegPid(pid);
+    if (errorOutput)
+        *errorOutput = proc.readAllStandardError();
     return proc.exitCode();
 }
 
+double probeDurationSeconds(const QString &path)
+{
+    // 只给输入不给输出，ffmpeg 打印完流信息就退出，不做任何解码
+    QByteArray log;
+    runFfmpegBlocking(QStringList() << "-hide_banner" << "-i" << path, &log);
+
+    static const QRegularExpression re("Duration:\\s*(\\d+):(\\d+):(\\d+(?:\\.\\d+)?)");
+    const QRegularExpressionMatch m = re.match(QString::fromUtf8(log));
+    if (!m.hasMatch())
+        return 0.0;
+    return m.captured(1).toInt() * 3600.0 + m.captured(2).toInt() * 60.0
+           + m.captured(3).toDouble();
+}
+
 static void killPid(qint64 pid)
 {
 #ifdef Q_OS_WIN
@@ -4,12 +4,22 @@
 #pragma once
 #include <QString>
 #include <QStringList>
+#include <QByteArray>
 
-// 返回 ffmpeg 可执行文件的完整路径：程序所在目录下的 ffmpeg.exe（或 ffmpeg）
+// 返回 ffmpeg 可执行文件的完整路径，找不到时为空。依次查找：
+// 程序目录下的 ffmpeg.exe（或 ffmpeg）、系统 PATH、外部资源包 ffmpeg.rcc 释放出的副本（SHA-256 校验）
+// 第一次调用可能要释放和校验文件，会阻塞，只在工作线程调用
 QString ffmpegExecutablePath();
 
+// 启动后在后台线程完成定位（和可能的释放），不占启动时间
+void prepareFfmpegAsync();
+
 // 阻塞式调用 ffmpeg；内部会记录 PID，供退出时杀进程
-int runFfmpegBlocking(const QStringList &args);
+// errorOutput 非空时收集 stderr（ffmpeg 的日志和流信息都在这里）
+int runFfmpegBlocking(const QStringList &args, QByteArray *errorOutput = nullptr);
+
+// 用内置 ffmpeg 读取时长（秒），解析 "Duration: hh:mm:ss.xx"；失败返回 0
+double probeDurationSeconds(const QString &path);
 
 // 在应用退出时调用，杀掉所有仍在运行的 ffmpeg 子进程
 void killAllFfmpegProcesses();
@@ -0,0 +1,166 @@
+#include "FolderHistory.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QDataStream>
+#include <QStandardPaths>
+#include <QVector>
+#include <QPair>
+
+#include <algorithm>
+
+namespace {
+
+const quint32 HistoryMagic = 0x58534648; // "XSFH"
+const quint32 HistoryVersion = 1;
+
+const double VisitDecay = 0.9;          // 每次从同一目录出发，旧去向的权重乘这个系数
+const double MinWeight = 0.05;          // 衰减到这以下的去向丢掉
+const int MaxTargets = 16;              // 每个来源最多记这么多去向
+const int MaxSources = 4000;            // 超过后丢掉总权重最小的来源
+const double PopularityWeight = 0.1;
+const double HoverBoost = 2.0;          // 刚悬停过的子目录，比任何历史都优先
+const qint64 HoverWindowMs = 10000;
+
+} // namespace
+
+FolderHistory &FolderHistory::instance()
+{
+    static FolderHistory history;
+    return history;
+}
+
+FolderHistory::FolderHistory()
+{
+    load();
+}
+
+QString FolderHistory::filePath() const
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (dir.isEmpty())
+        dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    QDir().mkpath(dir);
+    return dir + "/folder_history.bin";
+}
+
+void FolderHistory::load()
+{
+    QFile f(filePath());
+    if (!f.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (magic != HistoryMagic || version != HistoryVersion)
+        return;
+
+    QHash<QString, QHash<QString, double>> transitions;
+    QHash<QString, double> popularity;
+    in >> transitions >> popularity;
+    if (in.status() != QDataStream::Ok)
+        return;     // 截断的文件不用，历史从头攒
+
+    m_transitions = transitions;
+    m_popularity = popularity;
+}
+
+void FolderHistory::save()
+{
+    if (!m_dirty)
+        return;
+
+    QSaveFile f(filePath());
+    if (!f.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << HistoryMagic << HistoryVersion << m_transitions << m_popularity;
+    if (f.commit())
+        m_dirty = false;
+}
+
+void FolderHistory::recordVisit(const QString &from, const QString &to)
+{
+    if (to.isEmpty() || from == to)
+        return;
+    m_dirty = true;
+    m_popularity[to] += 1.0;
+
+    if (from.isEmpty())
+        return;
+
+    QHash<QString, double> &targets = m_transitions[from];
+    for (auto it = targets.begin(); it != targets.end();) {
+        it.value() *= VisitDecay;
+        if (it.value() < MinWeight)
+            it = targets.erase(it);
+        else
+            ++it;
+    }
+    targets[to] += 1.0;
+
+    if (targets.size() > MaxTargets) {
+        auto weakest = std::min_element(targets.begin(), targets.end());
+        targets.erase(weakest);
+    }
+
+    if (m_transitions.size() > MaxSources) {
+        // 偶尔才会走到，线性找一遍即可
+        auto weakest = m_transitions.end();
+        double weakestSum = 0.0;
+        for (auto it = m_transitions.begin(); it != m_transitions.end(); ++it) {
+            double sum = 0.0;
+            for (double w : std::as_const(it.value()))
+                sum += w;
+            if (it.key() != from && (weakest == m_transitions.end() || sum < weakestSum)) {
+                weakest = it;
+                weakestSum = sum;
+            }
+        }
+        if (weakest != m_transitions.end()) {
+            m_popularity.remove(weakest.key());
+            m_transitions.erase(weakest);
+        }
+    }
+}
+
+void FolderHistory::recordHover(const QString &from, const QString &to)
+{
+    m_hoverFrom = from;
+    m_hoverTo = to;
+    m_hoverAt = QDateTime::currentMSecsSinceEpoch();
+}
+
+QStringList FolderHistory::predict(const QString &from, const QStringList &candidates, int count) const
+{
+    QHash<QString, double> scores = m_transitions.value(from);
+    for (const QString &candidate : candidates) {
+        const double popularity = m_popularity.value(candidate);
+        if (popularity > 0)
+            scores[candidate] += PopularityWeight * popularity;
+    }
+    if (m_hoverFrom == from && !m_hoverTo.isEmpty()
+        && QDateTime::currentMSecsSinceEpoch() - m_hoverAt < HoverWindowMs)
+        scores[m_hoverTo] += HoverBoost;
+    scores.remove(from);
+
+    QVector<QPair<double, QString>> ranked;
+    ranked.reserve(scores.size());
+    for (auto it = scores.cbegin(); it != scores.cend(); ++it)
+        ranked.append({ it.value(), it.key() });
+    std::sort(ranked.begin(), ranked.end(), [](const auto &a, const auto &b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    QStringList result;
+    for (int i = 0; i < ranked.size() && result.size() < count; ++i)
+        result << ranked.at(i).second;
+    return result;
+}
@@ -0,0 +1,40 @@
+#ifndef FOLDERHISTORY_H
+#define FOLDERHISTORY_H
+
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QHash>
+
+// 目录导航历史（AppDataLocation/folder_history.bin），只在 GUI 线程使用
+// 记录 "从哪个目录去了哪个目录" 的转移次数（按次衰减，越近的权重越大），
+// 以及侧栏里悬停过的子目录，用来预测下一步最可能打开的目录，空闲时提前预热
+
+class FolderHistory {
+public:
+    static FolderHistory &instance();
+
+    void recordVisit(const QString &from, const QString &to);
+    void recordHover(const QString &from, const QString &to);   // 悬停是强信号，但只在短时间内有效
+
+    // 从 from 出发最可能去的 count 个目录：历史里的去向 + candidates（子目录、上一级）
+    // 里被打开过的目录；从没有信号的不返回
+    QStringList predict(const QString &from, const QStringList &candidates, int count) const;
+
+    void save();
+
+private:
+    FolderHistory();
+    Q_DISABLE_COPY(FolderHistory)
+    void load();
+    QString filePath() const;
+
+    QHash<QString, QHash<QString, double>> m_transitions; // 来源 -> (去向 -> 权重)
+    QHash<QString, double> m_popularity;                  // 目录被打开的次数，没有转移记录时作先验
+    QString m_hoverFrom;
+    QString m_hoverTo;
+    qint64 m_hoverAt = 0;
+    bool m_dirty = false;
+};
+
+#endif // FOLDERHISTORY_H
@@ -0,0 +1,148 @@
+#include "FolderMosaic.h"
+#include "ImageDecoder.h"
+#include "EmbeddedPreviewUtil.h"
+#include "LibraryIndex.h"
+#include "ImageScaler.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QPainter>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QSet>
+#include <QVector>
+
+namespace {
+
+const int MosaicCells = 4;
+const int MaxProbe = 64;        // 最多看这么多个文件名找缓存，几万个文件的目录也只 stat 几十次
+const int CellGap = 2;
+
+// 与 loadContent 的名称过滤保持一致
+const QSet<QString> &videoSuffixes()
+{
+    static const QSet<QString> s = { "mp4", "mkv", "avi", "mov", "webm", "flv", "wmv", "m4v" };
+    return s;
+}
+
+const QStringList &mediaNameFilters()
+{
+    static const QStringList filters = {
+        "*.jpg", "*.jpeg", "*.png", "*.bmp", "*.gif", "*.webp", "*.tiff", "*.tif",
+        "*.heic", "*.heif", "*.hif",
+        "*.cr2", "*.nef", "*.nrw", "*.arw", "*.sr2", "*.dng",
+        "*.orf", "*.rw2", "*.pef", "*.raf",
+        "*.mp4", "*.mkv", "*.avi", "*.mov", "*.webm", "*.flv", "*.wmv", "*.m4v",
+    };
+    return filters;
+}
+
+// 与缩略图工作线程、ImageDecoder 的缓存命名保持一致
+QString cachedThumbnailPath(const QString &cacheDir, const QString &path, bool isVideo)
+{
+    const QString hash = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Md5).toHex();
+    return cacheDir + (isVideo ? "/thumb_" : "/thumb_img_") + hash + ".jpg";
+}
+
+// 本层媒体文件名：索引里 mtime 没变就直接用，否则 readdir 一次（只要文件名，不 stat）
+QStringList mediaFileNames(const QString &dir)
+{
+    const QString clean = QDir::cleanPath(dir);
+    const qint64 dirMtime = QFileInfo(clean).lastModified().toMSecsSinceEpoch();
+    DirNode node;
+    if (LibraryIndex::instance().lookup(clean, &node) && node.mtime == dirMtime && node.hasFiles)
+        return node.files;
+
+    return QDir(clean).entryList(mediaNameFilters(), QDir::Files | QDir::NoDotAndDotDot,
+                                 QDir::Name | QDir::IgnoreCase);
+}
+
+QSize cellSize()
+{
+    return QSize((FolderMosaicSize.width() - CellGap) / 2, (FolderMosaicSize.height() - CellGap) / 2);
+}
+
+QImage composeMosaic(const QVector<QImage> &tiles)
+{
+    QImage mosaic(FolderMosaicSize, QImage::Format_RGB32);
+    mosaic.fill(QColor("#272727"));
+
+    const QSize cell = cellSize();
+    QPainter p(&mosaic);
+    for (int i = 0; i < tiles.size() && i < MosaicCells; ++i) {
+        const QImage &tile = tiles.at(i);
+        if (tile.isNull())
+            continue;
+        // 铺满格子：先按格子比例居中裁出源区域，再用共用的缩放器（面积平均）缩到格子大小
+        const QSize crop = cell.scaled(tile.size(), Qt::KeepAspectRatio);
+        const QRect source((tile.width() - crop.width()) / 2, (tile.height() - crop.height()) / 2,
+                           crop.width(), crop.height());
+        const QImage scaled = scaleImage(tile.copy(source), cell);
+        p.drawImage(QPoint((i % 2) * (cell.width() + CellGap), (i / 2) * (cell.height() + CellGap)),
+                    scaled);
+    }
+    return mosaic;
+}
+
+} // namespace
+
+QString folderMosaicCachePath(const QString &dir)
+{
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    const QByteArray hash = QCryptographicHash::hash(QDir::cleanPath(dir).toUtf8(), QCryptographicHash::Md5);
+    return cacheDir + "/mosaic_" + hash.toHex() + ".jpg";
+}
+
+QImage loadOrCreateFolderMosaic(const QString &dir)
+{
+    const QString cacheFile = folderMosaicCachePath(dir);
+    const QFileInfo cacheInfo(cacheFile);
+    const QFileInfo dirInfo(dir);
+    // 目录有增删时 mtime 会变新，之前拼的图就过期了
+    if (cacheInfo.exists() && cacheInfo.lastModified() >= dirInfo.lastModified()) {
+        QImage cached(cacheFile);
+        if (!cached.isNull())
+            return cached;
+    }
+
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    const QDir qdir(dir);
+    const QStringList names = mediaFileNames(dir);
+    const QSize cell = cellSize();
+
+    // 先只用已经缓存的缩略图
+    QVector<QImage> tiles;
+    for (int i = 0; i < names.size() && i < MaxProbe && tiles.size() < MosaicCells; ++i) {
+        const QString path = qdir.absoluteFilePath(names.at(i));
+        const bool isVideo = videoSuffixes().contains(QFileInfo(path).suffix().toLower());
+        const QString thumb = cachedThumbnailPath(cacheDir, path, isVideo);
+        if (!QFile::exists(thumb))
+            continue;
+        const QImage img = ImageDecoderRegistry::instance().decode(thumb, cell);
+        if (!img.isNull())
+            tiles.append(img);
+    }
+
+    // 一张缓存都没有：解码前几个文件，但不启动 ffmpeg
+    if (tiles.isEmpty()) {
+        for (int i = 0; i < names.size() && i < MaxProbe && tiles.size() < MosaicCells; ++i) {
+            const QString path = qdir.absoluteFilePath(names.at(i));
+            const QString suffix = QFileInfo(path).suffix().toLower();
+            const QImage img = videoSuffixes().contains(suffix)
+                                   ? loadVideoCoverArt(path, cell)
+                                   : ImageDecoderRegistry::instance().decode(path, cell, false);
+            if (!img.isNull())
+                tiles.append(img);
+        }
+    }
+
+    if (tiles.isEmpty())
+        return QImage();
+
+    const QImage mosaic = composeMosaic(tiles);
+    QDir().mkpath(cacheDir);
+    mosaic.save(cacheFile, "JPG", 85);
+    return mosaic;
+}
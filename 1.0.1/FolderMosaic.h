@@ -0,0 +1,22 @@
+#ifndef FOLDERMOSAIC_H
+#define FOLDERMOSAIC_H
+
+#pragma once
+#include <QString>
+#include <QImage>
+#include <QSize>
+
+// 文件夹预览：取目录里前几个已经有缓存缩略图的媒体文件，拼成 2x2 的小图，
+// 存放在缩略图缓存目录（mosaic_<md5>.jpg）。只读缓存的缩略图，不解码原文件；
+// 一张缓存都没有时才解码最多 4 张图片（或取视频内嵌封面），不启动 ffmpeg
+
+const QSize FolderMosaicSize(96, 96);
+
+// 缓存文件路径（与 thumb_<md5>.jpg 同目录）
+QString folderMosaicCachePath(const QString &dir);
+
+// 读取缓存的拼图（比目录新才算有效），没有则生成；阻塞，只能在工作线程调用。
+// 目录里没有可用的媒体文件时返回空图
+QImage loadOrCreateFolderMosaic(const QString &dir);
+
+#endif // FOLDERMOSAIC_H
@@ -0,0 +1,169 @@
+#include "FolderStatsAggregator.h"
+#include "LibraryIndex.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+namespace {
+
+// 与 loadContent 的名称过滤保持一致
+const QSet<QString> &videoSuffixes()
+{
+    static const QSet<QString> s = { "mp4", "mkv", "avi", "mov", "webm", "flv", "wmv", "m4v" };
+    return s;
+}
+
+const QSet<QString> &imageSuffixes()
+{
+    static const QSet<QString> s = { "jpg", "jpeg", "png", "bmp", "gif", "webp", "tiff", "tif",
+                                     "heic", "heif", "hif",
+                                     "cr2", "nef", "nrw", "arw", "sr2", "dng",
+                                     "orf", "rw2", "pef", "raf" };
+    return s;
+}
+
+} // namespace
+
+FolderStatsAggregator::FolderStatsAggregator(QObject *parent)
+    : QObject(parent)
+    , m_treeCancel(std::make_shared<std::atomic_bool>(false))
+    , m_shutdown(std::make_shared<std::atomic_bool>(false))
+{
+    // 主要是磁盘 I/O：几个线程并行就能把队列深度提上去，再多只会和前台抢盘
+    m_pool.setMaxThreadCount(std::clamp(QThread::idealThreadCount() / 2, 2, 4));
+    m_pool.setThreadPriority(QThread::LowPriority);
+
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FlushIntervalMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &FolderStatsAggregator::flushChanged);
+}
+
+FolderStatsAggregator::~FolderStatsAggregator()
+{
+    m_treeCancel->store(true);
+    m_shutdown->store(true);
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void FolderStatsAggregator::aggregate(const QString &root)
+{
+    m_treeCancel->store(true);
+    m_treeCancel = std::make_shared<std::atomic_bool>(false);
+
+    const QString dir = QDir::cleanPath(root);
+    const std::shared_ptr<std::atomic_bool> cancel = m_treeCancel;
+    m_pool.start([this, dir, cancel]() {
+        scanDirectory(dir, true, false, cancel);
+    });
+}
+
+void FolderStatsAggregator::rescan(const QStringList &dirs, bool recursive)
+{
+    const std::shared_ptr<std::atomic_bool> cancel = m_shutdown;
+    for (const QString &dir : dirs) {
+        const QString clean = QDir::cleanPath(dir);
+        // 用户在等的是变化的结果，排在整棵树的统计前面
+        m_pool.start([this, clean, recursive, cancel]() {
+            scanDirectory(clean, recursive, true, cancel);
+        }, 1);
+    }
+}
+
+void FolderStatsAggregator::scanDirectory(const QString &dir, bool recursive, bool force,
+                                          const std::shared_ptr<std::atomic_bool> &cancel)
+{
+    if (cancel->load())
+        return;
+
+    LibraryIndex &index = LibraryIndex::instance();
+    const QFileInfo dirInfo(dir);
+    if (!dirInfo.isDir()) {
+        index.removeTree(dir);
+        notifyChanged(dir);
+        return;
+    }
+
+    const qint64 dirMtime = dirInfo.lastModified().toMSecsSinceEpoch();
+    DirNode node;
+    QStringList subdirs;
+    QStringList unknownSubdirs;     // 非递归时也要往下统计的：新出现的子目录
+    if (!force && index.lookup(dir, &node) && node.mtime == dirMtime
+        && node.hasLocalStats && node.hasSubdirs) {
+        // 本层没变：统计直接可用，只需沿记录的子目录往下看
+        subdirs = node.subdirs;
+    } else {
+        FolderStats local;
+        QStringList mediaNames;
+        const QFileInfoList entries = QDir(dir).entryInfoList(
+            QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+        for (const QFileInfo &e : entries) {
+            if (e.isDir()) {
+                subdirs << e.fileName();
+                continue;
+            }
+            ++local.files;
+            local.bytes += e.size();
+            const QString suffix = e.suffix().toLower();
+            if (videoSuffixes().contains(suffix)) {
+                ++local.videos;
+                mediaNames << e.fileName();
+            } else if (imageSuffixes().contains(suffix)) {
+                ++local.images;
+                mediaNames << e.fileName();
+            }
+        }
+        if (cancel->load())
+            return;     // 枚举到一半换根了：结果是完整的，但没人要了也不必写
+
+        for (const QString &name : std::as_const(subdirs)) {
+            DirNode child;
+            if (!index.lookup(QDir::cleanPath(dir + '/' + name), &child) || !child.hasTotalStats)
+                unknownSubdirs << name;
+        }
+        index.updateWithStats(dir, dirMtime, mediaNames, subdirs, local);
+        notifyChanged(dir);
+    }
+
+    // 子目录各自一个任务，线程池里并行展开；事件丢失后的重扫要一路强制读到底
+    const QStringList &next = recursive ? subdirs : unknownSubdirs;
+    const bool forceChildren = recursive && force;
+    for (const QString &name : next) {
+        const QString child = QDir::cleanPath(dir + '/' + name);
+        m_pool.start([this, child, forceChildren, cancel]() {
+            scanDirectory(child, true, forceChildren, cancel);
+        });
+    }
+}
+
+void FolderStatsAggregator::notifyChanged(const QString &dir)
+{
+    QMutexLocker locker(&m_changedMutex);
+    const bool first = m_changed.isEmpty();
+    m_changed << dir;
+    if (first) {
+        QMetaObject::invokeMethod(this, [this]() {
+            if (!m_flushTimer->isActive())
+                m_flushTimer->start();
+        }, Qt::QueuedConnection);
+    }
+}
+
+void FolderStatsAggregator::flushChanged()
+{
+    QStringList dirs;
+    {
+        QMutexLocker locker(&m_changedMutex);
+        dirs.swap(m_changed);
+    }
+    if (!dirs.isEmpty())
+        emit statsChanged(dirs);
+}
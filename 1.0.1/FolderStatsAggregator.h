@@ -0,0 +1,49 @@
+#ifndef FOLDERSTATSAGGREGATOR_H
+#define FOLDERSTATSAGGREGATOR_H
+
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QMutex>
+#include <atomic>
+#include <memory>
+
+class QTimer;
+
+// 后台统计目录树：每个目录本层的文件数、字节数、图片/视频数记进媒体库索引，
+// 子树合计由索引向上汇总。每个目录是线程池里的一个任务，子目录并行展开；
+// 索引里 mtime 没变且已有统计的目录只 stat 一下，不再 readdir
+class FolderStatsAggregator : public QObject {
+    Q_OBJECT
+public:
+    explicit FolderStatsAggregator(QObject *parent = nullptr);
+    ~FolderStatsAggregator() override;
+
+    // 统计 root 整棵树；换根时上一棵树还没开始的目录直接放弃
+    void aggregate(const QString &root);
+    // 目录监视报告的变化：强制重读这些目录本层（原地改写文件时 mtime 不变）。
+    // recursive 为 false 时只往下统计新出现、还没有统计的子目录
+    void rescan(const QStringList &dirs, bool recursive);
+
+signals:
+    // 统计变过的目录（合并后发出）；它们所有上级的合计也跟着变了
+    void statsChanged(const QStringList &dirs);
+
+private:
+    void scanDirectory(const QString &dir, bool recursive, bool force,
+                       const std::shared_ptr<std::atomic_bool> &cancel);
+    void notifyChanged(const QString &dir);     // 任意线程
+    void flushChanged();
+
+    QThreadPool m_pool;
+    std::shared_ptr<std::atomic_bool> m_treeCancel;     // 当前 aggregate 的树，换根时置位
+    std::shared_ptr<std::atomic_bool> m_shutdown;       // 监视触发的重扫只在析构时取消
+    QMutex m_changedMutex;
+    QStringList m_changed;
+    QTimer *m_flushTimer = nullptr;
+    static const int FlushIntervalMs = 250;
+};
+
+#endif // FOLDERSTATSAGGREGATOR_H
@@ -0,0 +1,638 @@
+#include "FolderTreeModel.h"
+#include "LibraryIndex.h"
+#include "FolderMosaic.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSet>
+#include <QThread>
+#include <QColor>
+#include <QLocale>
+#include <QPixmap>
+
+#include <algorithm>
+
+namespace {
+
+const int CountChunk = 32;      // 统计结果按块送回 GUI 线程，几千个子目录也不会一次刷太多行
+const int FetchPriority = 1;    // 枚举子目录是用户在等的，排在统计前面
+const int CountPriority = 0;
+
+// 与 loadContent 的名称过滤保持一致
+const QSet<QString> &mediaSuffixes()
+{
+    static const QSet<QString> s = { "mp4", "mkv", "avi", "mov", "webm", "flv", "wmv", "m4v",
+                                     "jpg", "jpeg", "png", "bmp", "gif", "webp", "tiff", "tif",
+                                     "heic", "heif", "hif",
+                                     "cr2", "nef", "nrw", "arw", "sr2", "dng",
+                                     "orf", "rw2", "pef", "raf" };
+    return s;
+}
+
+struct DirScan {
+    QStringList subdirs;    // 全部子目录名（含符号链接，侧栏照常显示），不区分大小写排序
+    int mediaCount = 0;
+};
+
+// 一次 readdir 同时拿到子目录和本层媒体文件，顺手记进媒体库索引
+DirScan scanDirectory(const QString &dir)
+{
+    DirScan scan;
+    const qint64 dirMtime = QFileInfo(dir).lastModified().toMSecsSinceEpoch();
+    const QFileInfoList entries = QDir(dir).entryInfoList(
+        QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot, QDir::Name | QDir::IgnoreCase);
+
+    QStringList indexedSubdirs, indexedFiles;
+    for (const QFileInfo &e : entries) {
+        if (e.isDir()) {
+            scan.subdirs << e.fileName();
+            if (!e.isSymLink())
+                indexedSubdirs << e.fileName();     // 爬虫不跟随符号链接，索引里也不记
+        } else if (mediaSuffixes().contains(e.suffix().toLower())) {
+            ++scan.mediaCount;
+            if (!e.isSymLink())
+                indexedFiles << e.fileName();
+        }
+    }
+    if (!QFileInfo(dir).isSymLink())
+        LibraryIndex::instance().update(QDir::cleanPath(dir), dirMtime, indexedFiles, indexedSubdirs);
+    return scan;
+}
+
+// 只要数字：索引里 mtime 没变就直接用记录，不再 readdir
+QPair<int, int> countDirectory(const QString &dir)
+{
+    const QString clean = QDir::cleanPath(dir);
+    const qint64 dirMtime = QFileInfo(clean).lastModified().toMSecsSinceEpoch();
+    DirNode node;
+    if (LibraryIndex::instance().isCurrent(clean, dirMtime, &node))
+        return { node.files.size(), node.subdirs.size() };
+
+    const DirScan scan = scanDirectory(clean);
+    return { scan.mediaCount, scan.subdirs.size() };
+}
+
+// 角标宽度有限：1234 -> 1.2k
+QString compactCount(qint64 count)
+{
+    if (count < 1000)
+        return QString::number(count);
+    if (count < 1000000)
+        return QString::number(count / 1000.0, 'f', count < 10000 ? 1 : 0) + 'k';
+    return QString::number(count / 1000000.0, 'f', 1) + 'M';
+}
+
+} // namespace
+
+FolderTreeModel::FolderTreeModel(const QIcon &folderIcon, QObject *parent)
+    : QAbstractItemModel(parent)
+    , m_folderIcon(folderIcon)
+    , m_cancel(std::make_shared<std::atomic_bool>(false))
+{
+    m_pool.setMaxThreadCount(1);
+    m_mosaicPool.setMaxThreadCount(1);
+    m_mosaicPool.setThreadPriority(QThread::LowPriority);
+    m_mosaics.setMaxCost(MosaicCacheSize);
+}
+
+FolderTreeModel::~FolderTreeModel()
+{
+    m_cancel->store(true);
+    m_pool.clear();
+    m_mosaicPool.clear();
+    m_pool.waitForDone();
+    m_mosaicPool.waitForDone();
+    clearTree();
+}
+
+void FolderTreeModel::clearTree()
+{
+    qDeleteAll(m_nodes);
+    m_nodes.clear();
+    m_root = nullptr;
+}
+
+void FolderTreeModel::setRootPath(const QString &path, const QStringList &knownChildren)
+{
+    // 旧根下排队的枚举和统计都不要了
+    m_cancel->store(true);
+    m_cancel = std::make_shared<std::atomic_bool>(false);
+    m_pool.clear();
+    // 还没开始的拼图也不要了；已经生成的按路径留在缓存里，回到这里时直接用
+    m_mosaicPool.clear();
+    m_mosaicPending.clear();
+    ++m_generation;
+
+    beginResetModel();
+    clearTree();
+    m_root = new Node;
+    m_root->path = QDir::cleanPath(path);
+    m_root->name = QFileInfo(m_root->path).fileName();
+    m_nodes.insert(m_root->path, m_root);
+    if (!knownChildren.isEmpty()) {
+        populate(m_root, knownChildren);
+        m_root->fetched = true;
+    }
+    endResetModel();
+
+    if (m_root->fetched) {
+        countChildren(m_root);
+        emit rootChildrenLoaded(knownChildren);
+    } else {
+        fetchMore(QModelIndex());
+    }
+}
+
+QString FolderTreeModel::rootPath() const
+{
+    return m_root ? m_root->path : QString();
+}
+
+QStringList FolderTreeModel::childNames() const
+{
+    QStringList names;
+    if (!m_root)
+        return names;
+    names.reserve(m_root->children.size());
+    for (const Node *child : m_root->children)
+        names << child->name;
+    return names;
+}
+
+bool FolderTreeModel::isRootFetched() const
+{
+    return m_root && m_root->fetched;
+}
+
+FolderTreeModel::Node *FolderTreeModel::nodeFor(const QModelIndex &index) const
+{
+    return index.isValid() ? static_cast<Node *>(index.internalPointer()) : m_root;
+}
+
+QModelIndex FolderTreeModel::indexFor(Node *node, int column) const
+{
+    if (!node || node == m_root || !node->parent)
+        return QModelIndex();
+    return createIndex(node->row, column, node);
+}
+
+QModelIndex FolderTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+    const Node *p = nodeFor(parent);
+    if (!p || row < 0 || row >= p->children.size() || column < 0 || column >= ColumnCount)
+        return QModelIndex();
+    return createIndex(row, column, p->children.at(row));
+}
+
+QModelIndex FolderTreeModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid())
+        return QModelIndex();
+    const Node *node = static_cast<Node *>(child.internalPointer());
+    return indexFor(node->parent, 0);
+}
+
+int FolderTreeModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0)
+        return 0;
+    const Node *node = nodeFor(parent);
+    return node ? node->children.size() : 0;
+}
+
+int FolderTreeModel::columnCount(const QModelIndex &) const
+{
+    return ColumnCount;
+}
+
+QVariant FolderTreeModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+    const Node *node = static_cast<Node *>(index.internalPointer());
+
+    if (role == PathRole)
+        return node->path;
+    if (role == Qt::ToolTipRole)
+        return toolTip(node);
+
+    if (index.column() == NameColumn) {
+        if (role == Qt::DisplayRole)
+            return node->name;
+        if (role == Qt::DecorationRole) {
+            if (const QIcon *mosaic = m_mosaics.object(node->path))
+                return *mosaic;
+            // 只有真正要绘制的行才会来取图标，拼图在这时才排队生成
+            if (!m_mosaicEmpty.contains(node->path) && !m_mosaicPending.contains(node->path))
+                const_cast<FolderTreeModel *>(this)->requestMosaic(node->path);
+            return m_folderIcon;
+        }
+    } else if (index.column() == CountColumn) {
+        if (role == Qt::DisplayRole) {
+            const qint64 count = node->hasStats ? node->stats.images + node->stats.videos
+                                                : node->mediaCount;
+            return count > 0 ? compactCount(count) : QString();
+        }
+        if (role == Qt::TextAlignmentRole)
+            return int(Qt::AlignRight | Qt::AlignVCenter);
+        if (role == Qt::ForegroundRole)
+            return QColor(node->hasStats ? "#aaaaaa" : "#666666");  // 子树合计未出来前显示本层数，颜色淡一些
+    }
+    return QVariant();
+}
+
+QString FolderTreeModel::toolTip(const Node *node)
+{
+    QString tip = node->name;
+    if (node->hasStats) {
+        const FolderStats &stats = node->stats;
+        tip += QString("\n视频 %1 · 图片 %2\n共 %3 个文件，%4")
+                   .arg(stats.videos).arg(stats.images).arg(stats.files)
+                   .arg(QLocale().formattedDataSize(stats.bytes));
+    } else if (node->mediaCount >= 0) {
+        tip += QString("\n本层 %1 个媒体文件（子目录统计中…）").arg(node->mediaCount);
+    }
+    return tip;
+}
+
+bool FolderTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    if (parent.column() > 0)
+        return false;
+    const Node *node = nodeFor(parent);
+    if (!node)
+        return false;
+    if (node->fetched)
+        return !node->children.isEmpty();
+    if (node->subdirCount >= 0)
+        return node->subdirCount > 0;
+    return true;    // 还不知道：先给展开箭头，展开时再枚举
+}
+
+bool FolderTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.column() > 0)
+        return false;
+    const Node *node = nodeFor(parent);
+    return node && !node->fetched && !node->fetching;
+}
+
+void FolderTreeModel::fetchMore(const QModelIndex &parent)
+{
+    Node *node = nodeFor(parent);
+    if (!node || node->fetched || node->fetching)
+        return;
+    node->fetching = true;
+
+    const QString path = node->path;
+    const int generation = m_generation;
+    const std::shared_ptr<std::atomic_bool> cancel = m_cancel;
+    m_pool.start([this, path, generation, cancel]() {
+        if (cancel->load())
+            return;
+        const DirScan scan = scanDirectory(path);
+        if (cancel->load())
+            return;
+        QMetaObject::invokeMethod(this, [this, generation, path, scan]() {
+            applyChildren(generation, path, scan.subdirs, scan.mediaCount);
+        }, Qt::QueuedConnection);
+    }, FetchPriority);
+}
+
+FolderTreeModel::Node *FolderTreeModel::createChild(Node *parent, const QString &name)
+{
+    Node *child = new Node;
+    child->name = name;
+    child->path = QDir::cleanPath(QDir(parent->path).absoluteFilePath(name));
+    child->parent = parent;
+    m_nodes.insert(child->path, child);
+    return child;
+}
+
+void FolderTreeModel::removeSubtree(Node *node)
+{
+    for (Node *child : std::as_const(node->children))
+        removeSubtree(child);
+    m_nodes.remove(node->path);
+    delete node;
+}
+
+void FolderTreeModel::populate(Node *node, const QStringList &names)
+{
+    node->children.reserve(names.size());
+    QStringList paths;
+    paths.reserve(names.size());
+    for (const QString &name : names) {
+        Node *child = createChild(node, name);
+        child->row = node->children.size();
+        node->children.append(child);
+        paths << child->path;
+    }
+    loadStats(paths);
+}
+
+void FolderTreeModel::applyChildren(int generation, const QString &path,
+                                    const QStringList &names, int mediaCount)
+{
+    if (generation != m_generation)
+        return;
+    Node *node = m_nodes.value(path);
+    if (!node || node->fetched)
+        return;
+
+    node->fetching = false;
+    node->fetched = true;
+    node->mediaCount = mediaCount;
+    node->subdirCount = names.size();
+
+    const QModelIndex parentIndex = indexFor(node, 0);
+    if (!names.isEmpty()) {
+        beginInsertRows(parentIndex, 0, names.size() - 1);
+        populate(node, names);
+        endInsertRows();
+    } else if (node != m_root) {
+        emit dataChanged(parentIndex, indexFor(node, CountColumn));     // 展开箭头去掉
+    }
+
+    countChildren(node);
+    if (node == m_root)
+        emit rootChildrenLoaded(names);
+}
+
+void FolderTreeModel::refreshChildren(const QString &path)
+{
+    Node *node = m_nodes.value(QDir::cleanPath(path));
+    // 正在枚举的节点等它自己的结果
+    if (!node || node->fetching)
+        return;
+
+    const QString nodePath = node->path;
+    const int generation = m_generation;
+    const std::shared_ptr<std::atomic_bool> cancel = m_cancel;
+    m_pool.start([this, nodePath, generation, cancel]() {
+        if (cancel->load())
+            return;
+        const DirScan scan = scanDirectory(nodePath);
+        if (cancel->load())
+            return;
+        QMetaObject::invokeMethod(this, [this, generation, nodePath, scan]() {
+            applyRefresh(generation, nodePath, scan.subdirs, scan.mediaCount);
+        }, Qt::QueuedConnection);
+    }, FetchPriority);
+}
+
+void FolderTreeModel::applyRefresh(int generation, const QString &path,
+                                   const QStringList &names, int mediaCount)
+{
+    if (generation != m_generation)
+        return;
+    Node *node = m_nodes.value(path);
+    if (!node || node->fetching)
+        return;
+
+    node->mediaCount = mediaCount;
+    node->subdirCount = names.size();
+    if (!node->fetched) {
+        // 还没展开过：只更新数字和展开箭头，展开时再枚举
+        if (node->parent)
+            emitRowsChanged({ node });
+        return;
+    }
+
+    const QModelIndex parentIndex = indexFor(node, 0);
+
+    // 删除消失的子目录：从后往前，连续的行合并成一次 beginRemoveRows
+    const QSet<QString> wanted(names.cbegin(), names.cend());
+    for (int last = node->children.size() - 1; last >= 0;) {
+        if (wanted.contains(node->children.at(last)->name)) {
+            --last;
+            continue;
+        }
+        int first = last;
+        while (first > 0 && !wanted.contains(node->children.at(first - 1)->name))
+            --first;
+        beginRemoveRows(parentIndex, first, last);
+        for (int i = first; i <= last; ++i)
+            removeSubtree(node->children.at(i));
+        node->children.remove(first, last - first + 1);
+        for (int i = first; i < node->children.size(); ++i)
+            node->children.at(i)->row = i;
+        endRemoveRows();
+        last = first - 1;
+    }
+
+    // 插入新增的子目录：两边都是不区分大小写的名称顺序，留下的子节点正好是 names 的子序列
+    QSet<QString> existing;
+    for (const Node *child : std::as_const(node->children))
+        existing.insert(child->name);
+    QStringList added;
+    for (int first = 0; first < names.size();) {
+        if (existing.contains(names.at(first))) {
+            ++first;
+            continue;
+        }
+        int last = first;
+        while (last + 1 < names.size() && !existing.contains(names.at(last + 1)))
+            ++last;
+        beginInsertRows(parentIndex, first, last);
+        for (int i = first; i <= last; ++i) {
+            node->children.insert(i, createChild(node, names.at(i)));
+            added << node->children.at(i)->path;
+        }
+        for (int i = first; i < node->children.size(); ++i)
+            node->children.at(i)->row = i;
+        endInsertRows();
+        first = last + 1;
+    }
+
+    if (node->parent)
+        emitRowsChanged({ node });
+    loadStats(added);
+    countChildren(node);
+    if (node == m_root)
+        emit rootChildrenLoaded(names);
+}
+
+void FolderTreeModel::countChildren(Node *node)
+{
+    QStringList pending;
+    for (const Node *child : std::as_const(node->children)) {
+        if (child->mediaCount < 0)
+            pending << child->path;
+    }
+    if (pending.isEmpty())
+        return;
+
+    // 每块一个任务：用户展开目录时的枚举（优先级更高）可以插到还没开始的统计前面
+    const int generation = m_generation;
+    const std::shared_ptr<std::atomic_bool> cancel = m_cancel;
+    for (int i = 0; i < pending.size(); i += CountChunk) {
+        const QStringList chunk = pending.mid(i, CountChunk);
+        m_pool.start([this, chunk, generation, cancel]() {
+            QHash<QString, QPair<int, int>> counts;
+            for (const QString &path : chunk) {
+                if (cancel->load())
+                    return;
+                counts.insert(path, countDirectory(path));
+            }
+            QMetaObject::invokeMethod(this, [this, generation, counts]() {
+                applyCounts(generation, counts);
+            }, Qt::QueuedConnection);
+        }, CountPriority);
+    }
+}
+
+void FolderTreeModel::applyCounts(int generation, const QHash<QString, QPair<int, int>> &counts)
+{
+    if (generation != m_generation)
+        return;
+
+    QSet<Node *> changed;
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        Node *node = m_nodes.value(it.key());
+        if (!node || !node->parent)
+            continue;
+        node->mediaCount = it.value().first;
+        if (!node->fetched)
+            node->subdirCount = it.value().second;
+        changed.insert(node);
+    }
+    emitRowsChanged(changed);
+}
+
+void FolderTreeModel::refreshStats(const QStringList &dirs)
+{
+    if (!m_root)
+        return;
+
+    // 一个目录的统计变了，它所有上级的合计都跟着变；只关心已经加载到树里的节点
+    const QString rootPrefix = m_root->path.endsWith('/') ? m_root->path : m_root->path + '/';
+    QSet<Node *> changed;
+    for (const QString &dir : dirs) {
+        QString path = QDir::cleanPath(dir);
+        while (path.startsWith(rootPrefix)) {
+            if (Node *node = m_nodes.value(path)) {
+                if (changed.contains(node))
+                    break;      // 再往上已经处理过
+                changed.insert(node);
+            }
+            path = QFileInfo(path).path();
+        }
+    }
+    QStringList paths;
+    paths.reserve(changed.size());
+    for (const Node *node : std::as_const(changed))
+        paths << node->path;
+    loadStats(paths);
+
+    // 本层有变化的目录，拼图可能也变了（磁盘上的拼图按目录 mtime 判断是否过期）
+    for (const QString &dir : dirs) {
+        const QString path = QDir::cleanPath(dir);
+        m_mosaics.remove(path);
+        m_mosaicEmpty.remove(path);
+    }
+}
+
+void FolderTreeModel::loadStats(const QStringList &paths)
+{
+    if (paths.isEmpty())
+        return;
+
+    // 第一次取索引单例要读整个索引文件，只在工作线程里碰它；和统计一样按块送回
+    const int generation = m_generation;
+    const std::shared_ptr<std::atomic_bool> cancel = m_cancel;
+    for (int i = 0; i < paths.size(); i += CountChunk) {
+        const QStringList chunk = paths.mid(i, CountChunk);
+        m_pool.start([this, chunk, generation, cancel]() {
+            QHash<QString, FolderStats> stats;
+            QStringList missing;
+            const LibraryIndex &index = LibraryIndex::instance();
+            for (const QString &path : chunk) {
+                if (cancel->load())
+                    return;
+                FolderStats s;
+                if (index.folderStats(path, &s))
+                    stats.insert(path, s);
+                else
+                    missing << path;
+            }
+            QMetaObject::invokeMethod(this, [this, generation, stats, missing]() {
+                applyStats(generation, stats, missing);
+            }, Qt::QueuedConnection);
+        }, CountPriority);
+    }
+}
+
+void FolderTreeModel::applyStats(int generation, const QHash<QString, FolderStats> &stats,
+                                 const QStringList &missing)
+{
+    if (generation != m_generation)
+        return;
+
+    QSet<Node *> changed;
+    for (auto it = stats.cbegin(); it != stats.cend(); ++it) {
+        if (Node *node = m_nodes.value(it.key())) {
+            node->stats = it.value();
+            node->hasStats = true;
+            changed.insert(node);
+        }
+    }
+    for (const QString &path : missing) {
+        Node *node = m_nodes.value(path);
+        if (node && node->hasStats) {
+            node->hasStats = false;
+            changed.insert(node);
+        }
+    }
+    emitRowsChanged(changed);
+}
+
+void FolderTreeModel::requestMosaic(const QString &path)
+{
+    m_mosaicPending.insert(path);
+    m_mosaicPool.start([this, path]() {
+        const QImage mosaic = loadOrCreateFolderMosaic(path);
+        QMetaObject::invokeMethod(this, [this, path, mosaic]() {
+            applyMosaic(path, mosaic);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FolderTreeModel::applyMosaic(const QString &path, const QImage &mosaic)
+{
+    m_mosaicPending.remove(path);
+    if (mosaic.isNull()) {
+        m_mosaicEmpty.insert(path);
+        return;
+    }
+
+    m_mosaics.insert(path, new QIcon(QPixmap::fromImage(mosaic)));
+    if (Node *node = m_nodes.value(path)) {
+        const QModelIndex index = indexFor(node, NameColumn);
+        if (index.isValid())
+            emit dataChanged(index, index, { Qt::DecorationRole });
+    }
+}
+
+void FolderTreeModel::emitRowsChanged(const QSet<Node *> &nodes)
+{
+    // 变化的行通常是连续的兄弟节点，按父节点合并成一个 dataChanged 区间
+    QHash<Node *, QPair<int, int>> ranges;
+    for (Node *node : nodes) {
+        if (!node->parent)
+            continue;
+        const int row = node->row;
+        auto range = ranges.find(node->parent);
+        if (range == ranges.end())
+            ranges.insert(node->parent, { row, row });
+        else
+            *range = { std::min(range->first, row), std::max(range->second, row) };
+    }
+
+    for (auto it = ranges.cbegin(); it != ranges.cend(); ++it) {
+        Node *parentNode = it.key();
+        emit dataChanged(createIndex(it.value().first, 0, parentNode->children.at(it.value().first)),
+                         createIndex(it.value().second, CountColumn, parentNode->children.at(it.value().second)));
+    }
+}
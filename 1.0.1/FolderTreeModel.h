@@ -0,0 +1,100 @@
+#ifndef FOLDERTREEMODEL_H
+#define FOLDERTREEMODEL_H
+
+#pragma once
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QCache>
+#include <QPair>
+#include <QSet>
+#include <QIcon>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include "LibraryIndex.h"
+#include <atomic>
+#include <memory>
+
+// 左侧子文件夹树：根是当前目录，子目录在工作线程里按需枚举（fetchMore），
+// 视图只绘制可见行；每个目录的媒体文件数也在后台统计，统计完再填到第二列。
+// 整棵子树的统计（FolderStatsAggregator 写进索引）到了以后，第二列改显示子树合计。
+// 图标是目录内容的 2x2 拼图（FolderMosaic），行第一次绘制时才在后台生成
+class FolderTreeModel : public QAbstractItemModel {
+    Q_OBJECT
+public:
+    enum Column { NameColumn = 0, CountColumn, ColumnCount };
+    static const int PathRole = Qt::UserRole;       // 目录完整路径
+
+    explicit FolderTreeModel(const QIcon &folderIcon, QObject *parent = nullptr);
+    ~FolderTreeModel() override;
+
+    // 换根：旧树丢弃，还没回来的后台结果作废。已知子目录名（会话快照）时直接填上，不再枚举
+    void setRootPath(const QString &path, const QStringList &knownChildren = QStringList());
+    QString rootPath() const;
+    QStringList childNames() const;     // 根下已经枚举到的子目录名，还没枚举完时为空
+    bool isRootFetched() const;
+    // 这些目录的统计变了：它们和已加载的上级在工作线程里重新从索引取子树合计
+    void refreshStats(const QStringList &dirs);
+    // 目录内容变了：已加载的节点在后台重新枚举，只插入新增、删除消失的子目录，
+    // 不重置模型（展开状态、选中和滚动位置都保留）。不在树里的目录忽略
+    void refreshChildren(const QString &path);
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+signals:
+    void rootChildrenLoaded(const QStringList &names);
+
+private:
+    struct Node {
+        QString path;
+        QString name;
+        Node *parent = nullptr;
+        int row = 0;                // 在父节点 children 里的位置
+        QVector<Node *> children;
+        bool fetched = false;       // 子目录已枚举
+        bool fetching = false;
+        int mediaCount = -1;        // 本层媒体文件数，-1 表示还没统计
+        int subdirCount = -1;       // 统计时顺便得到，决定展开箭头；-1 表示未知
+        FolderStats stats;          // 子树合计，hasStats 时有效
+        bool hasStats = false;
+    };
+
+    static QString toolTip(const Node *node);
+    Node *nodeFor(const QModelIndex &index) const;
+    QModelIndex indexFor(Node *node, int column) const;
+    Node *createChild(Node *parent, const QString &name);
+    void removeSubtree(Node *node);
+    void populate(Node *node, const QStringList &names);
+    void applyChildren(int generation, const QString &path, const QStringList &names, int mediaCount);
+    void applyRefresh(int generation, const QString &path, const QStringList &names, int mediaCount);
+    void applyCounts(int generation, const QHash<QString, QPair<int, int>> &counts);
+    void loadStats(const QStringList &paths);
+    void applyStats(int generation, const QHash<QString, FolderStats> &stats, const QStringList &missing);
+    void countChildren(Node *node);
+    void emitRowsChanged(const QSet<Node *> &nodes);
+    void requestMosaic(const QString &path);
+    void applyMosaic(const QString &path, const QImage &mosaic);
+    void clearTree();
+
+    Node *m_root = nullptr;
+    QHash<QString, Node *> m_nodes;     // 路径 -> 节点，后台结果按路径找回节点
+    QIcon m_folderIcon;
+    QThreadPool m_pool;                 // 枚举和统计都是磁盘 I/O，单线程即可
+    int m_generation = 0;               // 换根时递增，旧的后台结果丢弃
+    std::shared_ptr<std::atomic_bool> m_cancel;     // 换根时置位，还在跑的枚举尽早退出
+
+    QThreadPool m_mosaicPool;           // 拼图单独排队，不挡枚举和统计
+    QCache<QString, QIcon> m_mosaics;   // 路径 -> 拼图图标
+    QSet<QString> m_mosaicPending;
+    QSet<QString> m_mosaicEmpty;        // 没有可用媒体的目录，用文件夹图标
+    static const int MosaicCacheSize = 512;
+};
+
+#endif // FOLDERTREEMODEL_H
@@ -0,0 +1,579 @@
+#include "ImageDecoder.h"
+#include "EmbeddedPreviewUtil.h"
+#include "FfmpegUtil.h"
+#include "ImageScaler.h"
+#include "ThumbnailDelegate.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QImageReader>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QtGlobal>
+
+#include <vector>
+#include <cstring>
+
+#ifdef XSM_HAVE_LIBJPEG
+#include <cstdio>
+#include <csetjmp>
+extern "C" {
+#include <jpeglib.h>
+}
+#endif
+
+#ifdef XSM_HAVE_LIBWEBP
+#include <webp/decode.h>
+#endif
+
+#ifdef XSM_HAVE_LIBTIFF
+#include <tiffio.h>
+#endif
+
+namespace {
+
+// 统一的缩略图尺寸语义：保持比例放进目标框，只缩小不放大
+QSize fitToTarget(const QSize &source, const QSize &target)
+{
+    if (source.width() <= target.width() && source.height() <= target.height())
+        return source;
+    return source.scaled(target, Qt::KeepAspectRatio);
+}
+
+QImage finishScale(const QImage &img, const QSize &target)
+{
+    if (img.isNull())
+        return img;
+    const QSize fitted = fitToTarget(img.size(), target);
+    if (fitted == img.size())
+        return img;
+    return scaleImage(img, fitted);
+}
+
+int megabytes(qint64 fileSize)
+{
+    return int(qMin<qint64>(fileSize >> 20, 10000));
+}
+
+// ---------------------------------------------------------
+// 1. RAW / HEIF 内嵌预览：只读容器结构
+// ---------------------------------------------------------
+class EmbeddedPreviewDecoder : public ImageDecoder {
+public:
+    const char *name() const override { return "embedded-preview"; }
+    bool accepts(const QString &suffix) const override
+    {
+        return isRawSuffix(suffix) || isHeifSuffix(suffix);
+    }
+    int estimateCost(const QString &, qint64) const override { return 4; }
+    QImage decode(const QString &path, const QSize &targetSize) const override
+    {
+        return loadEmbeddedPreview(path, targetSize);
+    }
+};
+
+#ifdef XSM_HAVE_LIBJPEG
+// ---------------------------------------------------------
+// 2. libjpeg-turbo：DCT 域缩放（1/2、1/4、1/8），只解出需要的像素
+// ---------------------------------------------------------
+struct JpegErrorManager {
+    jpeg_error_mgr base;
+    jmp_buf jump;
+};
+
+void jpegErrorExit(j_common_ptr cinfo)
+{
+    JpegErrorManager *err = reinterpret_cast<JpegErrorManager *>(cinfo->err);
+    longjmp(err->jump, 1);
+}
+
+void jpegSilentMessage(j_common_ptr)
+{
+}
+
+// 注意：setjmp 之后不能再构造带析构函数的局部对象，输出通过指针写回
+bool readJpeg(const uchar *data, unsigned long size, const QSize &target,
+              QImage *out, int *orientation)
+{
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager err;
+    cinfo.err = jpeg_std_error(&err.base);
+    err.base.error_exit = jpegErrorExit;
+    err.base.output_message = jpegSilentMessage;
+
+    if (setjmp(err.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, const_cast<uchar *>(data), size);
+    jpeg_save_markers(&cinfo, JPEG_APP0 + 1, 0xFFFF);
+    jpeg_read_header(&cinfo, TRUE);
+
+    // CMYK/YCCK 交给 Qt 处理
+    if (cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    for (jpeg_saved_marker_ptr m = cinfo.marker_list; m; m = m->next) {
+        if (m->marker == JPEG_APP0 + 1 && m->data_length > 6
+            && std::memcmp(m->data, "Exif\0\0", 6) == 0) {
+            *orientation = exifOrientation(
+                QByteArray::fromRawData(reinterpret_cast<const char *>(m->data),
+                                        int(m->data_length)));
+            break;
+        }
+    }
+
+    // 旋转 90° 的图片，放进目标框时宽高互换
+    QSize source(int(cinfo.image_width), int(cinfo.image_height));
+    if (*orientation >= 5)
+        source.transpose();
+    QSize fitted = fitToTarget(source, target);
+    if (*orientation >= 5) {
+        source.transpose();
+        fitted.transpose();
+    }
+
+    // 选最大的 1/N，使 DCT 缩放后的输出仍不小于最终尺寸
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = 1;
+    for (unsigned int denom = 8; denom > 1; denom /= 2) {
+        if (source.width() / int(denom) >= fitted.width() &&
+            source.height() / int(denom) >= fitted.height()) {
+            cinfo.scale_denom = denom;
+            break;
+        }
+    }
+
+    QImage::Format format = QImage::Format_RGB888;
+#if defined(JCS_EXTENSIONS) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    cinfo.out_color_space = JCS_EXT_BGRX;
+    format = QImage::Format_RGB32;
+#else
+    cinfo.out_color_space = JCS_RGB;
+#endif
+
+    jpeg_start_decompress(&cinfo);
+    *out = QImage(int(cinfo.output_width), int(cinfo.output_height), format);
+    if (out->isNull()) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = out->scanLine(int(cinfo.output_scanline));
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+class JpegTurboDecoder : public ImageDecoder {
+public:
+    const char *name() const override { return "libjpeg-turbo"; }
+    bool accepts(const QString &suffix) const override
+    {
+        return suffix == "jpg" || suffix == "jpeg";
+    }
+    int estimateCost(const QString &, qint64 fileSize) const override
+    {
+        return 2 + megabytes(fileSize);
+    }
+    QImage decode(const QString &path, const QSize &targetSize) const override
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly) || file.size() <= 0)
+            return QImage();
+
+        // 直接映射文件，避免整份读入内存
+        const qint64 size = file.size();
+        const uchar *data = file.map(0, size);
+        QByteArray fallback;
+        if (!data) {
+            fallback = file.readAll();
+            data = reinterpret_cast<const uchar *>(fallback.constData());
+        }
+
+        QImage img;
+        int orientation = 1;
+        if (!readJpeg(data, static_cast<unsigned long>(size), targetSize, &img, &orientation))
+            return QImage();
+
+        return finishScale(applyExifOrientation(img, orientation), targetSize);
+    }
+};
+#endif // XSM_HAVE_LIBJPEG
+
+#ifdef XSM_HAVE_LIBWEBP
+// ---------------------------------------------------------
+// 3. libwebp：解码器内置缩放，直接输出目标尺寸
+// ---------------------------------------------------------
+class WebpDecoder : public ImageDecoder {
+public:
+    const char *name() const override { return "libwebp"; }
+    bool accepts(const QString &suffix) const override { return suffix == "webp"; }
+    int estimateCost(const QString &, qint64 fileSize) const override
+    {
+        return 3 + 2 * megabytes(fileSize);
+    }
+    QImage decode(const QString &path, const QSize &targetSize) const override
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly) || file.size() <= 0)
+            return QImage();
+
+        const qint64 size = file.size();
+        const uchar *data = file.map(0, size);
+        QByteArray fallback;
+        if (!data) {
+            fallback = file.readAll();
+            data = reinterpret_cast<const uchar *>(fallback.constData());
+        }
+
+        WebPDecoderConfig config;
+        if (!WebPInitDecoderConfig(&config))
+            return QImage();
+        if (WebPGetFeatures(data, size_t(size), &config.input) != VP8_STATUS_OK)
+            return QImage();
+        // 动图交给后面的解码器
+        if (config.input.has_animation)
+            return QImage();
+
+        const QSize source(config.input.width, config.input.height);
+        const QSize fitted = fitToTarget(source, targetSize);
+        if (fitted != source) {
+            config.options.use_scaling = 1;
+            config.options.scaled_width = fitted.width();
+            config.options.scaled_height = fitted.height();
+        }
+
+        QImage img(fitted, QImage::Format_ARGB32_Premultiplied);
+        if (img.isNull())
+            return QImage();
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        config.output.colorspace = MODE_bgrA;
+#else
+        config.output.colorspace = MODE_Argb;
+#endif
+        config.output.is_external_memory = 1;
+        config.output.u.RGBA.rgba = img.bits();
+        config.output.u.RGBA.stride = int(img.bytesPerLine());
+        config.output.u.RGBA.size = size_t(img.sizeInBytes());
+
+        const VP8StatusCode status = WebPDecode(data, size_t(size), &config);
+        WebPFreeDecBuffer(&config.output);
+        return status == VP8_STATUS_OK ? img : QImage();
+    }
+};
+#endif // XSM_HAVE_LIBWEBP
+
+#ifdef XSM_HAVE_LIBTIFF
+// ---------------------------------------------------------
+// 4. libtiff：逐条带/逐瓦片读取并就地做盒式降采样
+//    内存只占一条带 + 目标尺寸，超大 TIFF 也不会整张展开
+// ---------------------------------------------------------
+class TiffStripDecoder : public ImageDecoder {
+public:
+    TiffStripDecoder()
+    {
+        // 关闭 libtiff 默认打印到 stderr 的告警
+        TIFFSetErrorHandler(nullptr);
+        TIFFSetWarningHandler(nullptr);
+    }
+
+    const char *name() const override { return "libtiff-strips"; }
+    bool accepts(const QString &suffix) const override
+    {
+        return suffix == "tif" || suffix == "tiff";
+    }
+    int estimateCost(const QString &, qint64 fileSize) const override
+    {
+        return 5 + 4 * megabytes(fileSize);
+    }
+
+    QImage decode(const QString &path, const QSize &targetSize) const override
+    {
+#ifdef Q_OS_WIN
+        TIFF *tif = TIFFOpenW(reinterpret_cast<const wchar_t *>(path.utf16()), "r");
+#else
+        TIFF *tif = TIFFOpen(QFile::encodeName(path).constData(), "r");
+#endif
+        if (!tif)
+            return QImage();
+
+        QImage img = decodeDirectory(tif, targetSize);
+        TIFFClose(tif);
+        return finishScale(img, targetSize);
+    }
+
+private:
+    // 金字塔 TIFF：挑选不小于目标尺寸的最小降采样层
+    static void selectDirectory(TIFF *tif, const QSize &targetSize)
+    {
+        uint32_t w0 = 0, h0 = 0;
+        TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &w0);
+        TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &h0);
+        if (w0 == 0 || h0 == 0)
+            return;
+        const QSize fitted = fitToTarget(QSize(int(w0), int(h0)), targetSize);
+
+        tdir_t best = 0;
+        quint64 bestArea = quint64(w0) * h0;
+        for (tdir_t dir = 1; dir < 32 && TIFFSetDirectory(tif, dir); ++dir) {
+            uint32_t type = 0, w = 0, h = 0;
+            TIFFGetFieldDefaulted(tif, TIFFTAG_SUBFILETYPE, &type);
+            TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &w);
+            TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &h);
+            if (!(type & FILETYPE_REDUCEDIMAGE) || w == 0 || h == 0)
+                continue;
+            // 比例不一致的多页 TIFF 不算降采样层
+            if (qAbs(double(w) / h - double(w0) / h0) > 0.02)
+                continue;
+            if (int(w) >= fitted.width() && int(h) >= fitted.height()
+                && quint64(w) * h < bestArea) {
+                best = dir;
+                bestArea = quint64(w) * h;
+            }
+        }
+        TIFFSetDirectory(tif, best);
+    }
+
+    static QImage decodeDirectory(TIFF *tif, const QSize &targetSize)
+    {
+        selectDirectory(tif, targetSize);
+
+        uint32_t w = 0, h = 0;
+        TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &w);
+        TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &h);
+        if (w == 0 || h == 0)
+            return QImage();
+
+        QSize out = fitToTarget(QSize(int(w), int(h)), targetSize);
+        out = out.boundedTo(QSize(int(w), int(h)));
+        const int ow = qMax(1, out.width());
+        const int oh = qMax(1, out.height());
+
+        std::vector<int> colMap(w);
+        for (uint32_t x = 0; x < w; ++x)
+            colMap[x] = int(quint64(x) * ow / w);
+
+        // 每个目标像素累加 R/G/B/A 与采样数
+        std::vector<quint32> sums(size_t(ow) * oh * 4, 0);
+        std::vector<quint32> counts(size_t(ow) * oh, 0);
+
+        auto accumulateRow = [&](uint32_t y, const uint32_t *row, uint32_t x0, uint32_t n) {
+            const int ty = int(quint64(y) * oh / h);
+            quint32 *sumRow = sums.data() + size_t(ty) * ow * 4;
+            quint32 *countRow = counts.data() + size_t(ty) * ow;
+            for (uint32_t i = 0; i < n; ++i) {
+                const uint32_t p = row[i];
+                const int tx = colMap[x0 + i];
+                quint32 *s = sumRow + tx * 4;
+                s[0] += TIFFGetR(p);
+                s[1] += TIFFGetG(p);
+                s[2] += TIFFGetB(p);
+                s[3] += TIFFGetA(p);
+                ++countRow[tx];
+            }
+        };
+
+        if (TIFFIsTiled(tif)) {
+            uint32_t tw = 0, th = 0;
+            TIFFGetField(tif, TIFFTAG_TILEWIDTH, &tw);
+            TIFFGetField(tif, TIFFTAG_TILELENGTH, &th);
+            if (tw == 0 || th == 0)
+                return QImage();
+            std::vector<uint32_t> tile(size_t(tw) * th);
+            for (uint32_t y = 0; y < h; y += th) {
+                for (uint32_t x = 0; x < w; x += tw) {
+                    if (!TIFFReadRGBATile(tif, x, y, tile.data()))
+                        return QImage();
+                    const uint32_t cols = qMin(tw, w - x);
+                    // RGBA 接口的栅格原点在左下角
+                    for (uint32_t r = 0; r < th && y + r < h; ++r)
+                        accumulateRow(y + r, tile.data() + size_t(th - 1 - r) * tw, x, cols);
+                }
+            }
+        } else {
+            uint32_t rowsPerStrip = 0;
+            TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+            rowsPerStrip = qBound<uint32_t>(1, rowsPerStrip, h);
+            std::vector<uint32_t> strip(size_t(w) * rowsPerStrip);
+            for (uint32_t y = 0; y < h; y += rowsPerStrip) {
+                if (!TIFFReadRGBAStrip(tif, y, strip.data()))
+                    return QImage();
+                const uint32_t rows = qMin(rowsPerStrip, h - y);
+                for (uint32_t r = 0; r < rows; ++r)
+                    accumulateRow(y + r, strip.data() + size_t(rows - 1 - r) * w, 0, w);
+            }
+        }
+
+        QImage img(ow, oh, QImage::Format_ARGB32);
+        for (int y = 0; y < oh; ++y) {
+            QRgb *line = reinterpret_cast<QRgb *>(img.scanLine(y));
+            const quint32 *s = sums.data() + size_t(y) * ow * 4;
+            const quint32 *c = counts.data() + size_t(y) * ow;
+            for (int x = 0; x < ow; ++x) {
+                const quint32 n = qMax<quint32>(1, c[x]);
+                line[x] = qRgba(int(s[x * 4] / n), int(s[x * 4 + 1] / n),
+                                int(s[x * 4 + 2] / n), int(s[x * 4 + 3] / n));
+            }
+        }
+        return img;
+    }
+};
+#endif // XSM_HAVE_LIBTIFF
+
+// ---------------------------------------------------------
+// 5. Qt 自带解码器：PNG/BMP/GIF 以及未编译进专用库时的 JPEG/WebP/TIFF
+// ---------------------------------------------------------
+class QtImageDecoder : public ImageDecoder {
+public:
+    const char *name() const override { return "qt"; }
+    bool accepts(const QString &) const override { return true; }
+    int estimateCost(const QString &suffix, qint64 fileSize) const override
+    {
+        // Qt 的 jpeg 插件支持 DCT 缩放，PNG 只能整张解码后再缩
+        if (suffix == "jpg" || suffix == "jpeg")
+            return 3 + 2 * megabytes(fileSize);
+        if (suffix == "png")
+            return 5 + 8 * megabytes(fileSize);
+        return 5 + 4 * megabytes(fileSize);
+    }
+    QImage decode(const QString &path, const QSize &targetSize) const override
+    {
+        QImageReader reader(path);
+        reader.setAutoTransform(true);
+        if (!reader.canRead())
+            return QImage();
+
+        // 只有 jpeg 插件能在解码阶段缩小（DCT 缩放），其余格式整张解码后交给 SIMD 缩放
+        const QByteArray format = reader.format();
+        const QSize size = reader.size();
+        if (format == "jpeg" && size.isValid())
+            reader.setScaledSize(fitToTarget(size, targetSize));
+        return finishScale(reader.read(), targetSize);
+    }
+};
+
+// ---------------------------------------------------------
+// 6. ffmpeg：进程内解码器都失败时的最后手段，只对确实需要的格式启用
+// ---------------------------------------------------------
+class FfmpegImageDecoder : public ImageDecoder {
+public:
+    const char *name() const override { return "ffmpeg"; }
+    bool accepts(const QString &suffix) const override
+    {
+        return suffix == "webp" || isHeifSuffix(suffix);
+    }
+    int estimateCost(const QString &, qint64) const override { return 150; }
+    bool spawnsProcess() const override { return true; }
+    QImage decode(const QString &path, const QSize &targetSize) const override
+    {
+        // 准备缓存路径
+        QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        QDir().mkpath(cacheDir);
+        QByteArray hash = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Md5);
+        QString cacheFile = cacheDir + "/thumb_img_" + hash.toHex() + ".jpg";
+
+        // 缓存只按路径区分，所以固定按最大档位生成，各档位都从它缩出（与视频截帧缓存一致）；
+        // 旧版本按请求档位生成的小缓存宽度对不上，重新生成
+        const int cacheWidth = ThumbnailDelegate::MaxMipLevel;
+        if (QFile::exists(cacheFile) && QImageReader(cacheFile).size().width() != cacheWidth)
+            QFile::remove(cacheFile);
+
+        // 如果缓存不存在，调用 ffmpeg 转换第一帧
+        if (!QFile::exists(cacheFile)) {
+            QStringList args;
+            // HEIF：只转码内嵌的 HEVC 缩略图码流，而不是整张网格拼接的大图
+            const QString streamFile = cacheDir + "/thumb_img_" + hash.toHex() + ".hevc";
+            const QString suffix = QFileInfo(path).suffix().toLower();
+            if (isHeifSuffix(suffix) && writeHeifThumbnailStream(path, streamFile))
+                args << "-f" << "hevc" << "-i" << streamFile;
+            else
+                args << "-i" << path;
+
+            args << "-frames:v" << "1"
+                 << "-q:v" << "5"
+                 << "-vf" << QString("scale=%1:-1").arg(cacheWidth)
+                 << cacheFile << "-y";
+
+            runFfmpegBlocking(args);
+            QFile::remove(streamFile);
+        }
+
+        // 缓存文件同样走缩放解码，而不是整张 load
+        QImageReader reader(cacheFile);
+        if (!reader.canRead())
+            return QImage();
+        const QSize size = reader.size();
+        if (size.isValid())
+            reader.setScaledSize(fitToTarget(size, targetSize));
+        return reader.read();
+    }
+};
+
+} // namespace
+
+ImageDecoderRegistry::ImageDecoderRegistry()
+{
+    registerDecoder(new EmbeddedPreviewDecoder);
+#ifdef XSM_HAVE_LIBJPEG
+    registerDecoder(new JpegTurboDecoder);
+#endif
+#ifdef XSM_HAVE_LIBWEBP
+    registerDecoder(new WebpDecoder);
+#endif
+#ifdef XSM_HAVE_LIBTIFF
+    registerDecoder(new TiffStripDecoder);
+#endif
+    registerDecoder(new QtImageDecoder);
+    registerDecoder(new FfmpegImageDecoder);
+}
+
+ImageDecoderRegistry::~ImageDecoderRegistry()
+{
+    qDeleteAll(m_decoders);
+}
+
+ImageDecoderRegistry &ImageDecoderRegistry::instance()
+{
+    static ImageDecoderRegistry registry;
+    return registry;
+}
+
+void ImageDecoderRegistry::registerDecoder(ImageDecoder *decoder)
+{
+    if (decoder)
+        m_decoders.append(decoder);
+}
+
+int ImageDecoderRegistry::estimateCost(const QString &suffix, qint64 fileSize) const
+{
+    for (const ImageDecoder *decoder : m_decoders) {
+        if (decoder->accepts(suffix))
+            return decoder->estimateCost(suffix, fileSize);
+    }
+    return 1000;
+}
+
+QImage ImageDecoderRegistry::decode(const QString &path, const QSize &targetSize,
+                                    bool allowSubprocess) const
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    for (const ImageDecoder *decoder : m_decoders) {
+        if (!decoder->accepts(suffix) || (!allowSubprocess && decoder->spawnsProcess()))
+            continue;
+        const QImage img = decoder->decode(path, targetSize);
+        if (!img.isNull())
+            return img;
+    }
+    return QImage();
+}
@@ -0,0 +1,51 @@
+#ifndef IMAGEDECODER_H
+#define IMAGEDECODER_H
+
+#pragma once
+#include <QString>
+#include <QImage>
+#include <QSize>
+#include <QList>
+
+// 单个格式的解码器：声明自己能处理的后缀，并给出生成缩略图的预估代价
+class ImageDecoder {
+public:
+    virtual ~ImageDecoder() = default;
+
+    virtual const char *name() const = 0;
+    virtual bool accepts(const QString &suffix) const = 0;
+
+    // 预估代价（约等于毫秒），只看后缀和文件大小，不做任何 I/O，可在 GUI 线程调用
+    virtual int estimateCost(const QString &suffix, qint64 fileSize) const = 0;
+
+    // 解码并缩放到 targetSize 以内（保持比例）；失败返回空图，由下一个解码器接手
+    virtual QImage decode(const QString &path, const QSize &targetSize) const = 0;
+
+    // 需要启动外部进程（ffmpeg）：后台预热等场景按此跳过
+    virtual bool spawnsProcess() const { return false; }
+};
+
+// 解码器注册表：按注册顺序（即优先级）把每种格式路由到最快的可用解码器
+// 默认顺序：内嵌预览 -> libjpeg-turbo -> libwebp -> libtiff -> Qt -> ffmpeg
+class ImageDecoderRegistry {
+public:
+    static ImageDecoderRegistry &instance();
+    ~ImageDecoderRegistry();
+
+    // 追加一个解码器（接管所有权）；只应在启动阶段、缩略图线程开始工作前调用
+    void registerDecoder(ImageDecoder *decoder);
+
+    // 取第一个能处理该后缀的解码器的代价，调度器据此先做便宜的任务
+    int estimateCost(const QString &suffix, qint64 fileSize) const;
+
+    // allowSubprocess 为 false 时跳过需要启动外部进程的解码器（预热、文件夹拼图）
+    QImage decode(const QString &path, const QSize &targetSize, bool allowSubprocess = true) const;
+
+private:
+    ImageDecoderRegistry();
+    Q_DISABLE_COPY(ImageDecoderRegistry)
+
+    QList<ImageDecoder *> m_decoders;
+};
+
+#endif // IMAGEDECODER_H
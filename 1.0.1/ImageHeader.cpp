@@ -0,0 +1,240 @@
+#include "ImageHeader.h"
+#include "BinaryReader.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QByteArray>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace {
+
+// 跳过的 JPEG 段 / WebP 块数量上限，防止损坏文件造成长时间循环
+const int MaxSegmentCount = 64;
+// IFD0 只看前这么多项，方向和宽高都在最前面
+const int MaxIfdEntries = 64;
+
+bool isTiffSuffix(const QString &suffix)
+{
+    return suffix.compare("tif", Qt::CaseInsensitive) == 0
+           || suffix.compare("tiff", Qt::CaseInsensitive) == 0;
+}
+
+quint32 le24(const uchar *p) { return quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16); }
+
+// ---------------------------------------------------------
+// TIFF 结构：TIFF 文件本身，以及 JPEG APP1 / WebP EXIF 块里的 EXIF
+// base 为 TIFF 头在文件中的位置，IFD 内的偏移都相对于它；limit 为可读范围的末尾
+// ---------------------------------------------------------
+bool parseTiff(QIODevice *dev, qint64 base, qint64 limit, ImageHeaderInfo *info, bool wantSize)
+{
+    uchar head[8];
+    if (base + 8 > limit || !readAt(dev, base, reinterpret_cast<char *>(head), 8))
+        return false;
+
+    bool little;
+    if (std::memcmp(head, "II*\0", 4) == 0)
+        little = true;
+    else if (std::memcmp(head, "MM\0*", 4) == 0)
+        little = false;
+    else
+        return false;
+
+    auto u16 = [little](const uchar *p) { return little ? le16(p) : be16(p); };
+    auto u32 = [little](const uchar *p) { return little ? le32(p) : be32(p); };
+
+    const qint64 ifd = base + u32(head + 4);
+    uchar countBuf[2];
+    if (ifd + 2 > limit || !readAt(dev, ifd, reinterpret_cast<char *>(countBuf), 2))
+        return false;
+
+    const int count = qMin<int>(u16(countBuf), MaxIfdEntries);
+    const qint64 bytes = qMin<qint64>(qint64(count) * 12, limit - ifd - 2);
+    QByteArray entries(int(qMax<qint64>(0, bytes)), Qt::Uninitialized);
+    if (!readAt(dev, ifd + 2, entries.data(), entries.size()))
+        return false;
+
+    int width = 0, height = 0;
+    const uchar *p = reinterpret_cast<const uchar *>(entries.constData());
+    for (int i = 0; i + 12 <= entries.size(); i += 12) {
+        const quint16 tag = u16(p + i);
+        const quint16 type = u16(p + i + 2);
+        // SHORT 存在值字段的前两个字节，LONG 占满四个字节
+        quint32 value;
+        if (type == 3)
+            value = u16(p + i + 8);
+        else if (type == 4)
+            value = u32(p + i + 8);
+        else
+            continue;
+
+        if (tag == 0x0100)
+            width = int(value);
+        else if (tag == 0x0101)
+            height = int(value);
+        else if (tag == 0x0112 && value >= 1 && value <= 8)
+            info->orientation = int(value);
+    }
+
+    if (wantSize) {
+        if (width <= 0 || height <= 0)
+            return false;
+        info->size = QSize(width, height);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------
+// JPEG：逐段跳过，只读每段的 4 字节段头；APP1 里取方向，遇到 SOF 取尺寸后结束
+// ---------------------------------------------------------
+bool parseJpeg(QIODevice *dev, ImageHeaderInfo *info)
+{
+    qint64 pos = 2;
+    for (int i = 0; i < MaxSegmentCount; ++i) {
+        uchar seg[4];
+        if (!readAt(dev, pos, reinterpret_cast<char *>(seg), 4) || seg[0] != 0xFF)
+            return false;
+
+        const uchar marker = seg[1];
+        if (marker == 0xFF) {          // 填充字节
+            pos += 1;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            pos += 2;
+            continue;
+        }
+        if (marker == 0xD9 || marker == 0xDA) // 到了图像数据还没有 SOF
+            return false;
+
+        const int len = be16(seg + 2);
+        if (len < 2)
+            return false;
+
+        // SOF0..SOF15，排除 DHT(C4)、JPG(C8)、DAC(CC)
+        if (marker >= 0xC0 && marker <= 0xCF
+            && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            uchar sof[5];
+            if (!readAt(dev, pos + 4, reinterpret_cast<char *>(sof), 5))
+                return false;
+            const int height = be16(sof + 1);
+            const int width = be16(sof + 3);
+            if (width <= 0 || height <= 0)
+                return false;
+            info->size = QSize(width, height);
+            return true;
+        }
+
+        if (marker == 0xE1 && len >= 16) {
+            char exif[6];
+            if (readAt(dev, pos + 4, exif, 6) && std::memcmp(exif, "Exif\0\0", 6) == 0)
+                parseTiff(dev, pos + 10, pos + 2 + len, info, false);
+        }
+
+        pos += 2 + len;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------
+// WebP：尺寸在第一个块里；VP8X 标记了 EXIF 时再沿块头跳到 EXIF 块取方向
+// ---------------------------------------------------------
+bool parseWebp(QIODevice *dev, const uchar *h, qint64 headLen, ImageHeaderInfo *info)
+{
+    if (headLen < 30)
+        return false;
+
+    if (std::memcmp(h + 12, "VP8 ", 4) == 0) {
+        // 有损：3 字节帧标记 + 起始码 9d 01 2a，之后是 14 位宽高
+        if (h[23] != 0x9d || h[24] != 0x01 || h[25] != 0x2a)
+            return false;
+        info->size = QSize(le16(h + 26) & 0x3fff, le16(h + 28) & 0x3fff);
+    } else if (std::memcmp(h + 12, "VP8L", 4) == 0) {
+        // 无损：签名 0x2f，之后两个 14 位的 (尺寸 - 1)
+        if (h[20] != 0x2f)
+            return false;
+        const quint32 bits = le32(h + 21);
+        info->size = QSize(int(bits & 0x3fff) + 1, int((bits >> 14) & 0x3fff) + 1);
+    } else if (std::memcmp(h + 12, "VP8X", 4) == 0) {
+        info->size = QSize(int(le24(h + 24)) + 1, int(le24(h + 27)) + 1);
+
+        if (h[20] & 0x08) {
+            const qint64 riffEnd = 8 + qint64(le32(h + 4));
+            qint64 pos = 12;
+            for (int i = 0; i < MaxSegmentCount && pos + 8 <= riffEnd; ++i) {
+                uchar chunk[8];
+                if (!readAt(dev, pos, reinterpret_cast<char *>(chunk), 8))
+                    break;
+                const qint64 size = le32(chunk + 4);
+                if (std::memcmp(chunk, "EXIF", 4) == 0) {
+                    // 规范里是裸 TIFF 头，但有些工具会带上 JPEG 风格的 "Exif\0\0"
+                    qint64 base = pos + 8;
+                    char prefix[6];
+                    if (readAt(dev, base, prefix, 6) && std::memcmp(prefix, "Exif\0\0", 6) == 0)
+                        base += 6;
+                    parseTiff(dev, base, pos + 8 + size, info, false);
+                    break;
+                }
+                pos += 8 + size + (size & 1);
+            }
+        }
+    } else {
+        return false;
+    }
+    return !info->size.isEmpty();
+}
+
+} // namespace
+
+ImageHeaderInfo readImageHeader(const QString &path)
+{
+    ImageHeaderInfo info;
+
+    // 不用缓冲：QFile 默认每次预读 16 KB，而这里只需要几十字节
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+        return info;
+
+    uchar h[30];
+    const qint64 headLen = f.read(reinterpret_cast<char *>(h), sizeof(h));
+    if (headLen < 10)
+        return info;
+
+    bool ok = false;
+    if (h[0] == 0xFF && h[1] == 0xD8) {
+        info.format = "jpeg";
+        ok = parseJpeg(&f, &info);
+    } else if (headLen >= 24 && std::memcmp(h, "\x89PNG\r\n\x1a\n", 8) == 0
+               && std::memcmp(h + 12, "IHDR", 4) == 0) {
+        info.format = "png";
+        info.size = QSize(int(be32(h + 16)), int(be32(h + 20)));
+        ok = !info.size.isEmpty();
+    } else if (std::memcmp(h, "GIF87a", 6) == 0 || std::memcmp(h, "GIF89a", 6) == 0) {
+        info.format = "gif";
+        info.size = QSize(le16(h + 6), le16(h + 8));
+        ok = !info.size.isEmpty();
+    } else if (headLen >= 26 && h[0] == 'B' && h[1] == 'M') {
+        info.format = "bmp";
+        const quint32 dibSize = le32(h + 14);
+        if (dibSize == 12) {            // BITMAPCOREHEADER：16 位宽高
+            info.size = QSize(le16(h + 18), le16(h + 20));
+        } else if (dibSize >= 40) {     // 高度为负表示自上而下存储
+            info.size = QSize(qAbs(qint32(le32(h + 18))), qAbs(qint32(le32(h + 22))));
+        }
+        ok = !info.size.isEmpty();
+    } else if (headLen >= 16 && std::memcmp(h, "RIFF", 4) == 0 && std::memcmp(h + 8, "WEBP", 4) == 0) {
+        info.format = "webp";
+        ok = parseWebp(&f, h, headLen, &info);
+    } else if ((std::memcmp(h, "II*\0", 4) == 0 || std::memcmp(h, "MM\0*", 4) == 0)
+               && isTiffSuffix(QFileInfo(path).suffix())) {
+        // CR2/NEF/ARW/DNG 等 RAW 也是 TIFF 结构，但 IFD0 常常是小预览图，这些交给 QImageReader
+        info.format = "tiff";
+        ok = parseTiff(&f, 0, f.size(), &info, true);
+    }
+
+    if (!ok)
+        return ImageHeaderInfo();
+    info.valid = true;
+    return info;
+}
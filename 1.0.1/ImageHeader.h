@@ -0,0 +1,27 @@
+#ifndef IMAGEHEADER_H
+#define IMAGEHEADER_H
+
+#pragma once
+#include <QString>
+#include <QSize>
+
+// 只读文件头拿图片尺寸和 EXIF 方向：JPEG（SOF/APP1）、PNG（IHDR）、GIF、BMP、
+// WebP（VP8/VP8L/VP8X）、TIFF（IFD0）。不解码像素，每个文件只读几百字节，
+// 目录枚举时可以批量调用
+
+struct ImageHeaderInfo {
+    bool valid = false;
+    QString format;             // "jpeg" / "png" / "gif" / "bmp" / "webp" / "tiff"
+    QSize size;                 // 文件中存储的像素尺寸
+    int orientation = 1;        // EXIF Orientation，1..8；没有记录时为 1
+
+    // 按方向旋转后的显示尺寸（5..8 需要宽高互换）
+    QSize displaySize() const {
+        return orientation >= 5 && orientation <= 8 ? size.transposed() : size;
+    }
+};
+
+// 无法识别的格式（HEIF、RAW 等）返回 valid = false，调用方自行回退到 QImageReader
+ImageHeaderInfo readImageHeader(const QString &path);
+
+#endif // IMAGEHEADER_H
@@ -0,0 +1,482 @@
+#include "ImageScaler.h"
+
+#include <QtGlobal>
+#include <QByteArray>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define XSM_SCALER_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang 需要按函数开启指令集，MSVC 直接可用内建函数
+#if defined(XSM_SCALER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define XSM_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define XSM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define XSM_TARGET_SSE41
+#define XSM_TARGET_AVX2
+#endif
+
+namespace {
+
+// 像素按 32 位 ARGB（预乘）处理；小端内存顺序为 B G R A
+const int AlphaByte = (Q_BYTE_ORDER == Q_LITTLE_ENDIAN) ? 3 : 0;
+
+// 权重用 1.14 定点数，int16 足以容纳 Lanczos 的正负瓣
+const int WeightBits = 14;
+const int WeightOne = 1 << WeightBits;
+const int WeightRound = 1 << (WeightBits - 1);
+const double Pi = 3.14159265358979323846;
+
+// ---------------------------------------------------------
+// 权重表：每个输出像素使用同样宽度（taps）的输入窗口，便于向量化
+// ---------------------------------------------------------
+struct Coeffs {
+    int taps = 0;
+    std::vector<int> start;       // 每个输出像素窗口的首个输入下标
+    std::vector<int16_t> weights; // outSize * taps
+};
+
+double sinc(double x)
+{
+    if (x == 0.0)
+        return 1.0;
+    x *= Pi;
+    return std::sin(x) / x;
+}
+
+double lanczos3(double x)
+{
+    if (x <= -3.0 || x >= 3.0)
+        return 0.0;
+    return sinc(x) * sinc(x / 3.0);
+}
+
+double triangle(double x)
+{
+    x = std::fabs(x);
+    return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+Coeffs computeCoeffs(int inSize, int outSize, ScaleKernel kernel)
+{
+    const double scale = double(inSize) / outSize;
+    const double filterScale = std::max(scale, 1.0);
+    // 缩小时面积平均按真实覆盖长度计权；放大时退化为双线性
+    const bool area = kernel == ScaleKernel::AreaAverage && scale >= 1.0;
+    const double radius = kernel == ScaleKernel::Lanczos3 ? 3.0 : 1.0;
+    const double support = radius * filterScale;
+
+    int bound = area ? int(std::ceil(scale)) + 1 : 2 * int(std::ceil(support)) + 1;
+    bound += bound & 1; // 偶数个抽头，SIMD 每次处理一对
+    Coeffs c;
+    c.taps = std::min(bound, inSize);
+    c.start.resize(outSize);
+    c.weights.assign(size_t(outSize) * c.taps, 0);
+
+    std::vector<double> w(c.taps);
+    for (int i = 0; i < outSize; ++i) {
+        const double center = (i + 0.5) * scale;
+        int lo, hi;
+        if (area) {
+            const double begin = i * scale;
+            const double end = (i + 1) * scale;
+            lo = std::max(0, int(std::floor(begin)));
+            hi = std::min(inSize, int(std::ceil(end)));
+            for (int j = lo; j < hi; ++j)
+                w[j - lo] = std::min(end, double(j + 1)) - std::max(begin, double(j));
+        } else {
+            lo = std::max(0, int(std::floor(center - support)));
+            hi = std::min(inSize, int(std::ceil(center + support)));
+            for (int j = lo; j < hi; ++j) {
+                const double x = (j + 0.5 - center) / filterScale;
+                w[j - lo] = kernel == ScaleKernel::Lanczos3 ? lanczos3(x) : triangle(x);
+            }
+        }
+        hi = std::min(hi, lo + c.taps);
+
+        double sum = 0.0;
+        for (int j = lo; j < hi; ++j)
+            sum += w[j - lo];
+        if (sum == 0.0)
+            sum = 1.0;
+
+        // 窗口整体左移，保证 [start, start + taps) 不越界
+        const int start = std::max(0, std::min(lo, inSize - c.taps));
+        c.start[i] = start;
+        int16_t *out = &c.weights[size_t(i) * c.taps];
+
+        int total = 0;
+        int peak = lo - start;
+        for (int j = lo; j < hi; ++j) {
+            const int q = int(std::lround(w[j - lo] / sum * WeightOne));
+            out[j - start] = int16_t(q);
+            total += q;
+            if (q > out[peak])
+                peak = j - start;
+        }
+        // 量化误差补到最大的权重上，保证总和严格为 1.0
+        out[peak] = int16_t(out[peak] + (WeightOne - total));
+    }
+    return c;
+}
+
+inline uint8_t clampByte(int32_t v)
+{
+    v >>= WeightBits;
+    return uint8_t(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+// 预乘格式要求颜色分量不超过 alpha（Lanczos 的过冲可能破坏这一点）
+inline void storePixel(uint8_t *d, const int32_t *acc)
+{
+    const uint8_t a = clampByte(acc[AlphaByte]);
+    for (int ch = 0; ch < 4; ++ch)
+        d[ch] = ch == AlphaByte ? a : std::min(clampByte(acc[ch]), a);
+}
+
+// ---------------------------------------------------------
+// 标量实现（任何 CPU 都可用，也是 SIMD 行尾的兜底）
+// ---------------------------------------------------------
+void horizontalScalar(const uint8_t *src, uint8_t *dst, int dstW, const Coeffs &c)
+{
+    for (int x = 0; x < dstW; ++x) {
+        const uint8_t *p = src + size_t(c.start[x]) * 4;
+        const int16_t *w = &c.weights[size_t(x) * c.taps];
+        int32_t acc[4] = { WeightRound, WeightRound, WeightRound, WeightRound };
+        for (int k = 0; k < c.taps; ++k) {
+            for (int ch = 0; ch < 4; ++ch)
+                acc[ch] += int32_t(p[k * 4 + ch]) * w[k];
+        }
+        storePixel(dst + size_t(x) * 4, acc);
+    }
+}
+
+void verticalScalarRange(const uint8_t *const *rows, uint8_t *dst, int from, int rowBytes,
+                         const int16_t *w, int taps)
+{
+    for (int i = from; i < rowBytes; i += 4) {
+        int32_t acc[4] = { WeightRound, WeightRound, WeightRound, WeightRound };
+        for (int k = 0; k < taps; ++k) {
+            for (int ch = 0; ch < 4; ++ch)
+                acc[ch] += int32_t(rows[k][i + ch]) * w[k];
+        }
+        storePixel(dst + i, acc);
+    }
+}
+
+void verticalScalar(const uint8_t *const *rows, uint8_t *dst, int rowBytes,
+                    const int16_t *w, int taps)
+{
+    verticalScalarRange(rows, dst, 0, rowBytes, w, taps);
+}
+
+#ifdef XSM_SCALER_X86
+// 把一对权重打包成 madd 需要的 (w0, w1) 16 位交错形式
+inline int packWeights(int16_t w0, int16_t w1)
+{
+    return int(uint32_t(uint16_t(w0)) | (uint32_t(uint16_t(w1)) << 16));
+}
+
+// ---------------------------------------------------------
+// SSE4.1：水平方向一次处理两个输入像素，垂直方向一次处理 4 个输出像素
+// ---------------------------------------------------------
+XSM_TARGET_SSE41
+void horizontalSse41(const uint8_t *src, uint8_t *dst, int dstW, const Coeffs &c)
+{
+    // 两个像素 a/b 的字节交错为 a0 b0 a1 b1 a2 b2 a3 b3
+    const __m128i interleave = _mm_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7,
+                                             -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i round = _mm_set1_epi32(WeightRound);
+    const __m128i alphaMask = _mm_setr_epi8(3, 3, 3, 3, -1, -1, -1, -1,
+                                            -1, -1, -1, -1, -1, -1, -1, -1);
+
+    for (int x = 0; x < dstW; ++x) {
+        const uint8_t *p = src + size_t(c.start[x]) * 4;
+        const int16_t *w = &c.weights[size_t(x) * c.taps];
+        __m128i acc = round;
+        for (int k = 0; k < c.taps; k += 2) {
+            __m128i px = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + k * 4));
+            px = _mm_cvtepu8_epi16(_mm_shuffle_epi8(px, interleave));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, _mm_set1_epi32(packWeights(w[k], w[k + 1]))));
+        }
+        acc = _mm_srai_epi32(acc, WeightBits);
+        acc = _mm_packus_epi16(_mm_packs_epi32(acc, acc), acc);
+        acc = _mm_min_epu8(acc, _mm_shuffle_epi8(acc, alphaMask));
+        const int v = _mm_cvtsi128_si32(acc);
+        std::memcpy(dst + size_t(x) * 4, &v, 4);
+    }
+}
+
+XSM_TARGET_SSE41
+void verticalSse41Range(const uint8_t *const *rows, uint8_t *dst, int from, int rowBytes,
+                        const int16_t *w, int taps)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(WeightRound);
+    const __m128i alphaMask = _mm_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7,
+                                            11, 11, 11, 11, 15, 15, 15, 15);
+
+    int i = from;
+    for (; i + 16 <= rowBytes; i += 16) {
+        __m128i acc0 = round, acc1 = round, acc2 = round, acc3 = round;
+        for (int k = 0; k < taps; k += 2) {
+            const bool pair = k + 1 < taps;
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k] + i));
+            const __m128i b = pair ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k + 1] + i)) : a;
+            const __m128i ww = _mm_set1_epi32(packWeights(w[k], pair ? w[k + 1] : 0));
+
+            // 两行字节交错后扩展到 16 位，madd 一次完成 a*w0 + b*w1
+            const __m128i lo = _mm_unpacklo_epi8(a, b);
+            const __m128i hi = _mm_unpackhi_epi8(a, b);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), ww));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), ww));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), ww));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), ww));
+        }
+        const __m128i p01 = _mm_packs_epi32(_mm_srai_epi32(acc0, WeightBits), _mm_srai_epi32(acc1, WeightBits));
+        const __m128i p23 = _mm_packs_epi32(_mm_srai_epi32(acc2, WeightBits), _mm_srai_epi32(acc3, WeightBits));
+        __m128i out = _mm_packus_epi16(p01, p23);
+        out = _mm_min_epu8(out, _mm_shuffle_epi8(out, alphaMask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), out);
+    }
+    verticalScalarRange(rows, dst, i, rowBytes, w, taps);
+}
+
+XSM_TARGET_SSE41
+void verticalSse41(const uint8_t *const *rows, uint8_t *dst, int rowBytes,
+                   const int16_t *w, int taps)
+{
+    verticalSse41Range(rows, dst, 0, rowBytes, w, taps);
+}
+
+// ---------------------------------------------------------
+// AVX2：水平方向两个输出像素各占一个 128 位通道；垂直方向一次 8 个像素
+// unpack/pack 都是按通道进行的，输出顺序与输入一致
+// ---------------------------------------------------------
+XSM_TARGET_AVX2
+void horizontalAvx2(const uint8_t *src, uint8_t *dst, int dstW, const Coeffs &c)
+{
+    const __m256i interleave = _mm256_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7,
+                                                -1, -1, -1, -1, -1, -1, -1, -1,
+                                                0, 4, 1, 5, 2, 6, 3, 7,
+                                                -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi32(WeightRound);
+    const __m256i alphaMask = _mm256_setr_epi8(3, 3, 3, 3, -1, -1, -1, -1,
+                                               -1, -1, -1, -1, -1, -1, -1, -1,
+                                               3, 3, 3, 3, -1, -1, -1, -1,
+                                               -1, -1, -1, -1, -1, -1, -1, -1);
+
+    int x = 0;
+    for (; x + 2 <= dstW; x += 2) {
+        const uint8_t *p0 = src + size_t(c.start[x]) * 4;
+        const uint8_t *p1 = src + size_t(c.start[x + 1]) * 4;
+        const int16_t *w0 = &c.weights[size_t(x) * c.taps];
+        const int16_t *w1 = w0 + c.taps;
+        __m256i acc = round;
+        for (int k = 0; k < c.taps; k += 2) {
+            const __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p0 + k * 4));
+            const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p1 + k * 4));
+            __m256i px = _mm256_inserti128_si256(_mm256_castsi128_si256(a), b, 1);
+            px = _mm256_unpacklo_epi8(_mm256_shuffle_epi8(px, interleave), zero);
+            const __m256i ww = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_set1_epi32(packWeights(w0[k], w0[k + 1]))),
+                _mm_set1_epi32(packWeights(w1[k], w1[k + 1])), 1);
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(px, ww));
+        }
+        acc = _mm256_srai_epi32(acc, WeightBits);
+        acc = _mm256_packus_epi16(_mm256_packs_epi32(acc, acc), acc);
+        acc = _mm256_min_epu8(acc, _mm256_shuffle_epi8(acc, alphaMask));
+        const int v0 = _mm256_extract_epi32(acc, 0);
+        const int v1 = _mm256_extract_epi32(acc, 4);
+        std::memcpy(dst + size_t(x) * 4, &v0, 4);
+        std::memcpy(dst + size_t(x + 1) * 4, &v1, 4);
+    }
+
+    // 奇数宽度的最后一个像素
+    for (; x < dstW; ++x) {
+        const uint8_t *p = src + size_t(c.start[x]) * 4;
+        const int16_t *w = &c.weights[size_t(x) * c.taps];
+        int32_t acc[4] = { WeightRound, WeightRound, WeightRound, WeightRound };
+        for (int k = 0; k < c.taps; ++k) {
+            for (int ch = 0; ch < 4; ++ch)
+                acc[ch] += int32_t(p[k * 4 + ch]) * w[k];
+        }
+        storePixel(dst + size_t(x) * 4, acc);
+    }
+}
+
+XSM_TARGET_AVX2
+void verticalAvx2(const uint8_t *const *rows, uint8_t *dst, int rowBytes,
+                  const int16_t *w, int taps)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi32(WeightRound);
+    const __m256i alphaMask = _mm256_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7,
+                                               11, 11, 11, 11, 15, 15, 15, 15,
+                                               3, 3, 3, 3, 7, 7, 7, 7,
+                                               11, 11, 11, 11, 15, 15, 15, 15);
+
+    int i = 0;
+    for (; i + 32 <= rowBytes; i += 32) {
+        __m256i acc0 = round, acc1 = round, acc2 = round, acc3 = round;
+        for (int k = 0; k < taps; k += 2) {
+            const bool pair = k + 1 < taps;
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[k] + i));
+            const __m256i b = pair ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[k + 1] + i)) : a;
+            const __m256i ww = _mm256_set1_epi32(packWeights(w[k], pair ? w[k + 1] : 0));
+
+            const __m256i lo = _mm256_unpacklo_epi8(a, b);
+            const __m256i hi = _mm256_unpackhi_epi8(a, b);
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi8(lo, zero), ww));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, zero), ww));
+            acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, zero), ww));
+            acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, zero), ww));
+        }
+        const __m256i p01 = _mm256_packs_epi32(_mm256_srai_epi32(acc0, WeightBits), _mm256_srai_epi32(acc1, WeightBits));
+        const __m256i p23 = _mm256_packs_epi32(_mm256_srai_epi32(acc2, WeightBits), _mm256_srai_epi32(acc3, WeightBits));
+        __m256i out = _mm256_packus_epi16(p01, p23);
+        out = _mm256_min_epu8(out, _mm256_shuffle_epi8(out, alphaMask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), out);
+    }
+    // 不足 32 字节的行尾交给 SSE4.1
+    verticalSse41Range(rows, dst, i, rowBytes, w, taps);
+}
+
+bool cpuHasSse41()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#else
+    return false;
+#endif
+}
+
+bool cpuHasAvx2()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    // 还要确认操作系统保存了 YMM 寄存器状态
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+#endif // XSM_SCALER_X86
+
+using HorizontalFn = void (*)(const uint8_t *, uint8_t *, int, const Coeffs &);
+using VerticalFn = void (*)(const uint8_t *const *, uint8_t *, int, const int16_t *, int);
+
+struct ScalerImpl {
+    const char *name;
+    HorizontalFn horizontal;
+    VerticalFn vertical;
+};
+
+ScalerImpl detectImpl()
+{
+    // 环境变量 XSM_SCALER=scalar/sse4.1 可强制降级，便于对比测试
+    const QByteArray forced = qgetenv("XSM_SCALER");
+#ifdef XSM_SCALER_X86
+    if (forced != "scalar" && forced != "sse4.1" && cpuHasAvx2())
+        return { "avx2", horizontalAvx2, verticalAvx2 };
+    if (forced != "scalar" && cpuHasSse41())
+        return { "sse4.1", horizontalSse41, verticalSse41 };
+#else
+    Q_UNUSED(forced);
+#endif
+    return { "scalar", horizontalScalar, verticalScalar };
+}
+
+const ScalerImpl &scalerImpl()
+{
+    static const ScalerImpl impl = detectImpl();
+    return impl;
+}
+
+void resample(const uint8_t *src, int srcW, int srcH, qsizetype srcStride,
+              uint8_t *dst, int dstW, int dstH, qsizetype dstStride, ScaleKernel kernel)
+{
+    const ScalerImpl &impl = scalerImpl();
+    const Coeffs hc = computeCoeffs(srcW, dstW, kernel);
+    const Coeffs vc = computeCoeffs(srcH, dstH, kernel);
+
+    // 水平向量化路径按抽头对处理，窗口宽度为奇数（极小图片）时走标量
+    const HorizontalFn horizontal = (hc.taps % 2 == 0) ? impl.horizontal : horizontalScalar;
+
+    // 第一趟：每一行先缩到目标宽度
+    const int tmpStride = dstW * 4;
+    std::vector<uint8_t> tmp(size_t(tmpStride) * srcH);
+    for (int y = 0; y < srcH; ++y)
+        horizontal(src + y * srcStride, tmp.data() + size_t(y) * tmpStride, dstW, hc);
+
+    // 第二趟：纵向合并
+    std::vector<const uint8_t *> rows(vc.taps);
+    for (int y = 0; y < dstH; ++y) {
+        for (int k = 0; k < vc.taps; ++k)
+            rows[k] = tmp.data() + size_t(vc.start[y] + k) * tmpStride;
+        impl.vertical(rows.data(), dst + y * dstStride, tmpStride,
+                      &vc.weights[size_t(y) * vc.taps], vc.taps);
+    }
+}
+
+} // namespace
+
+QImage scaleImage(const QImage &src, const QSize &size, ScaleKernel kernel)
+{
+    if (src.isNull() || size.isEmpty())
+        return QImage();
+
+    const QImage::Format format = src.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                        : QImage::Format_RGB32;
+    const QImage in = src.format() == format ? src : src.convertToFormat(format);
+    if (in.size() == size)
+        return in;
+
+    QImage out(size, format);
+    if (out.isNull())
+        return QImage();
+
+    resample(in.constBits(), in.width(), in.height(), in.bytesPerLine(),
+             out.bits(), out.width(), out.height(), out.bytesPerLine(), kernel);
+    out.setDevicePixelRatio(src.devicePixelRatio());
+    return out;
+}
+
+QImage scaleImage(const QImage &src, const QSize &box, Qt::AspectRatioMode mode,
+                  ScaleKernel kernel)
+{
+    if (src.isNull())
+        return QImage();
+    return scaleImage(src, src.size().scaled(box, mode), kernel);
+}
+
+const char *imageScalerBackend()
+{
+    return scalerImpl().name;
+}
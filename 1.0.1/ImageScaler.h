@@ -0,0 +1,27 @@
+#ifndef IMAGESCALER_H
+#define IMAGESCALER_H
+
+#pragma once
+#include <QImage>
+#include <QSize>
+
+// 全程序共用的图片缩放：可分离两趟卷积，AVX2 / SSE4.1 运行时分派，另有标量兜底
+// 纯函数、无共享状态，可在任意工作线程调用；GUI 线程只负责把结果转成 QPixmap
+
+enum class ScaleKernel {
+    AreaAverage, // 面积平均：缩小缩略图的默认选择，速度最快且不产生振铃
+    Lanczos3     // Lanczos-3：详情页封面/截图等大尺寸输出，锐度更好
+};
+
+// 缩放到精确尺寸；输出为 Format_RGB32（无透明）或 Format_ARGB32_Premultiplied
+QImage scaleImage(const QImage &src, const QSize &size,
+                  ScaleKernel kernel = ScaleKernel::AreaAverage);
+
+// 按 Qt::AspectRatioMode 计算目标尺寸后缩放，用法与 QImage::scaled 一致
+QImage scaleImage(const QImage &src, const QSize &box, Qt::AspectRatioMode mode,
+                  ScaleKernel kernel = ScaleKernel::AreaAverage);
+
+// 当前 CPU 上实际使用的实现："avx2" / "sse4.1" / "scalar"
+const char *imageScalerBackend();
+
+#endif // IMAGESCALER_H
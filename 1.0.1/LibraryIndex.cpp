@@ -0,0 +1,378 @@
+#include "LibraryIndex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QDataStream>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QReadLocker>
+#include <QWriteLocker>
+
+#include <algorithm>
+
+namespace {
+
+const quint32 IndexMagic = 0x58534c49; // "XSLI"
+const quint32 IndexVersion = 2;       // 2：加入文件统计
+const qint64 SaveIntervalMs = 30000;
+
+QString childPath(const QString &dir, const QString &name)
+{
+    return dir.endsWith('/') ? dir + name : dir + '/' + name;
+}
+
+QString parentPath(const QString &dir)
+{
+    const int slash = dir.lastIndexOf('/');
+    if (slash < 0 || slash == dir.size() - 1)
+        return QString();   // 已经是根（"/"、"C:/"）
+    if (slash == 0)
+        return QStringLiteral("/");
+    // "C:/foo" 的上级是 "C:/"，保留盘符后的斜杠
+    if (slash == 2 && dir.at(1) == ':')
+        return dir.left(3);
+    return dir.left(slash);
+}
+
+QDataStream &operator<<(QDataStream &out, const FolderStats &stats)
+{
+    return out << stats.files << stats.bytes << stats.images << stats.videos;
+}
+
+QDataStream &operator>>(QDataStream &in, FolderStats &stats)
+{
+    return in >> stats.files >> stats.bytes >> stats.images >> stats.videos;
+}
+
+QStringList sorted(QStringList list)
+{
+    std::sort(list.begin(), list.end());
+    return list;
+}
+
+} // namespace
+
+LibraryIndex &LibraryIndex::instance()
+{
+    static LibraryIndex index;
+    return index;
+}
+
+LibraryIndex::LibraryIndex()
+{
+    load();
+}
+
+QString LibraryIndex::filePath() const
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (dir.isEmpty())
+        dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    QDir().mkpath(dir);
+    return dir + "/library_index.bin";
+}
+
+void LibraryIndex::load()
+{
+    QFile f(filePath());
+    if (!f.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0, count = 0;
+    in >> magic >> version >> count;
+    if (magic != IndexMagic || version != IndexVersion)
+        return;     // 格式不认识就当没有索引，下次完整扫描时重建
+
+    // count 来自文件，损坏时可能很大：预留有上限，超出的部分照常插入
+    m_nodes.reserve(int(qMin(count, 65536u)));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString dir;
+        DirNode node;
+        in >> dir >> node.mtime >> node.hasFiles >> node.hasSubdirs
+           >> node.files >> node.subdirs >> node.hash
+           >> node.hasLocalStats >> node.local >> node.hasTotalStats >> node.total;
+        m_nodes.insert(dir, node);
+    }
+    if (in.status() != QDataStream::Ok)
+        m_nodes.clear();    // 文件被截断：宁可全部重扫也不用半份索引
+}
+
+void LibraryIndex::save(bool force)
+{
+    QHash<QString, DirNode> nodes;
+    {
+        QWriteLocker locker(&m_lock);
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        if (!m_dirty || (!force && now - m_lastSave < SaveIntervalMs))
+            return;
+        recomputeStale(QString());
+        m_dirty = false;
+        m_lastSave = now;
+        nodes = m_nodes;    // 隐式共享，序列化在锁外做
+    }
+
+    QSaveFile f(filePath());
+    if (!f.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << IndexMagic << IndexVersion << quint32(nodes.size());
+    for (auto it = nodes.cbegin(); it != nodes.cend(); ++it) {
+        const DirNode &node = it.value();
+        out << it.key() << node.mtime << node.hasFiles << node.hasSubdirs
+            << node.files << node.subdirs << node.hash
+            << node.hasLocalStats << node.local << node.hasTotalStats << node.total;
+    }
+
+    if (!f.commit()) {
+        QWriteLocker locker(&m_lock);
+        m_dirty = true; // 下次再试
+    }
+}
+
+bool LibraryIndex::lookup(const QString &dir, DirNode *node) const
+{
+    settle(dir);
+    QReadLocker locker(&m_lock);
+    auto it = m_nodes.constFind(dir);
+    if (it == m_nodes.constEnd())
+        return false;
+    *node = it.value();
+    return true;
+}
+
+bool LibraryIndex::isCurrent(const QString &dir, qint64 mtime, DirNode *node) const
+{
+    settle(dir);
+    QReadLocker locker(&m_lock);
+    auto it = m_nodes.constFind(dir);
+    if (it == m_nodes.constEnd() || it->mtime != mtime || !it->hasFiles || !it->hasSubdirs)
+        return false;
+    *node = it.value();
+    return true;
+}
+
+QByteArray LibraryIndex::treeHash(const QString &dir) const
+{
+    settle(dir);
+    QReadLocker locker(&m_lock);
+    return m_nodes.value(dir).hash;
+}
+
+bool LibraryIndex::folderStats(const QString &dir, FolderStats *total) const
+{
+    settle(dir);
+    QReadLocker locker(&m_lock);
+    auto it = m_nodes.constFind(dir);
+    if (it == m_nodes.constEnd() || !it->hasTotalStats)
+        return false;
+    *total = it->total;
+    return true;
+}
+
+void LibraryIndex::update(const QString &dir, qint64 mtime,
+                          const QStringList &files, const QStringList &subdirs)
+{
+    QWriteLocker locker(&m_lock);
+    DirNode &node = m_nodes[dir];
+    if (node.mtime != mtime)
+        node.hasLocalStats = false;     // 本层有增删，统计要重算
+    node.mtime = mtime;
+    node.files = sorted(files);
+    node.subdirs = sorted(subdirs);
+    node.hasFiles = true;
+    node.hasSubdirs = true;
+    m_dirty = true;
+    markStale(dir);
+}
+
+void LibraryIndex::recordFiles(const QString &dir, qint64 mtime, const QStringList &files)
+{
+    QWriteLocker locker(&m_lock);
+    DirNode &node = m_nodes[dir];
+    if (node.mtime != mtime) {  // 目录变过，之前记下的子目录列表和统计不再可信
+        node.mtime = mtime;
+        node.hasLocalStats = false;
+        node.hasSubdirs = false;
+        node.subdirs.clear();
+    }
+    node.files = sorted(files);
+    node.hasFiles = true;
+    m_dirty = true;
+    markStale(dir);
+}
+
+void LibraryIndex::updateWithStats(const QString &dir, qint64 mtime, const QStringList &files,
+                                   const QStringList &subdirs, const FolderStats &local)
+{
+    QWriteLocker locker(&m_lock);
+    DirNode &node = m_nodes[dir];
+    node.mtime = mtime;
+    node.files = sorted(files);
+    node.subdirs = sorted(subdirs);
+    node.hasFiles = true;
+    node.hasSubdirs = true;
+    node.local = local;
+    node.hasLocalStats = true;
+    m_dirty = true;
+    markStale(dir);
+}
+
+void LibraryIndex::recordSubdirs(const QString &dir, qint64 mtime, const QStringList &subdirs)
+{
+    QWriteLocker locker(&m_lock);
+    DirNode &node = m_nodes[dir];
+    if (node.mtime != mtime) {
+        node.mtime = mtime;
+        node.hasLocalStats = false;
+        node.hasFiles = false;
+        node.files.clear();
+    }
+    node.subdirs = sorted(subdirs);
+    node.hasSubdirs = true;
+    m_dirty = true;
+    markStale(dir);
+}
+
+void LibraryIndex::removeTree(const QString &dir)
+{
+    QWriteLocker locker(&m_lock);
+    const QString prefix = dir.endsWith('/') ? dir : dir + '/';
+    for (auto it = m_nodes.begin(); it != m_nodes.end();) {
+        if (it.key() == dir || it.key().startsWith(prefix)) {
+            it = m_nodes.erase(it);
+            m_dirty = true;
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = m_stale.begin(); it != m_stale.end();) {
+        if (*it == dir || it->startsWith(prefix))
+            it = m_stale.erase(it);
+        else
+            ++it;
+    }
+    markStale(parentPath(dir));
+}
+
+void LibraryIndex::markStale(const QString &dir)
+{
+    // 上级已经过期就不用再往上走：过期目录的上级一定也过期
+    for (QString current = dir; !current.isEmpty(); current = parentPath(current)) {
+        if (!m_nodes.contains(current) || m_stale.contains(current))
+            return;
+        m_stale.insert(current);
+    }
+}
+
+bool LibraryIndex::hasStaleUnder(const QString &dir) const
+{
+    if (dir.isEmpty())
+        return !m_stale.isEmpty();
+    // 过期集合只有最近写过的目录和它们的上级，通常很小
+    const QString prefix = dir.endsWith('/') ? dir : dir + '/';
+    for (const QString &path : m_stale) {
+        if (path == dir || path.startsWith(prefix))
+            return true;
+    }
+    return false;
+}
+
+void LibraryIndex::settle(const QString &dir) const
+{
+    {
+        QReadLocker locker(&m_lock);
+        if (!hasStaleUnder(dir))
+            return;
+    }
+    // 重算的是派生数据，读接口保持 const
+    QWriteLocker locker(&m_lock);
+    const_cast<LibraryIndex *>(this)->recomputeStale(dir);
+}
+
+void LibraryIndex::recomputeStale(const QString &dir)
+{
+    QStringList pending;
+    const QString prefix = dir.endsWith('/') ? dir : dir + '/';
+    for (const QString &path : std::as_const(m_stale)) {
+        if (dir.isEmpty() || path == dir || path.startsWith(prefix))
+            pending << path;
+    }
+    if (pending.isEmpty())
+        return;
+
+    // 子目录先算，上级才能用到它们的新哈希和合计；dir 的上级留在过期集合里
+    std::sort(pending.begin(), pending.end(), [](const QString &a, const QString &b) {
+        return a.count('/') > b.count('/');
+    });
+    for (const QString &path : std::as_const(pending)) {
+        m_stale.remove(path);
+        recompute(path);
+    }
+}
+
+void LibraryIndex::recompute(const QString &dir)
+{
+    // 根的哈希代表整棵树；任何一个子目录还没统计过，合计就不可用
+    auto it = m_nodes.find(dir);
+    if (it == m_nodes.end())
+        return;
+
+    DirNode &node = it.value();
+    node.hasTotalStats = node.hasLocalStats && node.hasSubdirs;
+    node.total = node.local;
+    if (node.hasTotalStats) {
+        for (const QString &name : std::as_const(node.subdirs)) {
+            auto child = m_nodes.constFind(childPath(dir, name));
+            if (child == m_nodes.constEnd() || !child->hasTotalStats) {
+                node.hasTotalStats = false;
+                break;
+            }
+            node.total += child->total;
+        }
+    }
+
+    if (!node.hasFiles || !node.hasSubdirs) {
+        node.hash.clear();
+        return;
+    }
+
+    QByteArray data = QByteArray::number(node.mtime);
+    for (const QString &name : std::as_const(node.files))
+        data += name.toUtf8() + '\0';
+    data += '\1';
+    for (const QString &name : std::as_const(node.subdirs))
+        data += name.toUtf8() + '\0' + m_nodes.value(childPath(dir, name)).hash;
+    node.hash = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+}
+
+QStringList LibraryIndex::staleDirectories(const QString &root) const
+{
+    QStringList stale;
+    QStringList stack { QDir::cleanPath(root) };
+    while (!stack.isEmpty()) {
+        const QString dir = stack.takeLast();
+        const QFileInfo info(dir);
+        if (!info.isDir())
+            continue;
+
+        DirNode node;
+        const bool known = lookup(dir, &node);
+        if (!known || node.mtime != info.lastModified().toMSecsSinceEpoch()
+            || !node.hasFiles || !node.hasSubdirs)
+            stale << dir;
+        // 本层变了也照样沿记录的子目录往下查；新增的子目录要等枚举本层时才能发现
+        if (known) {
+            for (const QString &name : std::as_const(node.subdirs))
+                stack << childPath(dir, name);
+        }
+    }
+    return stale;
+}
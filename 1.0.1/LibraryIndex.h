@@ -0,0 +1,95 @@
+#ifndef LIBRARYINDEX_H
+#define LIBRARYINDEX_H
+
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QReadWriteLock>
+
+// 媒体库目录索引（AppDataLocation/library_index.bin），线程安全
+// 每个目录记下自身的 mtime、本层的媒体文件名和子目录名，以及把子目录的哈希也卷进来的
+// 树哈希（Merkle）。目录 mtime 只在本层增删改名时变化，所以重扫时 mtime 没变的目录
+// 不必再 readdir，只需 stat 一下再沿记录的子目录往下走。
+// 注意：原地改写文件内容不会改变目录 mtime，这类变化靠目录监视和 mtime/size 校验发现
+// 另外可选地记下本层的文件统计（FolderStatsAggregator 给出），子树合计和树哈希一起向上汇总
+
+struct FolderStats {
+    qint64 files = 0;           // 全部普通文件（不只是媒体）
+    qint64 bytes = 0;
+    qint64 images = 0;
+    qint64 videos = 0;
+
+    FolderStats &operator+=(const FolderStats &other) {
+        files += other.files;
+        bytes += other.bytes;
+        images += other.images;
+        videos += other.videos;
+        return *this;
+    }
+};
+
+struct DirNode {
+    qint64 mtime = 0;           // 目录的修改时间（毫秒）
+    QStringList files;          // 本层媒体文件名（已排序）
+    QStringList subdirs;        // 子目录名（已排序，不含符号链接）
+    bool hasFiles = false;      // 文件列表和子目录列表可能来自不同的枚举，分别记录是否已知
+    bool hasSubdirs = false;
+    QByteArray hash;            // 树哈希；两个列表都已知时才有
+    FolderStats local;          // 本层统计，hasLocalStats 时有效；目录 mtime 变了就作废
+    FolderStats total;          // 整棵子树的合计，hasTotalStats 时有效（本层和所有子目录都有统计）
+    bool hasLocalStats = false;
+    bool hasTotalStats = false;
+};
+
+class LibraryIndex {
+public:
+    static LibraryIndex &instance();
+
+    bool lookup(const QString &dir, DirNode *node) const;
+    // 同时知道文件和子目录（后台爬虫的完整枚举）
+    void update(const QString &dir, qint64 mtime, const QStringList &files, const QStringList &subdirs);
+    // 浏览时顺手记录：loadContent 给出文件，rebuildFolderList 给出子目录
+    void recordFiles(const QString &dir, qint64 mtime, const QStringList &files);
+    void recordSubdirs(const QString &dir, qint64 mtime, const QStringList &subdirs);
+    // 完整枚举并带上本层统计（统计器用）；文件内容原地变化时 mtime 不变，统计照样覆盖
+    void updateWithStats(const QString &dir, qint64 mtime, const QStringList &files,
+                         const QStringList &subdirs, const FolderStats &local);
+    void removeTree(const QString &dir);
+
+    // mtime 与记录一致且两个列表都已知：本层可以跳过 readdir
+    bool isCurrent(const QString &dir, qint64 mtime, DirNode *node) const;
+    QByteArray treeHash(const QString &dir) const;
+    // 整棵子树的合计；还有子目录没统计过时返回 false
+    bool folderStats(const QString &dir, FolderStats *total) const;
+
+    // 从 root 开始只 stat 目录，返回需要重新枚举的目录（未记录或 mtime 变了）
+    QStringList staleDirectories(const QString &root) const;
+
+    // 索引可能有几百万个文件名：force 为 false 时至少间隔 SaveIntervalMs 才落盘
+    void save(bool force = false);
+
+private:
+    LibraryIndex();
+    Q_DISABLE_COPY(LibraryIndex)
+    void load();
+    QString filePath() const;
+    // 树哈希和子树合计按需重算：写入时只把自己和上级标记为过期（调用方持有写锁），
+    // 读的时候才把要读的子树里过期的节点从深到浅算一遍。一个宽目录的几千个子目录
+    // 依次更新时，上级只在被读到时重算一次，而不是每次更新都重算
+    void markStale(const QString &dir);
+    void settle(const QString &dir) const;      // 不持锁调用；dir 为空表示全部
+    bool hasStaleUnder(const QString &dir) const;   // 调用方持有锁
+    void recomputeStale(const QString &dir);    // 调用方持有写锁
+    void recompute(const QString &dir);
+
+    mutable QReadWriteLock m_lock;
+    QHash<QString, DirNode> m_nodes;
+    QSet<QString> m_stale;      // 哈希和合计过期的目录；某个目录在里面时，它已记录的上级也都在
+    bool m_dirty = false;
+    qint64 m_lastSave = 0;
+};
+
+#endif // LIBRARYINDEX_H
@@ -0,0 +1,66 @@
+#ifndef LOCKFREEQUEUE_H
+#define LOCKFREEQUEUE_H
+
+#pragma once
+#include <QList>
+#include <atomic>
+#include <utility>
+
+// 多生产者、单消费者的无锁队列：工作线程 push，GUI 线程一次取走全部。
+// 生产者用 CAS 把节点压到链表头，消费者用 exchange 把整条链摘下来再反转成先进先出，
+// 消费者从不单个弹出节点，所以没有 ABA 问题
+template <typename T>
+class LockFreeQueue {
+public:
+    LockFreeQueue() = default;
+    ~LockFreeQueue() { takeAll(); }
+    LockFreeQueue(const LockFreeQueue &) = delete;
+    LockFreeQueue &operator=(const LockFreeQueue &) = delete;
+
+    // 返回 true 表示队列原本是空的：消费者可能在等，需要唤醒
+    bool push(T value)
+    {
+        Node *node = new Node { std::move(value), nullptr };
+        Node *head = m_head.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!m_head.compare_exchange_weak(head, node,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed));
+        return head == nullptr;
+    }
+
+    // 只能由消费者调用；按 push 的先后顺序返回
+    QList<T> takeAll()
+    {
+        Node *node = m_head.exchange(nullptr, std::memory_order_acquire);
+        Node *reversed = nullptr;
+        int count = 0;
+        while (node) {
+            Node *next = node->next;
+            node->next = reversed;
+            reversed = node;
+            node = next;
+            ++count;
+        }
+
+        QList<T> out;
+        out.reserve(count);
+        while (reversed) {
+            Node *next = reversed->next;
+            out.append(std::move(reversed->value));
+            delete reversed;
+            reversed = next;
+        }
+        return out;
+    }
+
+private:
+    struct Node {
+        T value;
+        Node *next;
+    };
+    std::atomic<Node *> m_head { nullptr };
+};
+
+#endif // LOCKFREEQUEUE_H
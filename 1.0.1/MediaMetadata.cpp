@@ -0,0 +1,532 @@
+#include "MediaMetadata.h"
+#include "MediaProbe.h"
+#include "FfmpegUtil.h"
+#include "ImageHeader.h"
+#include "LibraryIndex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QImageReader>
+#include <QStandardPaths>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QMutexLocker>
+
+namespace {
+
+// 与 loadContent 的名称过滤保持一致
+const QSet<QString> &videoSuffixes()
+{
+    static const QSet<QString> s = { "mp4", "mkv", "avi", "mov", "webm", "flv", "wmv", "m4v" };
+    return s;
+}
+
+const QSet<QString> &imageSuffixes()
+{
+    static const QSet<QString> s = { "jpg", "jpeg", "png", "bmp", "gif", "webp", "tiff", "tif",
+                                     "heic", "heif", "hif",
+                                     "cr2", "nef", "nrw", "arw", "sr2", "dng",
+                                     "orf", "rw2", "pef", "raf" };
+    return s;
+}
+
+// 每处理一个文件让出一下 CPU，持续运行也不会和前台抢资源
+const int CrawlSleepMs = 2;
+// 暂停时的轮询间隔；探测结果每隔这么久落盘一次
+const int PausePollMs = 200;
+const int SaveIntervalMs = 5000;
+
+} // namespace
+
+QString formatDuration(double seconds)
+{
+    const int total = int(seconds + 0.5);
+    const int h = total / 3600;
+    const int m = (total / 60) % 60;
+    const int s = total % 60;
+    if (h > 0)
+        return QString("%1:%2:%3").arg(h).arg(m, 2, 10, QChar('0')).arg(s, 2, 10, QChar('0'));
+    return QString("%1:%2").arg(m).arg(s, 2, 10, QChar('0'));
+}
+
+QString resolutionLabel(const QSize &size, bool isVideo)
+{
+    if (size.isEmpty())
+        return QString();
+    if (isVideo) {
+        // 按短边归档，竖屏视频也能得到正确的档位
+        const int shortEdge = qMin(size.width(), size.height());
+        if (shortEdge >= 2100) return "4K";
+        if (shortEdge >= 1400) return "1440p";
+        if (shortEdge >= 1000) return "1080p";
+        if (shortEdge >= 700)  return "720p";
+        return QString("%1p").arg(shortEdge);
+    }
+    return QString("%1x%2").arg(size.width()).arg(size.height());
+}
+
+// ---------------------------------------------------------
+// MetadataStore
+// ---------------------------------------------------------
+MetadataStore &MetadataStore::instance()
+{
+    static MetadataStore store;
+    return store;
+}
+
+MetadataStore::MetadataStore()
+{
+    load();
+}
+
+QString MetadataStore::filePath() const
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (dir.isEmpty())
+        dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    QDir().mkpath(dir);
+    return dir + "/media_metadata.json";
+}
+
+void MetadataStore::load()
+{
+    QFile f(filePath());
+    if (!f.open(QIODevice::ReadOnly))
+        return;
+
+    const QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
+    if (!doc.isObject())
+        return;
+
+    const QJsonObject root = doc.object();
+    for (const QJsonValue &v : root.value("roots").toArray())
+        m_roots << v.toString();
+    for (const QJsonValue &v : root.value("pending").toArray())
+        m_pendingDirs << v.toString();
+
+    const QJsonObject files = root.value("files").toObject();
+    m_entries.reserve(files.size());
+    for (auto it = files.begin(); it != files.end(); ++it) {
+        const QJsonObject o = it.value().toObject();
+        MediaMeta meta;
+        meta.mtime = qint64(o.value("m").toDouble());
+        meta.size = qint64(o.value("s").toDouble());
+        meta.duration = o.value("d").toDouble();
+        meta.resolution = QSize(o.value("w").toInt(), o.value("h").toInt());
+        meta.codec = o.value("c").toString();
+        m_entries.insert(it.key(), meta);
+    }
+}
+
+void MetadataStore::save()
+{
+    QJsonObject root;
+    {
+        QWriteLocker locker(&m_lock);
+        if (!m_dirty)
+            return;
+        m_dirty = false;
+
+        QJsonObject files;
+        for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+            const MediaMeta &meta = it.value();
+            QJsonObject o;
+            o["m"] = double(meta.mtime);
+            o["s"] = double(meta.size);
+            if (meta.duration > 0)
+                o["d"] = meta.duration;
+            if (!meta.resolution.isEmpty()) {
+                o["w"] = meta.resolution.width();
+                o["h"] = meta.resolution.height();
+            }
+            if (!meta.codec.isEmpty())
+                o["c"] = meta.codec;
+            files.insert(it.key(), o);
+        }
+        root["files"] = files;
+        root["roots"] = QJsonArray::fromStringList(m_roots);
+        root["pending"] = QJsonArray::fromStringList(m_pendingDirs);
+    }
+
+    // 先写临时文件再替换，写到一半退出也不会损坏旧数据
+    QSaveFile f(filePath());
+    if (!f.open(QIODevice::WriteOnly))
+        return;
+    f.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!f.commit()) {
+        QWriteLocker locker(&m_lock);
+        m_dirty = true; // 下次再试
+    }
+}
+
+bool MetadataStore::lookup(const QString &path, MediaMeta *meta) const
+{
+    QReadLocker locker(&m_lock);
+    auto it = m_entries.constFind(path);
+    if (it == m_entries.constEnd())
+        return false;
+    *meta = it.value();
+    return true;
+}
+
+bool MetadataStore::contains(const QString &path) const
+{
+    QReadLocker locker(&m_lock);
+    return m_entries.contains(path);
+}
+
+bool MetadataStore::isFresh(const QString &path, qint64 mtime, qint64 size) const
+{
+    QReadLocker locker(&m_lock);
+    auto it = m_entries.constFind(path);
+    return it != m_entries.constEnd() && it->mtime == mtime && it->size == size;
+}
+
+void MetadataStore::insert(const QString &path, const MediaMeta &meta)
+{
+    QWriteLocker locker(&m_lock);
+    m_entries.insert(path, meta);
+    m_dirty = true;
+}
+
+void MetadataStore::remove(const QString &path)
+{
+    QWriteLocker locker(&m_lock);
+    if (m_entries.remove(path))
+        m_dirty = true;
+}
+
+void MetadataStore::rename(const QString &oldPath, const QString &newPath)
+{
+    QWriteLocker locker(&m_lock);
+    auto it = m_entries.find(oldPath);
+    if (it == m_entries.end())
+        return;
+    const MediaMeta meta = it.value();
+    m_entries.erase(it);
+    m_entries.insert(newPath, meta);
+    m_dirty = true;
+}
+
+void MetadataStore::removeMissing(const QString &dir, const QSet<QString> &present)
+{
+    const QString prefix = dir + '/';
+    QWriteLocker locker(&m_lock);
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        const QString &path = it.key();
+        // 只看 dir 的直接子项
+        if (path.startsWith(prefix) && path.indexOf('/', prefix.size()) < 0 && !present.contains(path)) {
+            it = m_entries.erase(it);
+            m_dirty = true;
+        } else {
+            ++it;
+        }
+    }
+}
+
+QStringList MetadataStore::libraryRoots() const
+{
+    QReadLocker locker(&m_lock);
+    return m_roots;
+}
+
+void MetadataStore::addLibraryRoot(const QString &dir)
+{
+    QWriteLocker locker(&m_lock);
+    if (m_roots.contains(dir))
+        return;
+    m_roots << dir;
+    m_dirty = true;
+}
+
+QStringList MetadataStore::pendingDirs() const
+{
+    QReadLocker locker(&m_lock);
+    return m_pendingDirs;
+}
+
+void MetadataStore::setPendingDirs(const QStringList &dirs)
+{
+    QWriteLocker locker(&m_lock);
+    if (m_pendingDirs == dirs)
+        return;
+    m_pendingDirs = dirs;
+    m_dirty = true;
+}
+
+// ---------------------------------------------------------
+// MetadataCrawler
+// ---------------------------------------------------------
+MetadataCrawler::MetadataCrawler(QObject *parent)
+    : QThread(parent)
+{
+    qRegisterMetaType<MediaMeta>();
+    // 不在这里碰 MetadataStore：元数据库可能很大，加载放到爬虫线程里，不拖慢启动的第一帧
+}
+
+MetadataCrawler::~MetadataCrawler()
+{
+    stop();
+    wait();
+}
+
+void MetadataCrawler::prioritize(const QStringList &files, bool replace)
+{
+    QMutexLocker locker(&m_mutex);
+    // 换了目录：旧的优先队列作废；同一目录里新增的文件接在后面
+    if (replace)
+        m_priority.clear();
+    for (const QString &f : files)
+        m_priority.enqueue(f);
+    m_wake.wakeAll();
+}
+
+void MetadataCrawler::addRoot(const QString &dir)
+{
+    const QString root = QDir::cleanPath(dir);
+    if (MetadataStore::instance().libraryRoots().contains(root))
+        return;
+    MetadataStore::instance().addLibraryRoot(root);
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_dirs.contains(root))
+        m_dirs << root;
+    m_wake.wakeAll();
+}
+
+void MetadataCrawler::rescan(const QStringList &dirs, bool recursive)
+{
+    QMutexLocker locker(&m_mutex);
+    for (const QString &dir : dirs) {
+        const QString clean = QDir::cleanPath(dir);
+        if (recursive) {
+            if (!m_dirs.contains(clean))
+                m_dirs.prepend(clean);
+        } else if (!m_rescanDirs.contains(clean)) {
+            m_rescanDirs << clean;
+        }
+    }
+    m_wake.wakeAll();
+}
+
+void MetadataCrawler::setPaused(bool paused)
+{
+    QMutexLocker locker(&m_mutex);
+    m_paused = paused;
+    if (!paused)
+        m_wake.wakeAll();
+}
+
+void MetadataCrawler::stop()
+{
+    m_stop = true;
+    QMutexLocker locker(&m_mutex);
+    m_wake.wakeAll();
+}
+
+MediaMeta MetadataCrawler::probeFile(const QString &path)
+{
+    const QFileInfo info(path);
+    MediaMeta meta;
+    meta.mtime = info.lastModified().toMSecsSinceEpoch();
+    meta.size = info.size();
+
+    const QString suffix = info.suffix().toLower();
+    if (videoSuffixes().contains(suffix)) {
+        const MediaInfo media = probeMedia(path);
+        if (media.valid) {
+            meta.duration = media.durationSeconds;
+            meta.resolution = media.resolution;
+            meta.codec = media.videoCodec;
+        } else {
+            // avi/flv/wmv 等容器没有原生解析器，交给内置 ffmpeg
+            meta.duration = probeDurationSeconds(path);
+        }
+    } else {
+        // 只读文件头，不解码像素；尺寸按 EXIF 方向换算成显示尺寸
+        const ImageHeaderInfo header = readImageHeader(path);
+        if (header.valid) {
+            meta.resolution = header.displaySize();
+        } else {
+            // HEIF/RAW 等交给对应的 Qt 插件读头
+            QImageReader reader(path);
+            meta.resolution = reader.size();
+        }
+    }
+    return meta;
+}
+
+bool MetadataCrawler::takeNext(QString *path)
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_stop) {
+        if (m_paused) {
+            m_wake.wait(&m_mutex, PausePollMs);
+            continue;
+        }
+        if (!m_priority.isEmpty()) {
+            *path = m_priority.dequeue();
+            return true;
+        }
+        if (!m_rescanDirs.isEmpty()) {
+            // 变化过的目录：只看本层，顺带清掉已删除文件的记录
+            const QString dir = m_rescanDirs.takeFirst();
+            locker.unlock();
+
+            QStringList files, fileNames, subdirNames;
+            QSet<QString> present;
+            const QFileInfo dirInfo(dir);
+            const qint64 dirMtime = dirInfo.lastModified().toMSecsSinceEpoch();
+            const QFileInfoList entries = QDir(dir).entryInfoList(
+                QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+            for (const QFileInfo &e : entries) {
+                if (e.isDir()) {
+                    subdirNames << e.fileName();
+                    continue;
+                }
+                const QString suffix = e.suffix().toLower();
+                if (videoSuffixes().contains(suffix) || imageSuffixes().contains(suffix)) {
+                    files << e.absoluteFilePath();
+                    fileNames << e.fileName();
+                    present.insert(e.absoluteFilePath());
+                }
+            }
+            MetadataStore::instance().removeMissing(dir, present);
+            if (dirInfo.isDir())
+                LibraryIndex::instance().update(dir, dirMtime, fileNames, subdirNames);
+            else
+                LibraryIndex::instance().removeTree(dir);
+
+            locker.relock();
+            // 排在正在处理的目录前面，新文件的角标尽快出来
+            for (auto it = files.crbegin(); it != files.crend(); ++it)
+                m_files.prepend(*it);
+            continue;
+        }
+        if (!m_files.isEmpty()) {
+            *path = m_files.dequeue();
+            return true;
+        }
+        if (!m_dirs.isEmpty()) {
+            // 枚举目录是 I/O，期间放开锁，避免 GUI 线程调用 prioritize 时被卡住
+            const QString dir = m_dirs.first();
+            locker.unlock();
+
+            QStringList files, subdirs;
+            LibraryIndex &index = LibraryIndex::instance();
+            const QFileInfo dirInfo(dir);
+            const qint64 dirMtime = dirInfo.lastModified().toMSecsSinceEpoch();
+            DirNode node;
+            if (!dirInfo.isDir()) {
+                index.removeTree(dir);
+            } else if (index.isCurrent(dir, dirMtime, &node)) {
+                // 目录 mtime 没变：本层的文件和子目录跟上次一样，不用 readdir，也不用逐个 stat；
+                // 只补上还没探测过的文件（比如浏览时记录、但爬虫还没轮到的目录）
+                const MetadataStore &store = MetadataStore::instance();
+                const QString prefix = dir + '/';
+                for (const QString &name : std::as_const(node.files)) {
+                    if (!store.contains(prefix + name))
+                        files << prefix + name;
+                }
+                for (const QString &name : std::as_const(node.subdirs))
+                    subdirs << prefix + name;
+            } else {
+                QStringList fileNames, subdirNames;
+                const QFileInfoList entries = QDir(dir).entryInfoList(
+                    QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+                for (const QFileInfo &e : entries) {
+                    if (e.isDir()) {
+                        subdirs << e.absoluteFilePath();
+                        subdirNames << e.fileName();
+                    } else {
+                        const QString suffix = e.suffix().toLower();
+                        if (videoSuffixes().contains(suffix) || imageSuffixes().contains(suffix)) {
+                            files << e.absoluteFilePath();
+                            fileNames << e.fileName();
+                        }
+                    }
+                }
+                index.update(dir, dirMtime, fileNames, subdirNames);
+            }
+
+            locker.relock();
+            // 目录在文件入队时才移出待办；中途退出的话下次会重新枚举，已探测的文件会被跳过
+            m_dirs.removeOne(dir);
+            m_dirs << subdirs;
+            for (const QString &f : files)
+                m_files.enqueue(f);
+            continue;
+        }
+        m_wake.wait(&m_mutex);
+    }
+    return false;
+}
+
+void MetadataCrawler::run()
+{
+    MetadataStore &store = MetadataStore::instance();
+    {
+        // 接着上次没爬完的目录继续；上次已经爬完的话，从根目录再走一遍校验。
+        // 有目录索引时这一遍只 stat 目录，mtime 没变的目录不会重新枚举
+        QStringList seed = store.pendingDirs();
+        if (seed.isEmpty())
+            seed = store.libraryRoots();
+        QMutexLocker locker(&m_mutex);
+        for (const QString &dir : std::as_const(seed)) {
+            if (!m_dirs.contains(dir))
+                m_dirs << dir;  // 启动后 addRoot/rescan 已经加进来的不重复
+        }
+    }
+
+    QElapsedTimer saveTimer;
+    saveTimer.start();
+
+    auto persist = [this, &store]() {
+        QStringList pending;
+        {
+            QMutexLocker locker(&m_mutex);
+            pending = m_dirs;
+            // 当前目录的文件还没处理完：把它们所在的目录放回待办
+            QSet<QString> partial;
+            for (const QString &f : std::as_const(m_files))
+                partial.insert(QFileInfo(f).absolutePath());
+            for (const QString &d : std::as_const(partial))
+                pending.prepend(d);
+        }
+        store.setPendingDirs(pending);
+        store.save();
+        LibraryIndex::instance().save(m_stop);   // 退出时强制落盘，平时限频
+    };
+
+    QString path;
+    while (takeNext(&path)) {
+        const QFileInfo info(path);
+        if (!info.exists()) {
+            store.remove(path);
+            continue;
+        }
+
+        const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+        if (!store.isFresh(path, mtime, info.size())) {
+            const MediaMeta meta = probeFile(path);
+            store.insert(path, meta);
+            emit metadataReady(path, meta);
+        }
+
+        if (saveTimer.elapsed() > SaveIntervalMs) {
+            persist();
+            saveTimer.restart();
+        }
+        msleep(CrawlSleepMs);
+    }
+
+    persist();
+}
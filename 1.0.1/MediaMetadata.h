@@ -0,0 +1,112 @@
+#ifndef MEDIAMETADATA_H
+#define MEDIAMETADATA_H
+
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QSize>
+#include <QHash>
+#include <QMetaType>
+#include <QReadWriteLock>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QSet>
+#include <atomic>
+
+// 单个文件的探测结果；mtime + size 用来判断缓存是否过期
+struct MediaMeta {
+    qint64 mtime = 0;           // 毫秒时间戳
+    qint64 size = 0;
+    double duration = 0.0;      // 秒，图片为 0
+    QSize resolution;
+    QString codec;
+};
+Q_DECLARE_METATYPE(MediaMeta)
+
+// 角标文字："1:23:45" / "4:05"
+QString formatDuration(double seconds);
+// 视频按常见档位显示（4K / 1080p / 720p），其余显示 宽x高
+QString resolutionLabel(const QSize &size, bool isVideo);
+
+// 持久化的元数据库（AppDataLocation/media_metadata.json），线程安全
+// 同时保存媒体库根目录和爬取进度，重启后从上次的位置继续
+class MetadataStore {
+public:
+    static MetadataStore &instance();
+
+    bool lookup(const QString &path, MediaMeta *meta) const;
+    bool contains(const QString &path) const;
+    // 有记录且与文件当前的 mtime/size 一致
+    bool isFresh(const QString &path, qint64 mtime, qint64 size) const;
+    void insert(const QString &path, const MediaMeta &meta);
+    void remove(const QString &path);
+    void rename(const QString &oldPath, const QString &newPath);
+    // 删掉 dir 下（不含子目录）已经不在 present 里的记录
+    void removeMissing(const QString &dir, const QSet<QString> &present);
+
+    QStringList libraryRoots() const;
+    void addLibraryRoot(const QString &dir);
+
+    // 爬取进度：尚未处理完的目录
+    QStringList pendingDirs() const;
+    void setPendingDirs(const QStringList &dirs);
+
+    void save();
+
+private:
+    MetadataStore();
+    Q_DISABLE_COPY(MetadataStore)
+    void load();
+    QString filePath() const;
+
+    mutable QReadWriteLock m_lock;
+    QHash<QString, MediaMeta> m_entries;
+    QStringList m_roots;
+    QStringList m_pendingDirs;
+    bool m_dirty = false;
+};
+
+// 低优先级的后台爬虫：逐个探测当前目录和媒体库根目录下的文件
+// 缩略图等交互任务运行时暂停，让出磁盘和 CPU
+class MetadataCrawler : public QThread {
+    Q_OBJECT
+public:
+    explicit MetadataCrawler(QObject *parent = nullptr);
+    ~MetadataCrawler() override;
+
+    // 当前目录的文件插到队首，优先处理；replace 为 false 时追加到已有的优先队列后面
+    void prioritize(const QStringList &files, bool replace = true);
+    // 把新的根目录加入爬取范围
+    void addRoot(const QString &dir);
+    // 目录监视报告的变化：重新枚举这些目录，并清掉已删除文件的记录
+    // recursive 为 false 时只看目录本身的文件（子目录的变化会单独报告）
+    void rescan(const QStringList &dirs, bool recursive);
+    void setPaused(bool paused);
+    void stop();
+
+    // 单个文件的探测，爬虫和按需调用共用；阻塞，只能在工作线程调用
+    static MediaMeta probeFile(const QString &path);
+
+signals:
+    void metadataReady(const QString &path, const MediaMeta &meta);
+
+protected:
+    void run() override;
+
+private:
+    bool takeNext(QString *path);
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    QQueue<QString> m_priority;     // 当前目录
+    QQueue<QString> m_files;        // 正在处理的目录里的文件
+    QStringList m_dirs;             // 待枚举的目录（持久化）
+    QStringList m_rescanDirs;       // 只枚举本层、需要清理记录的目录
+    QSet<QString> m_queued;
+    bool m_paused = false;
+    std::atomic<bool> m_stop { false };
+};
+
+#endif // MEDIAMETADATA_H
@@ -0,0 +1,707 @@
+#include "MediaProbe.h"
+#include "BinaryReader.h"
+
+#include <QFile>
+#include <QByteArray>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// moov 一般只有几百 KB，长片的索引也很少超过几 MB；超过这个值视为异常文件
+const qint64 MaxIndexSize = 32 * 1024 * 1024;
+// 顶层结构最多扫描的元素数，防止损坏文件造成长时间循环
+const int MaxTopLevelCount = 256;
+
+QString fourccString(quint32 v)
+{
+    char s[4];
+    qToBigEndian(v, s);
+    return QString::fromLatin1(s, 4).trimmed();
+}
+
+// ---------------------------------------------------------
+// ISO-BMFF：只读 moov，mdat 只跳过不读
+// ---------------------------------------------------------
+
+// mvhd / mdhd 结构相同：version 决定时间字段是 32 还是 64 位
+bool readTimescaleDuration(const QByteArray &d, const BmffBox &box, quint32 *timescale, quint64 *duration)
+{
+    const int p = box.payload;
+    if (p + 4 > box.end)
+        return false;
+    const int version = uchar(d[p]);
+    if (version == 1) {
+        if (p + 32 > box.end)
+            return false;
+        *timescale = be32(d, p + 20);
+        *duration = be64(d, p + 24);
+    } else {
+        if (p + 20 > box.end)
+            return false;
+        *timescale = be32(d, p + 12);
+        *duration = be32(d, p + 16);
+    }
+    return *timescale != 0;
+}
+
+struct Mp4Track {
+    bool isVideo = false;
+    quint32 codec = 0;
+    QSize size;
+    quint32 timescale = 0;
+    quint64 duration = 0;
+    QVector<double> keyframes;
+};
+
+// stts + stss：把关键帧的样本序号换算成解码时间
+QVector<double> keyframeTimes(const QByteArray &d, const BmffBox &stts, const BmffBox &stss, quint32 timescale)
+{
+    QVector<double> times;
+    int p = stss.payload + 4;
+    if (p + 4 > stss.end)
+        return times;
+    const quint32 syncCount = be32(d, p);
+    p += 4;
+    if (quint64(p) + quint64(syncCount) * 4 > quint64(stss.end))
+        return times;
+
+    int q = stts.payload + 4;
+    if (q + 4 > stts.end)
+        return times;
+    const quint32 runCount = be32(d, q);
+    q += 4;
+    if (quint64(q) + quint64(runCount) * 8 > quint64(stts.end))
+        return times;
+
+    times.reserve(int(syncCount));
+    // 两个表都按样本序号递增，一次线性扫描即可
+    quint64 runFirstSample = 1; // 当前 run 的第一个样本序号（1 起）
+    quint64 runStartTime = 0;
+    quint32 run = 0;
+    quint32 runSamples = runCount ? be32(d, q) : 0;
+    quint32 runDelta = runCount ? be32(d, q + 4) : 0;
+    for (quint32 i = 0; i < syncCount; ++i) {
+        const quint32 sample = be32(d, p + int(i) * 4);
+        while (run < runCount && sample >= runFirstSample + runSamples) {
+            runFirstSample += runSamples;
+            runStartTime += quint64(runSamples) * runDelta;
+            if (++run < runCount) {
+                runSamples = be32(d, q + int(run) * 8);
+                runDelta = be32(d, q + int(run) * 8 + 4);
+            }
+        }
+        if (run >= runCount)
+            break;
+        const quint64 t = runStartTime + (sample - runFirstSample) * quint64(runDelta);
+        times.append(double(t) / timescale);
+    }
+    return times;
+}
+
+bool parseTrak(const QByteArray &d, const BmffBox &trak, Mp4Track *track)
+{
+    BmffBox mdia, hdlr, mdhd, minf, stbl, stsd;
+    if (!findChild(d, trak, "mdia", &mdia) || !findChild(d, mdia, "hdlr", &hdlr))
+        return false;
+    if (hdlr.payload + 12 > hdlr.end)
+        return false;
+    track->isVideo = be32(d, hdlr.payload + 8) == fourcc("vide");
+    if (!track->isVideo)
+        return true;
+
+    if (findChild(d, mdia, "mdhd", &mdhd))
+        readTimescaleDuration(d, mdhd, &track->timescale, &track->duration);
+
+    // tkhd 末尾是 16.16 定点的显示宽高（已经考虑了像素宽高比）
+    BmffBox tkhd;
+    if (findChild(d, trak, "tkhd", &tkhd) && tkhd.end - tkhd.payload >= 84) {
+        track->size = QSize(int(be32(d, tkhd.end - 8) >> 16), int(be32(d, tkhd.end - 4) >> 16));
+    }
+
+    if (!findChild(d, mdia, "minf", &minf) || !findChild(d, minf, "stbl", &stbl))
+        return true;
+
+    // stsd 第一项：视频样本描述，类型即编码（avc1/hvc1/...），偏移 24 处是编码宽高
+    if (findChild(d, stbl, "stsd", &stsd)) {
+        int pos = stsd.payload + 8;
+        BmffBox entry;
+        if (nextBox(d, pos, stsd.end, &entry)) {
+            track->codec = entry.type;
+            if (entry.payload + 28 <= entry.end && track->size.isEmpty()) {
+                const uchar *p = reinterpret_cast<const uchar *>(d.constData()) + entry.payload + 24;
+                track->size = QSize(qFromBigEndian<quint16>(p), qFromBigEndian<quint16>(p + 2));
+            }
+        }
+    }
+
+    // 没有 stss 说明每个样本都是关键帧（例如全 I 帧编码），这时不提供列表
+    BmffBox stts, stss;
+    if (track->timescale && findChild(d, stbl, "stts", &stts) && findChild(d, stbl, "stss", &stss))
+        track->keyframes = keyframeTimes(d, stts, stss, track->timescale);
+    return true;
+}
+
+// 顶层盒子只读头部后跳过，直到找到 moov（可能在 mdat 之后）
+bool loadMoov(QFile &file, QByteArray *moov)
+{
+    qint64 pos = 0;
+    const qint64 fileSize = file.size();
+    for (int i = 0; i < MaxTopLevelCount && pos + 8 <= fileSize; ++i) {
+        BmffBoxHeader box;
+        if (!readBoxHeader(&file, pos, fileSize, &box))
+            return false;
+        const quint32 type = box.type;
+        const quint64 size = box.size;
+        const int header = box.header;
+
+        if (i == 0 && type != fourcc("ftyp") && type != fourcc("moov")
+            && type != fourcc("free") && type != fourcc("wide") && type != fourcc("mdat"))
+            return false;
+
+        if (type == fourcc("moov")) {
+            if (size > quint64(MaxIndexSize) || !file.seek(pos + header))
+                return false;
+            *moov = file.read(qint64(size) - header);
+            return moov->size() == qint64(size) - header;
+        }
+        pos += qint64(size);
+    }
+    return false;
+}
+
+bool probeMp4(QFile &file, MediaInfo *info)
+{
+    QByteArray moov;
+    if (!loadMoov(file, &moov))
+        return false;
+
+    const BmffBox root{ 0, 0, int(moov.size()) };
+    info->container = "mp4";
+
+    BmffBox mvhd;
+    quint32 timescale = 0;
+    quint64 duration = 0;
+    if (findChild(moov, root, "mvhd", &mvhd) && readTimescaleDuration(moov, mvhd, &timescale, &duration))
+        info->durationSeconds = double(duration) / timescale;
+
+    int p = 0;
+    BmffBox b;
+    while (nextBox(moov, p, root.end, &b)) {
+        if (b.type != fourcc("trak"))
+            continue;
+        Mp4Track track;
+        if (!parseTrak(moov, b, &track) || !track.isVideo)
+            continue;
+        info->videoCodec = fourccString(track.codec);
+        info->resolution = track.size;
+        info->keyframes = track.keyframes;
+        if (info->durationSeconds <= 0.0 && track.timescale)
+            info->durationSeconds = double(track.duration) / track.timescale;
+        break;
+    }
+    info->valid = true;
+    return true;
+}
+
+// iTunes 风格元数据：moov/udta/meta/ilst/covr/data（mov 里 meta 也可能直接挂在 moov 下）
+QByteArray mp4CoverArt(QFile &file)
+{
+    QByteArray moov;
+    if (!loadMoov(file, &moov))
+        return QByteArray();
+
+    const BmffBox root{ 0, 0, int(moov.size()) };
+    BmffBox udta, meta;
+    bool found = findChild(moov, root, "udta", &udta) && findChild(moov, udta, "meta", &meta);
+    if (!found)
+        found = findChild(moov, root, "meta", &meta);
+    if (!found)
+        return QByteArray();
+
+    // MP4 的 meta 是 FullBox（多 4 字节 version/flags），QuickTime 的不是
+    if (meta.payload + 8 <= meta.end && be32(moov, meta.payload + 4) != fourcc("hdlr"))
+        meta.payload += 4;
+
+    BmffBox ilst, covr, data;
+    if (!findChild(moov, meta, "ilst", &ilst) || !findChild(moov, ilst, "covr", &covr)
+        || !findChild(moov, covr, "data", &data))
+        return QByteArray();
+
+    // data 盒子：4 字节类型（13 = JPEG，14 = PNG）+ 4 字节 locale，之后就是图片
+    if (data.payload + 8 >= data.end)
+        return QByteArray();
+    return moov.mid(data.payload + 8, data.end - data.payload - 8);
+}
+
+// ---------------------------------------------------------
+// Matroska / WebM：EBML，只读 Info / Tracks / Cues 三个一级元素
+// ---------------------------------------------------------
+const quint32 IdEbml = 0x1A45DFA3;
+const quint32 IdSegment = 0x18538067;
+const quint32 IdSeekHead = 0x114D9B74;
+const quint32 IdSeek = 0x4DBB;
+const quint32 IdSeekId = 0x53AB;
+const quint32 IdSeekPosition = 0x53AC;
+const quint32 IdInfo = 0x1549A966;
+const quint32 IdTimecodeScale = 0x2AD7B1;
+const quint32 IdDuration = 0x4489;
+const quint32 IdTracks = 0x1654AE6B;
+const quint32 IdTrackEntry = 0xAE;
+const quint32 IdTrackNumber = 0xD7;
+const quint32 IdTrackType = 0x83;
+const quint32 IdCodecId = 0x86;
+const quint32 IdVideo = 0xE0;
+const quint32 IdPixelWidth = 0xB0;
+const quint32 IdPixelHeight = 0xBA;
+const quint32 IdDisplayWidth = 0x54B0;
+const quint32 IdDisplayHeight = 0x54BA;
+const quint32 IdCues = 0x1C53BB6B;
+const quint32 IdCuePoint = 0xBB;
+const quint32 IdCueTime = 0xB3;
+const quint32 IdCueTrackPositions = 0xB7;
+const quint32 IdCueTrack = 0xF7;
+const quint32 IdCluster = 0x1F43B675;
+const quint32 IdAttachments = 0x1941A469;
+const quint32 IdAttachedFile = 0x61A7;
+const quint32 IdFileName = 0x466E;
+const quint32 IdFileMimeType = 0x4660;
+const quint32 IdFileData = 0x465C;
+
+const quint64 UnknownSize = ~quint64(0);
+
+struct Element {
+    quint32 id = 0;
+    quint64 size = 0;  // UnknownSize 表示长度未知（直播录制的文件常见）
+    int header = 0;
+};
+
+// 变长整数：前导 0 的个数决定长度；keepMarker 为 true 时保留长度标记位（用于 ID）
+bool readVint(const uchar *p, int avail, bool keepMarker, quint64 *value, int *len)
+{
+    if (avail < 1 || p[0] == 0)
+        return false;
+    int n = 1;
+    uchar mask = 0x80;
+    while (!(p[0] & mask)) {
+        mask >>= 1;
+        ++n;
+    }
+    if (n > 8 || n > avail)
+        return false;
+    quint64 v = keepMarker ? p[0] : (p[0] & (mask - 1));
+    bool allOnes = (p[0] & (mask - 1)) == (mask - 1);
+    for (int i = 1; i < n; ++i) {
+        v = (v << 8) | p[i];
+        allOnes = allOnes && p[i] == 0xFF;
+    }
+    *value = (!keepMarker && allOnes) ? UnknownSize : v;
+    *len = n;
+    return true;
+}
+
+bool parseElementHeader(const uchar *p, int avail, Element *e)
+{
+    quint64 id = 0;
+    int idLen = 0, sizeLen = 0;
+    if (!readVint(p, avail, true, &id, &idLen) || idLen > 4)
+        return false;
+    if (!readVint(p + idLen, avail - idLen, false, &e->size, &sizeLen))
+        return false;
+    e->id = quint32(id);
+    e->header = idLen + sizeLen;
+    return true;
+}
+
+bool readElementAt(QFile &file, qint64 pos, Element *e)
+{
+    uchar hdr[12];
+    const qint64 avail = qMin<qint64>(sizeof(hdr), file.size() - pos);
+    if (avail < 2 || !readAt(&file, pos, reinterpret_cast<char *>(hdr), avail))
+        return false;
+    return parseElementHeader(hdr, int(avail), e);
+}
+
+// 在内存中的元素内容里逐个遍历子元素
+struct EbmlCursor {
+    const QByteArray &d;
+    int pos;
+    int end;
+
+    bool next(Element *e, int *payload)
+    {
+        if (pos >= end)
+            return false;
+        const uchar *p = reinterpret_cast<const uchar *>(d.constData()) + pos;
+        if (!parseElementHeader(p, end - pos, e))
+            return false;
+        *payload = pos + e->header;
+        // 子元素长度未知时只能截到父元素结尾
+        const quint64 size = e->size == UnknownSize ? quint64(end - *payload) : e->size;
+        if (quint64(*payload) + size > quint64(end))
+            return false;
+        e->size = size;
+        pos = *payload + int(size);
+        return true;
+    }
+};
+
+quint64 readUInt(const QByteArray &d, int payload, quint64 size)
+{
+    quint64 v = 0;
+    for (quint64 i = 0; i < size && i < 8; ++i)
+        v = (v << 8) | uchar(d[payload + int(i)]);
+    return v;
+}
+
+double readFloat(const QByteArray &d, int payload, quint64 size)
+{
+    const uchar *p = reinterpret_cast<const uchar *>(d.constData()) + payload;
+    if (size == 4) {
+        const quint32 bits = qFromBigEndian<quint32>(p);
+        float f;
+        std::memcpy(&f, &bits, 4);
+        return f;
+    }
+    if (size == 8) {
+        const quint64 bits = qFromBigEndian<quint64>(p);
+        double v;
+        std::memcpy(&v, &bits, 8);
+        return v;
+    }
+    return 0.0;
+}
+
+struct MkvState {
+    quint64 timecodeScale = 1000000; // 纳秒，默认 1 ms
+    double duration = 0.0;           // 以 timecodeScale 为单位
+    quint64 videoTrack = 0;
+    qint64 cuesPos = -1;             // 由 SeekHead 给出，相对 Segment 数据起点
+    qint64 attachmentsPos = -1;      // 同上
+    bool haveInfo = false;
+    bool haveTracks = false;
+    bool haveCues = false;
+};
+
+void parseSeekHead(const QByteArray &d, MkvState *st)
+{
+    EbmlCursor seekHead{ d, 0, int(d.size()) };
+    Element e;
+    int payload = 0;
+    while (seekHead.next(&e, &payload)) {
+        if (e.id != IdSeek)
+            continue;
+        EbmlCursor seek{ d, payload, payload + int(e.size) };
+        Element c;
+        int cp = 0;
+        quint64 id = 0, position = 0;
+        while (seek.next(&c, &cp)) {
+            if (c.id == IdSeekId)
+                id = readUInt(d, cp, c.size);
+            else if (c.id == IdSeekPosition)
+                position = readUInt(d, cp, c.size);
+        }
+        if (id == IdCues)
+            st->cuesPos = qint64(position);
+        else if (id == IdAttachments)
+            st->attachmentsPos = qint64(position);
+    }
+}
+
+void parseInfo(const QByteArray &d, MkvState *st)
+{
+    EbmlCursor info{ d, 0, int(d.size()) };
+    Element e;
+    int payload = 0;
+    while (info.next(&e, &payload)) {
+        if (e.id == IdTimecodeScale)
+            st->timecodeScale = qMax<quint64>(1, readUInt(d, payload, e.size));
+        else if (e.id == IdDuration)
+            st->duration = readFloat(d, payload, e.size);
+    }
+    st->haveInfo = true;
+}
+
+void parseTracks(const QByteArray &d, MkvState *st, MediaInfo *info)
+{
+    EbmlCursor tracks{ d, 0, int(d.size()) };
+    Element e;
+    int payload = 0;
+    while (tracks.next(&e, &payload)) {
+        if (e.id != IdTrackEntry)
+            continue;
+        EbmlCursor entry{ d, payload, payload + int(e.size) };
+        Element c;
+        int cp = 0;
+        quint64 number = 0, type = 0;
+        QString codec;
+        QSize pixels, display;
+        while (entry.next(&c, &cp)) {
+            if (c.id == IdTrackNumber) {
+                number = readUInt(d, cp, c.size);
+            } else if (c.id == IdTrackType) {
+                type = readUInt(d, cp, c.size);
+            } else if (c.id == IdCodecId) {
+                codec = QString::fromLatin1(d.constData() + cp, int(c.size));
+                codec.remove(QChar('\0'));
+            } else if (c.id == IdVideo) {
+                EbmlCursor video{ d, cp, cp + int(c.size) };
+                Element v;
+                int vp = 0;
+                while (video.next(&v, &vp)) {
+                    const int value = int(readUInt(d, vp, v.size));
+                    if (v.id == IdPixelWidth) pixels.setWidth(value);
+                    else if (v.id == IdPixelHeight) pixels.setHeight(value);
+                    else if (v.id == IdDisplayWidth) display.setWidth(value);
+                    else if (v.id == IdDisplayHeight) display.setHeight(value);
+                }
+            }
+        }
+        if (type == 1 && st->videoTrack == 0) {
+            st->videoTrack = number;
+            info->videoCodec = codec;
+            info->resolution = display.isValid() && !display.isEmpty() ? display : pixels;
+        }
+    }
+    st->haveTracks = true;
+}
+
+void parseCues(const QByteArray &d, const MkvState &st, MediaInfo *info)
+{
+    EbmlCursor cues{ d, 0, int(d.size()) };
+    Element e;
+    int payload = 0;
+    const double scale = double(st.timecodeScale) / 1e9;
+    while (cues.next(&e, &payload)) {
+        if (e.id != IdCuePoint)
+            continue;
+        EbmlCursor point{ d, payload, payload + int(e.size) };
+        Element c;
+        int cp = 0;
+        quint64 time = 0;
+        bool onVideo = false;
+        while (point.next(&c, &cp)) {
+            if (c.id == IdCueTime) {
+                time = readUInt(d, cp, c.size);
+            } else if (c.id == IdCueTrackPositions) {
+                EbmlCursor pos{ d, cp, cp + int(c.size) };
+                Element t;
+                int tp = 0;
+                while (pos.next(&t, &tp)) {
+                    if (t.id == IdCueTrack && readUInt(d, tp, t.size) == st.videoTrack)
+                        onVideo = true;
+                }
+            }
+        }
+        if (onVideo)
+            info->keyframes.append(time * scale);
+    }
+    std::sort(info->keyframes.begin(), info->keyframes.end());
+}
+
+bool readPayload(QFile &file, qint64 pos, const Element &e, QByteArray *out)
+{
+    if (e.size == UnknownSize || e.size > quint64(MaxIndexSize) || !file.seek(pos + e.header))
+        return false;
+    *out = file.read(qint64(e.size));
+    return out->size() == qint64(e.size);
+}
+
+// 定位 Segment，并顺序扫描一级元素直到第一个 Cluster；wantIndex 为 false 时只看 SeekHead
+bool scanMatroska(QFile &file, MediaInfo *info, MkvState *st, qint64 *segmentData, bool wantIndex)
+{
+    Element e;
+    if (!readElementAt(file, 0, &e) || e.id != IdEbml || e.size == UnknownSize)
+        return false;
+
+    // 跳过 EBML 头，之后是 Segment
+    qint64 pos = e.header + qint64(e.size);
+    if (!readElementAt(file, pos, &e) || e.id != IdSegment)
+        return false;
+    *segmentData = pos + e.header;
+    const qint64 segmentEnd = e.size == UnknownSize ? file.size()
+                                                    : qMin(file.size(), *segmentData + qint64(e.size));
+
+    // 顺序扫描一级元素，遇到第一个 Cluster 就停下（后面都是媒体数据）
+    pos = *segmentData;
+    for (int i = 0; i < MaxTopLevelCount && pos < segmentEnd; ++i) {
+        if (!readElementAt(file, pos, &e))
+            break;
+        if (e.id == IdCluster)
+            break;
+
+        QByteArray payload;
+        if (e.id == IdSeekHead && readPayload(file, pos, e, &payload)) {
+            parseSeekHead(payload, st);
+        } else if (e.id == IdAttachments) {
+            st->attachmentsPos = pos - *segmentData; // 附件可能很大（字体），只记位置
+        } else if (!wantIndex) {
+            // 只找附件时不解析其余元素
+        } else if (e.id == IdInfo && readPayload(file, pos, e, &payload)) {
+            parseInfo(payload, st);
+        } else if (e.id == IdTracks && readPayload(file, pos, e, &payload)) {
+            parseTracks(payload, st, info);
+        } else if (e.id == IdCues && st->haveTracks && readPayload(file, pos, e, &payload)) {
+            parseCues(payload, *st, info);
+            st->haveCues = true;
+        }
+        if (e.size == UnknownSize)
+            break;
+        pos += e.header + qint64(e.size);
+    }
+    return true;
+}
+
+bool probeMatroska(QFile &file, MediaInfo *info)
+{
+    MkvState st;
+    qint64 segmentData = 0;
+    if (!scanMatroska(file, info, &st, &segmentData, true))
+        return false;
+    info->container = "matroska";
+
+    // Cues 通常写在文件末尾，通过 SeekHead 直接跳过去
+    Element e;
+    if (!st.haveCues && st.haveTracks && st.cuesPos >= 0) {
+        const qint64 cuesAt = segmentData + st.cuesPos;
+        QByteArray payload;
+        if (readElementAt(file, cuesAt, &e) && e.id == IdCues && readPayload(file, cuesAt, e, &payload))
+            parseCues(payload, st, info);
+    }
+
+    if (!st.haveInfo)
+        return false;
+    info->durationSeconds = st.duration * double(st.timecodeScale) / 1e9;
+    info->valid = true;
+    return true;
+}
+
+// 附件逐个读头部，只把选中的那一个的数据读进内存
+QByteArray matroskaCoverArt(QFile &file)
+{
+    MediaInfo unused;
+    MkvState st;
+    qint64 segmentData = 0;
+    if (!scanMatroska(file, &unused, &st, &segmentData, false) || st.attachmentsPos < 0)
+        return QByteArray();
+
+    const qint64 attachmentsAt = segmentData + st.attachmentsPos;
+    Element e;
+    if (!readElementAt(file, attachmentsAt, &e) || e.id != IdAttachments || e.size == UnknownSize)
+        return QByteArray();
+
+    // 约定的封面名：cover.jpg / cover.png，其次 small_cover / cover_land 等变体
+    int bestRank = 0;
+    qint64 bestData = -1;
+    qint64 bestSize = 0;
+
+    qint64 pos = attachmentsAt + e.header;
+    const qint64 end = pos + qint64(e.size);
+    for (int i = 0; i < MaxTopLevelCount && pos < end; ++i) {
+        Element attached;
+        if (!readElementAt(file, pos, &attached) || attached.size == UnknownSize)
+            break;
+        const qint64 next = pos + attached.header + qint64(attached.size);
+
+        if (attached.id == IdAttachedFile) {
+            QString name, mime;
+            qint64 dataAt = -1, dataSize = 0;
+            qint64 p = pos + attached.header;
+            while (p < next) {
+                Element c;
+                if (!readElementAt(file, p, &c) || c.size == UnknownSize)
+                    break;
+                if ((c.id == IdFileName || c.id == IdFileMimeType) && c.size < 1024) {
+                    QByteArray text;
+                    if (readPayload(file, p, c, &text)) {
+                        (c.id == IdFileName ? name : mime) =
+                            QString::fromUtf8(text.constData(), int(text.size())).toLower();
+                    }
+                } else if (c.id == IdFileData) {
+                    dataAt = p + c.header;
+                    dataSize = qint64(c.size);
+                }
+                p += c.header + qint64(c.size);
+            }
+
+            int rank = 0;
+            if (mime.startsWith("image/jpeg") || mime.startsWith("image/png")) {
+                if (name.startsWith("cover."))
+                    rank = 3;
+                else if (name.startsWith("cover"))
+                    rank = 2;
+                else if (name.contains("cover"))
+                    rank = 1;
+            }
+            if (rank > bestRank && dataAt >= 0) {
+                bestRank = rank;
+                bestData = dataAt;
+                bestSize = dataSize;
+            }
+        }
+        pos = next;
+    }
+
+    if (bestData < 0 || bestSize > MaxIndexSize || !file.seek(bestData))
+        return QByteArray();
+    const QByteArray data = file.read(bestSize);
+    return data.size() == bestSize ? data : QByteArray();
+}
+
+} // namespace
+
+MediaInfo probeMedia(const QString &path)
+{
+    MediaInfo info;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return info;
+
+    // 按魔数而不是后缀判断容器
+    char magic[8];
+    if (!readAt(&file, 0, magic, sizeof(magic)))
+        return info;
+
+    if (qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(magic)) == IdEbml) {
+        if (!probeMatroska(file, &info))
+            info = MediaInfo();
+    } else if (!probeMp4(file, &info)) {
+        info = MediaInfo();
+    }
+    return info;
+}
+
+double nearestKeyframe(const MediaInfo &info, double seconds,
+                       double minSeconds, double maxSeconds)
+{
+    const QVector<double> &keys = info.keyframes;
+    auto it = std::lower_bound(keys.begin(), keys.end(), minSeconds);
+    double best = seconds;
+    double bestDistance = -1.0;
+    for (; it != keys.end() && *it < maxSeconds; ++it) {
+        const double distance = qAbs(*it - seconds);
+        if (bestDistance < 0.0 || distance < bestDistance) {
+            best = *it;
+            bestDistance = distance;
+        } else {
+            break; // 关键帧升序，距离开始变大就可以停了
+        }
+    }
+    return best;
+}
+
+QByteArray extractCoverArt(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    char magic[4];
+    if (!readAt(&file, 0, magic, sizeof(magic)))
+        return QByteArray();
+    if (qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(magic)) == IdEbml)
+        return matroskaCoverArt(file);
+    return mp4CoverArt(file);
+}
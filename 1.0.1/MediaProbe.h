@@ -0,0 +1,33 @@
+#ifndef MEDIAPROBE_H
+#define MEDIAPROBE_H
+
+#pragma once
+#include <QString>
+#include <QSize>
+#include <QVector>
+#include <QByteArray>
+
+// 进程内的容器解析：ISO-BMFF（mp4/mov/m4v）与 Matroska（mkv/webm）
+// 只读文件头和索引（moov / Info+Tracks+Cues），不解码任何数据，也不启动 ffprobe
+
+struct MediaInfo {
+    bool valid = false;
+    QString container;          // "mp4" / "matroska"
+    QString videoCodec;         // 例如 avc1 / hvc1 / V_MPEG4/ISO/AVC
+    QSize resolution;           // 第一条视频轨的显示尺寸
+    double durationSeconds = 0.0;
+    QVector<double> keyframes;  // 视频轨关键帧时间（秒，升序）；为空表示容器没有索引
+};
+
+MediaInfo probeMedia(const QString &path);
+
+// 在 [minSeconds, maxSeconds) 内找离 seconds 最近的关键帧；没有则原样返回 seconds
+// ffmpeg 的 -ss 落在关键帧上时只需解码一帧，截图既准又快
+double nearestKeyframe(const MediaInfo &info, double seconds,
+                       double minSeconds, double maxSeconds);
+
+// 容器内嵌的封面图原始数据（JPEG/PNG）：Matroska 附件 cover.jpg 等，MP4 的 covr
+// 只读取选中的那一个附件，字体等其他附件只读头部；没有封面返回空
+QByteArray extractCoverArt(const QString &path);
+
+#endif // MEDIAPROBE_H
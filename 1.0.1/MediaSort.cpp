@@ -0,0 +1,102 @@
+#include "MediaSort.h"
+
+#include <QCollator>
+#include <QCollatorSortKey>
+#include <QHash>
+#include <QLocale>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// 排序键缓存数量上限，超过后整体清空重建，避免浏览过的目录无限累积
+const int MaxCachedKeys = 500000;
+
+// 文件名 -> 排序键；QCollator 不是线程安全的，计算和查找都在锁内
+class CollationKeyCache {
+public:
+    CollationKeyCache()
+    {
+        m_collator.setNumericMode(true);
+        m_collator.setCaseSensitivity(Qt::CaseInsensitive);
+    }
+
+    QVector<QCollatorSortKey> keysFor(const QVector<SortEntry> &entries)
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // 系统语言变了，之前的键不能再用
+        if (m_collator.locale() != QLocale()) {
+            m_collator.setLocale(QLocale());
+            m_keys.clear();
+        }
+        if (m_keys.size() > MaxCachedKeys)
+            m_keys.clear();
+
+        QVector<QCollatorSortKey> keys;
+        keys.reserve(entries.size());
+        for (const SortEntry &e : entries) {
+            auto it = m_keys.constFind(e.name);
+            if (it == m_keys.constEnd())
+                it = m_keys.insert(e.name, m_collator.sortKey(e.name));
+            keys.append(it.value());
+        }
+        return keys;
+    }
+
+private:
+    QMutex m_mutex;
+    QCollator m_collator;
+    QHash<QString, QCollatorSortKey> m_keys;
+};
+
+CollationKeyCache &collationKeys()
+{
+    static CollationKeyCache cache;
+    return cache;
+}
+
+} // namespace
+
+QStringList sortEntries(const QVector<SortEntry> &entries, SortField field, bool descending)
+{
+    const QVector<QCollatorSortKey> keys = collationKeys().keysFor(entries);
+
+    QVector<int> order(entries.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    // 主键相同的按名称排，名称总是升序，这样切换方向时同值的一组内不会乱跳
+    auto byField = [&](int a, int b) -> int {
+        const SortEntry &x = entries.at(a);
+        const SortEntry &y = entries.at(b);
+        switch (field) {
+        case SortField::Date:       return x.mtime < y.mtime ? -1 : (x.mtime > y.mtime ? 1 : 0);
+        case SortField::Size:       return x.size < y.size ? -1 : (x.size > y.size ? 1 : 0);
+        case SortField::Duration:   return x.duration < y.duration ? -1 : (x.duration > y.duration ? 1 : 0);
+        case SortField::Resolution: return x.pixels < y.pixels ? -1 : (x.pixels > y.pixels ? 1 : 0);
+        case SortField::Name:       break;
+        }
+        return keys.at(a).compare(keys.at(b));
+    };
+
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        const int c = byField(a, b);
+        if (c != 0)
+            return descending ? c > 0 : c < 0;
+        if (field != SortField::Name) {
+            const int n = keys.at(a).compare(keys.at(b));
+            if (n != 0)
+                return n < 0;
+        }
+        return a < b;   // 完全相同时保持原有顺序，结果稳定
+    });
+
+    QStringList paths;
+    paths.reserve(order.size());
+    for (int i : std::as_const(order))
+        paths.append(entries.at(i).path);
+    return paths;
+}
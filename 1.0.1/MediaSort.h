@@ -0,0 +1,52 @@
+#ifndef MEDIASORT_H
+#define MEDIASORT_H
+
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QListWidgetItem>
+#include <climits>
+
+// 网格的排序方式；名称按本地化规则做自然排序（"ep2" 在 "ep10" 之前）
+enum class SortField {
+    Name,
+    Date,
+    Size,
+    Duration,
+    Resolution
+};
+
+// 排序所需的字段快照：GUI 线程从条目上取出，交给工作线程排序
+struct SortEntry {
+    QString path;
+    QString name;
+    qint64 mtime = 0;
+    qint64 size = 0;
+    double duration = 0.0;
+    qint64 pixels = 0;      // 宽 x 高，未知为 0
+};
+
+// 阻塞，只在工作线程调用；返回排好序的路径
+// 文件名的排序键（QCollator::sortKey）每个文件只算一次，之后的重排只比较键
+QStringList sortEntries(const QVector<SortEntry> &entries, SortField field, bool descending);
+
+// 按工作线程算好的名次排序的条目，QListWidget::sortItems 只做整数比较
+class SortableListItem : public QListWidgetItem {
+public:
+    using QListWidgetItem::QListWidgetItem;
+
+    void setSortRank(int rank) { m_sortRank = rank; }
+    int sortRank() const { return m_sortRank; }
+
+    bool operator<(const QListWidgetItem &other) const override {
+        if (auto *o = dynamic_cast<const SortableListItem *>(&other))
+            return m_sortRank < o->m_sortRank;
+        return QListWidgetItem::operator<(other);
+    }
+
+private:
+    int m_sortRank = INT_MAX;   // 还没参与过排序的排在最后
+};
+
+#endif // MEDIASORT_H
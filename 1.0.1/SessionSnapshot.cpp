@@ -0,0 +1,79 @@
+#include "SessionSnapshot.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QStandardPaths>
+
+namespace {
+
+const quint32 SnapshotMagic = 0x58535353; // "XSSS"
+const quint32 SnapshotVersion = 1;
+
+} // namespace
+
+QString sessionSnapshotPath()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (dir.isEmpty())
+        dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    QDir().mkpath(dir);
+    return dir + "/session.bin";
+}
+
+bool loadSessionSnapshot(SessionSnapshot *snapshot)
+{
+    QFile f(sessionSnapshotPath());
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+
+    // 文件不大，一次读进内存再解析，比逐字段读 QFile 少很多系统调用
+    const QByteArray data = f.readAll();
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0, version = 0, count = 0;
+    in >> magic >> version;
+    if (magic != SnapshotMagic || version != SnapshotVersion)
+        return false;
+
+    SessionSnapshot s;
+    in >> s.path >> s.showImages >> s.showVideos >> s.sortField >> s.descending
+       >> s.zoom >> s.scrollPosition >> s.thumbnailDpr >> s.subdirs >> count;
+    if (in.status() != QDataStream::Ok)
+        return false;
+
+    // count 来自文件，损坏时可能很大：预留有上限，超出的部分照常 append
+    s.items.reserve(int(qMin(count, 65536u)));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        SessionItem item;
+        in >> item.name >> item.isVideo >> item.size >> item.mtime >> item.duration
+           >> item.resolution >> item.codec >> item.mipLevel >> item.thumbnail;
+        s.items.append(item);
+    }
+    if (in.status() != QDataStream::Ok || s.path.isEmpty())
+        return false;   // 截断的快照不用，走正常加载
+
+    *snapshot = s;
+    return true;
+}
+
+bool saveSessionSnapshot(const SessionSnapshot &s)
+{
+    QSaveFile f(sessionSnapshotPath());
+    if (!f.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << SnapshotMagic << SnapshotVersion;
+    out << s.path << s.showImages << s.showVideos << s.sortField << s.descending
+        << s.zoom << s.scrollPosition << s.thumbnailDpr << s.subdirs << quint32(s.items.size());
+    for (const SessionItem &item : s.items) {
+        out << item.name << item.isVideo << item.size << item.mtime << item.duration
+            << item.resolution << item.codec << item.mipLevel << item.thumbnail;
+    }
+    return f.commit();
+}
@@ -0,0 +1,43 @@
+#ifndef SESSIONSNAPSHOT_H
+#define SESSIONSNAPSHOT_H
+
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QSize>
+
+// 上次会话的快照（AppDataLocation/session.bin）：退出时保存最后打开的目录，
+// 启动时直接画出来，再在后台和磁盘比对。只存画第一屏需要的东西
+
+struct SessionItem {
+    QString name;               // 文件名，完整路径 = 目录 + 文件名
+    bool isVideo = false;
+    qint64 size = 0;
+    qint64 mtime = 0;           // 毫秒
+    double duration = 0.0;      // 元数据角标
+    QSize resolution;
+    QString codec;
+    int mipLevel = 0;           // 缩略图档位，0 表示没有保存缩略图
+    QByteArray thumbnail;       // JPEG，只保存离开时视口里的条目
+};
+
+struct SessionSnapshot {
+    QString path;               // 目录（cleanPath）
+    bool showImages = true;
+    bool showVideos = true;
+    int sortField = 0;          // SortField
+    bool descending = false;
+    int zoom = 100;             // 网格缩放百分比
+    int scrollPosition = 0;
+    double thumbnailDpr = 1.0;  // 缩略图生成时的 DPR
+    QStringList subdirs;        // 左侧子文件夹列表
+    QVector<SessionItem> items; // 按显示顺序
+};
+
+QString sessionSnapshotPath();
+bool loadSessionSnapshot(SessionSnapshot *snapshot);
+bool saveSessionSnapshot(const SessionSnapshot &snapshot);
+
+#endif // SESSIONSNAPSHOT_H
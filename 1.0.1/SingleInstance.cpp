@@ -0,0 +1,98 @@
+#include "SingleInstance.h"
+
+#include <QDir>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QCryptographicHash>
+
+namespace {
+
+// 连接本机的管道，正常几毫秒；对方卡死时不要让新进程一直等
+const int ConnectTimeoutMs = 500;
+// 对方打开目录（枚举 + 建条目）后才回复，大目录可能要久一点
+const int OpenTimeoutMs = 5000;
+// 一行就是一个路径，超过这个长度的请求直接丢弃
+const qint64 MaxRequestBytes = 64 * 1024;
+
+} // namespace
+
+SingleInstance::SingleInstance(QObject *parent)
+    : QObject(parent)
+{
+}
+
+QString SingleInstance::serverName()
+{
+    const QByteArray user = QCryptographicHash::hash(QDir::homePath().toUtf8(),
+                                                     QCryptographicHash::Md5).toHex().left(12);
+    return "xsimplemedia-" + QString::fromLatin1(user);
+}
+
+SingleInstance::ForwardResult SingleInstance::forwardToRunning(const QString &path)
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+    if (!socket.waitForConnected(ConnectTimeoutMs)) {
+        // 只有确定没人在监听才算没有实例；超时等其他错误说明对方在但卡住了
+        const QLocalSocket::LocalSocketError error = socket.error();
+        if (error == QLocalSocket::ServerNotFoundError || error == QLocalSocket::ConnectionRefusedError)
+            return NoInstance;
+        return Unreachable;
+    }
+
+    socket.write(path.toUtf8() + '\n');
+    if (!socket.waitForBytesWritten(ConnectTimeoutMs))
+        return Unreachable;
+
+    // 对方打开完才回复；超时说明它还在忙，请求已经排在它那里，稍后会打开
+    while (!socket.canReadLine()) {
+        if (!socket.waitForReadyRead(OpenTimeoutMs))
+            return socket.state() == QLocalSocket::ConnectedState ? Forwarded : Unreachable;
+    }
+    return socket.readLine().trimmed() == "ok" ? Forwarded : Unreachable;
+}
+
+SingleInstance::ListenResult SingleInstance::listen(const QString &path)
+{
+    m_server = new QLocalServer(this);
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+
+    if (!m_server->listen(serverName())) {
+        if (m_server->serverError() != QAbstractSocket::AddressInUseError)
+            return Failed;
+        // 名字被占用：可能是同时启动的另一个进程刚抢先监听，再转发一次；
+        // 确定没人监听才是上次异常退出留下的套接字文件，删掉重来。
+        // 对方只是忙的时候绝不能删，否则会出现两个主实例
+        switch (forwardToRunning(path)) {
+        case Forwarded:
+            return Handed;
+        case Unreachable:
+            return Busy;
+        case NoInstance:
+            break;
+        }
+        QLocalServer::removeServer(serverName());
+        if (!m_server->listen(serverName()))
+            return Failed;
+    }
+
+    connect(m_server, &QLocalServer::newConnection, this, [this]() {
+        while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+            connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+            connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+                if (!socket->canReadLine()) {
+                    if (socket->bytesAvailable() > MaxRequestBytes)
+                        socket->abort();
+                    return;
+                }
+                const QString path = QString::fromUtf8(socket->readLine()).trimmed();
+                // 接收方同步打开，回复时目录已经显示出来
+                emit openRequested(path);
+                socket->write("ok\n");
+                socket->flush();
+                socket->disconnectFromServer();
+            });
+        }
+    });
+    return Listening;
+}
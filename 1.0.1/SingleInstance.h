@@ -0,0 +1,52 @@
+#ifndef SINGLEINSTANCE_H
+#define SINGLEINSTANCE_H
+
+#pragma once
+#include <QObject>
+#include <QString>
+
+class QLocalServer;
+
+// 单实例：第一个进程在本地套接字（Windows 上是命名管道）上监听，
+// 之后启动的进程把要打开的路径转给它，然后直接退出。
+// 这样文件夹关联、脚本启动都复用已经热起来的进程（目录缓存、缩略图、ffmpeg 进程表），
+// 也不会有两个进程同时写同一个 thumb_<md5>.jpg
+class SingleInstance : public QObject {
+    Q_OBJECT
+public:
+    explicit SingleInstance(QObject *parent = nullptr);
+
+    enum ForwardResult {
+        NoInstance,     // 没有实例在监听（或只剩残留的套接字文件），本进程可以成为主实例
+        Forwarded,      // 路径已经交给正在运行的实例，本进程应直接退出
+        Unreachable     // 有实例占着服务名但连不上或请求没送到：不能取代它，本进程报错退出
+    };
+
+    // 已有实例在运行：把路径转过去，等它打开后返回 Forwarded。
+    // 对方正忙（打开大目录）没在超时内回复时请求已经送到，同样算 Forwarded。
+    // path 为空时只是把已有窗口提到前台
+    static ForwardResult forwardToRunning(const QString &path);
+
+    enum ListenResult {
+        Listening,      // 成为主实例
+        Handed,         // 抢注时发现另一个实例刚起来，path 已经转给它，本进程应直接退出
+        Busy,           // 另一个实例占着服务名但没响应，本进程应报错退出
+        Failed          // 无法监听，本进程照常运行但不接收转发
+    };
+
+    // 成为主实例，开始接收其他进程转来的路径。forwardToRunning 失败后应立刻调用，
+    // 不要等窗口建好，免得两个同时启动的进程都当上主实例。
+    // 收到的连接要到事件循环跑起来才处理，期间先排在监听队列里
+    ListenResult listen(const QString &path);
+
+    // 当前用户的服务名；不同用户的实例互不干扰
+    static QString serverName();
+
+signals:
+    void openRequested(const QString &path);
+
+private:
+    QLocalServer *m_server = nullptr;
+};
+
+#endif // SINGLEINSTANCE_H
@@ -0,0 +1,93 @@
+#include "StoryboardUtil.h"
+#include "FfmpegUtil.h"
+#include "MediaProbe.h"
+
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QtGlobal>
+
+namespace {
+
+// 帧数随时长增加：短片 16 帧，长片最多 64 帧，保持 8 的倍数以填满每一行
+int frameCountForDuration(double seconds)
+{
+    const int frames = int(seconds / 10.0);
+    return qBound(2, (frames + StoryboardColumns - 1) / StoryboardColumns, 8) * StoryboardColumns;
+}
+
+} // namespace
+
+QString storyboardCachePath(const QString &videoPath)
+{
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    const QByteArray hash = QCryptographicHash::hash(videoPath.toUtf8(), QCryptographicHash::Md5);
+    return cacheDir + "/story_" + hash.toHex() + ".jpg";
+}
+
+QImage loadOrCreateStoryboard(const QString &videoPath)
+{
+    const QString cacheFile = storyboardCachePath(videoPath);
+
+    if (!QFile::exists(cacheFile)) {
+        double duration = probeMedia(videoPath).durationSeconds;
+        if (duration <= 0.0)
+            duration = probeDurationSeconds(videoPath);
+        if (duration <= 0.0)
+            return QImage();
+
+        QDir().mkpath(QFileInfo(cacheFile).absolutePath());
+
+        const int frames = frameCountForDuration(duration);
+        const int rows = frames / StoryboardColumns;
+        const int w = StoryboardFrameSize.width();
+        const int h = StoryboardFrameSize.height();
+
+        // 一次解码：-skip_frame nokey 让解码器只输出关键帧，
+        // fps 按时长均匀取 frames 帧，缩成小图后由 tile 拼成一张
+        const QString filter =
+            QString("fps=%1/%2,scale=%3:%4:force_original_aspect_ratio=decrease,"
+                    "pad=%3:%4:(ow-iw)/2:(oh-ih)/2,tile=%5x%6")
+                .arg(frames)
+                .arg(duration, 0, 'f', 3)
+                .arg(w).arg(h)
+                .arg(StoryboardColumns).arg(rows);
+
+        QStringList args;
+        args << "-skip_frame" << "nokey"
+             << "-i" << videoPath
+             << "-an" << "-sn"
+             << "-vf" << filter
+             << "-frames:v" << "1"
+             << "-q:v" << "5"
+             << "-threads" << "1"
+             << cacheFile << "-y";
+        runFfmpegBlocking(args);
+    }
+
+    QImage sheet(cacheFile);
+    if (sheet.isNull() || storyboardFrameCount(sheet.size()) == 0)
+        return QImage();
+    return sheet;
+}
+
+int storyboardFrameCount(const QSize &sheetSize)
+{
+    if (sheetSize.width() != StoryboardColumns * StoryboardFrameSize.width())
+        return 0;
+    return StoryboardColumns * (sheetSize.height() / StoryboardFrameSize.height());
+}
+
+QRect storyboardFrameRect(const QSize &sheetSize, qreal position)
+{
+    const int count = storyboardFrameCount(sheetSize);
+    if (count == 0)
+        return QRect();
+
+    const int index = qBound(0, int(position * count), count - 1);
+    return QRect(QPoint((index % StoryboardColumns) * StoryboardFrameSize.width(),
+                        (index / StoryboardColumns) * StoryboardFrameSize.height()),
+                 StoryboardFrameSize);
+}
@@ -0,0 +1,28 @@
+#ifndef STORYBOARDUTIL_H
+#define STORYBOARDUTIL_H
+
+#pragma once
+#include <QString>
+#include <QImage>
+#include <QRect>
+#include <QSize>
+
+// 悬停预览用的故事板：一张 8 列的雪碧图，每格一帧 160x90
+// 只解码关键帧、一次 ffmpeg 调用生成，存放在缩略图缓存目录（story_<md5>.jpg）
+
+const int StoryboardColumns = 8;
+const QSize StoryboardFrameSize(160, 90);
+
+// 缓存文件路径（与 thumb_<md5>.jpg 同目录）
+QString storyboardCachePath(const QString &videoPath);
+
+// 读取缓存的故事板，没有则先生成；阻塞，只能在工作线程调用
+QImage loadOrCreateStoryboard(const QString &videoPath);
+
+// 雪碧图中的帧数（按图片尺寸推算）
+int storyboardFrameCount(const QSize &sheetSize);
+
+// position 取 0~1（光标在格子里的水平位置），返回对应帧在雪碧图中的区域
+QRect storyboardFrameRect(const QSize &sheetSize, qreal position);
+
+#endif // STORYBOARDUTIL_H
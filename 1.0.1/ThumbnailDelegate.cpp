@@ -1,12 +1,214 @@
 #include "ThumbnailDelegate.h"
+#include "StoryboardUtil.h"
+#include "MediaMetadata.h"
+#include "ImageScaler.h"
 
 #include <QPainter>
 #include <QIcon>
+#include <QPixmap>
 #include <QFont>
 #include <QFontMetrics>
+#include <QCursor>
+#include <QAbstractItemView>
+#include <QPointF>
+
+namespace {
+
+// 只构造一次，paint 里不再从字符串解析颜色
+const QColor SelectedColor(0x3e, 0xa6, 0xff);
+const QColor HoverColor(0x2d, 0x2d, 0x2d);
+const QColor PlaceholderColor(0x26, 0x26, 0x26);
+const QColor TitleColor(0xe0, 0xe0, 0xe0);
+const QColor BadgeColor(0, 0, 0, 180);
+
+const int PlayOverlayRadius = 20;
+
+QFont makeFont(int pointSize, bool bold)
+{
+    QFont font("Segoe UI", pointSize);
+    font.setBold(bold);
+    return font;
+}
+
+QStaticText makeStaticText(const QString &text, const QFont &font)
+{
+    QStaticText staticText(text);
+    staticText.setTextFormat(Qt::PlainText);
+    staticText.setPerformanceHint(QStaticText::AggressiveCaching);
+    staticText.prepare(QTransform(), font);
+    return staticText;
+}
+
+// 静态文字在框里居中的左上角
+QPointF centeredIn(const QRect &box, const QStaticText &text)
+{
+    const QSizeF size = text.size();
+    return QPointF(box.left() + (box.width() - size.width()) / 2.0,
+                   box.top() + (box.height() - size.height()) / 2.0);
+}
+
+} // namespace
 
 ThumbnailDelegate::ThumbnailDelegate(QObject *parent)
-    : QStyledItemDelegate(parent) {}
+    : QStyledItemDelegate(parent),
+      m_titleFont(makeFont(9, false)),
+      m_badgeFont(makeFont(8, true)),
+      m_titleMetrics(m_titleFont),
+      m_badgeMetrics(m_badgeFont) {
+    m_storyboards.setMaxCost(64 * 1024); // 约 64 MB
+    m_paintCache.setMaxCost(64 * 1024);  // 约 64 MB，够几屏的格子
+    m_scalePool.setMaxThreadCount(1);
+}
+
+ThumbnailDelegate::~ThumbnailDelegate()
+{
+    // 缩放结果投递回本对象，先等后台线程结束
+    m_scalePool.clear();
+    m_scalePool.waitForDone();
+}
+
+const ThumbnailDelegate::PaintEntry *ThumbnailDelegate::paintEntry(const QModelIndex &index,
+                                                                   const QVariant &decoration,
+                                                                   const QSize &contentSize,
+                                                                   int textWidth, qreal dpr) const
+{
+    const QString path = index.data(Qt::UserRole).toString();
+    const QString text = index.data(Qt::DisplayRole).toString();
+    const QSize resolution = index.data(Qt::UserRole + 5).toSize();
+    const double duration = index.data(Qt::UserRole + 4).toDouble();
+    const bool isPixmap = decoration.userType() == QMetaType::QPixmap;
+    const qint64 decorationKey = isPixmap ? decoration.value<QPixmap>().cacheKey()
+                                          : decoration.value<QIcon>().cacheKey();
+
+    const PaintEntry *cached = m_paintCache.object(path);
+    const bool pixmapValid = cached && cached->decorationKey == decorationKey
+                             && cached->contentSize == contentSize && cached->dpr == dpr;
+    const bool textValid = cached && cached->text == text && cached->textWidth == textWidth;
+    const bool badgesValid = cached && cached->resolution == resolution && cached->duration == duration;
+    if (pixmapValid && textValid && badgesValid) {
+        // 上一次缩放的结果被更新的数据作废了：再排一次
+        if (!cached->scaled && isPixmap && !m_scalePending.contains(path))
+            requestScaled(path, decoration.value<QPixmap>(), decorationKey,
+                          (QSizeF(cached->pixmapSize) * dpr).toSize(), dpr);
+        return cached;
+    }
+
+    // 只重建变了的部分
+    PaintEntry *entry = new PaintEntry(cached ? *cached : PaintEntry());
+
+    if (!pixmapValid) {
+        entry->decorationKey = decorationKey;
+        entry->contentSize = contentSize;
+        entry->dpr = dpr;
+        if (isPixmap) {
+            // 已生成的是某一档 mip，按比例缩到内容区的设备像素尺寸，之后每次只贴图
+            const QPixmap pix = decoration.value<QPixmap>();
+            entry->pixmapSize = pix.deviceIndependentSize().toSize().scaled(contentSize,
+                                                                            Qt::KeepAspectRatio);
+            const QSize device = (QSizeF(entry->pixmapSize) * dpr).toSize();
+            entry->pixmap = pix;
+            entry->scaled = pix.isNull() || pix.size() == device;
+            if (!entry->scaled)
+                requestScaled(path, pix, decorationKey, device, dpr);
+        } else {
+            // 默认图标仍是 QIcon
+            entry->pixmap = decoration.value<QIcon>().pixmap(contentSize, dpr);
+            entry->pixmapSize = entry->pixmap.deviceIndependentSize().toSize();
+            entry->scaled = true;
+        }
+    }
+
+    if (!textValid) {
+        entry->text = text;
+        entry->textWidth = textWidth;
+        entry->title = makeStaticText(m_titleMetrics.elidedText(text, Qt::ElideRight, textWidth),
+                                      m_titleFont);
+    }
+
+    if (!badgesValid) {
+        // 角标：左上分辨率，右下时长（后台爬虫探测到后才有）
+        const bool isVideo = index.data(Qt::UserRole + 1).toBool();
+        const QString res = resolutionLabel(resolution, isVideo);
+        const QString length = (isVideo && duration > 0) ? formatDuration(duration) : QString();
+        entry->resolution = resolution;
+        entry->duration = duration;
+        entry->resBadge = makeStaticText(res, m_badgeFont);
+        entry->resBadgeSize = res.isEmpty()
+            ? QSize() : QSize(m_badgeMetrics.horizontalAdvance(res) + 8, m_badgeMetrics.height() + 2);
+        entry->durationBadge = makeStaticText(length, m_badgeFont);
+        entry->durationBadgeSize = length.isEmpty()
+            ? QSize() : QSize(m_badgeMetrics.horizontalAdvance(length) + 8, m_badgeMetrics.height() + 2);
+    }
+
+    const int cost = qMax<qsizetype>(1, qsizetype(entry->pixmap.width()) * entry->pixmap.height() * 4 / 1024);
+    if (cost > m_paintCache.maxCost()) {
+        m_oversizedEntry = *entry;
+        delete entry;
+        return &m_oversizedEntry;
+    }
+    m_paintCache.insert(path, entry, cost);
+    return entry;
+}
+
+void ThumbnailDelegate::requestScaled(const QString &path, const QPixmap &pix, qint64 decorationKey,
+                                      const QSize &device, qreal dpr) const
+{
+    m_scalePending.insert(path);
+    // 光栅后端的 toImage 与 QPixmap 共享像素，不复制；重采样放到后台线程
+    const QImage img = pix.toImage();
+    auto *self = const_cast<ThumbnailDelegate *>(this);
+    m_scalePool.start([self, path, img, decorationKey, device, dpr]() {
+        QImage scaled = scaleImage(img, device);
+        QMetaObject::invokeMethod(self, [self, path, decorationKey, dpr, scaled]() {
+            self->applyScaled(path, decorationKey, dpr, scaled);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ThumbnailDelegate::applyScaled(const QString &path, qint64 decorationKey, qreal dpr,
+                                    const QImage &scaled)
+{
+    m_scalePending.remove(path);
+    PaintEntry *entry = m_paintCache.object(path);
+    // 期间缩放、换了 DPR 或换了缩略图：结果不对，下次 paint 会重新排
+    if (!entry || scaled.isNull() || entry->decorationKey != decorationKey || entry->dpr != dpr
+        || (QSizeF(entry->pixmapSize) * dpr).toSize() != scaled.size())
+        return;
+
+    entry->pixmap = QPixmap::fromImage(scaled);
+    entry->pixmap.setDevicePixelRatio(dpr);
+    entry->scaled = true;
+    if (m_viewport)
+        m_viewport->update();
+}
+
+const QPixmap &ThumbnailDelegate::playOverlay(qreal dpr) const
+{
+    // 半透明圆底 + 白色三角，按 DPR 预先画好，每个视频格子只贴一次图
+    if (m_playOverlay.isNull() || m_playOverlay.devicePixelRatio() != dpr) {
+        const int d = PlayOverlayRadius * 2;
+        QPixmap sprite(QSize(d, d) * dpr);
+        sprite.setDevicePixelRatio(dpr);
+        sprite.fill(Qt::transparent);
+
+        QPainter p(&sprite);
+        p.setRenderHint(QPainter::Antialiasing);
+        p.setPen(Qt::NoPen);
+        p.setBrush(QColor(0, 0, 0, 150));
+        p.drawEllipse(QPointF(PlayOverlayRadius, PlayOverlayRadius), PlayOverlayRadius, PlayOverlayRadius);
+
+        p.setBrush(Qt::white);
+        const QPointF tri[3] = {
+            QPointF(PlayOverlayRadius - 6, PlayOverlayRadius - 8),
+            QPointF(PlayOverlayRadius - 6, PlayOverlayRadius + 8),
+            QPointF(PlayOverlayRadius + 8, PlayOverlayRadius),
+        };
+        p.drawPolygon(tri, 3);
+        p.end();
+        m_playOverlay = sprite;
+    }
+    return m_playOverlay;
+}
 
 void ThumbnailDelegate::paint(QPainter *painter,
                               const QStyleOptionViewItem &option,
@@ -14,23 +216,16 @@ void ThumbnailDelegate::paint(QPainter *painter,
     painter->save();
     painter->setRenderHint(QPainter::Antialiasing);
 
-    // 数据
-    QString text = index.data(Qt::DisplayRole).toString();
-    QIcon icon = index.data(Qt::DecorationRole).value<QIcon>();
+    const QVariant decoration = index.data(Qt::DecorationRole);
+    const bool isVideo = index.data(Qt::UserRole + 1).toBool();
 
     QRect rect = option.rect;
     rect.adjust(6, 6, -6, -6); // 边距
 
     // 背景 (选中/悬停)
-    QColor bgColor = Qt::transparent;
-    if (option.state & QStyle::State_Selected) {
-        bgColor = QColor("#3ea6ff");
-    } else if (option.state & QStyle::State_MouseOver) {
-        bgColor = QColor("#2d2d2d");
-    }
-
-    if (bgColor != Qt::transparent) {
-        painter->setBrush(bgColor);
+    const bool selected = option.state & QStyle::State_Selected;
+    if (selected || (option.state & QStyle::State_MouseOver)) {
+        painter->setBrush(selected ? SelectedColor : HoverColor);
         painter->setPen(Qt::NoPen);
         painter->drawRoundedRect(rect, 8, 8);
     }
@@ -38,54 +233,133 @@ void ThumbnailDelegate::paint(QPainter *painter,
     // 预留底部区域给文字
     QRect contentRect(rect.left() + 8, rect.top() + 8,
                       rect.width() - 16, rect.height() - 40);
+    QRect textRect(rect.left() + 5,
+                   rect.bottom() - 30,
+                   rect.width() - 10,
+                   25);
+
+    const qreal dpr = painter->device()->devicePixelRatioF();
+    const PaintEntry *entry = paintEntry(index, decoration, contentRect.size(), textRect.width(), dpr);
+
+    // 悬停在视频上且故事板已在内存：按光标横向位置取对应帧
+    const QPixmap *storyboard = nullptr;
+    auto *view = qobject_cast<const QAbstractItemView *>(option.widget);
+    if (isVideo && view && (option.state & QStyle::State_MouseOver))
+        storyboard = m_storyboards.object(index.data(Qt::UserRole).toString());
 
-    // 缩略图
-    if (!icon.isNull()) {
-        QPixmap pix = icon.pixmap(contentRect.size());
+    if (!entry->pixmap.isNull()) {
+        const QSize pixSize = entry->pixmapSize;
 
         // 图片在容器中的位置
         int x = contentRect.left() +
-                (contentRect.width() - pix.width()) / 2 + 18;
+                (contentRect.width() - pixSize.width()) / 2 + 18;
         int y = contentRect.top() +
-                (contentRect.height() - pix.height()) / 2 + 5;
+                (contentRect.height() - pixSize.height()) / 2 + 5;
+
+        // 缩略图还没到但已知尺寸（文件头/元数据库）：先按真实比例画占位框，
+        // 位置与之后的缩略图一致，加载完成时不会跳动
+        if (decoration.userType() != QMetaType::QPixmap && !entry->resolution.isEmpty()) {
+            const QSize frameSize = entry->resolution.scaled(contentRect.size(), Qt::KeepAspectRatio);
+            const QRect frame(contentRect.left() + (contentRect.width() - frameSize.width()) / 2 + 18,
+                              contentRect.top() + (contentRect.height() - frameSize.height()) / 2 + 5,
+                              frameSize.width(), frameSize.height());
+            painter->setPen(Qt::NoPen);
+            painter->setBrush(PlaceholderColor);
+            painter->drawRoundedRect(frame, 4, 4);
+        }
+
+        if (storyboard) {
+            const int cursorX = view->viewport()->mapFromGlobal(QCursor::pos()).x();
+            const qreal position = qBound<qreal>(0.0, qreal(cursorX - rect.left()) / rect.width(), 1.0);
+            const QRect frame = storyboardFrameRect(storyboard->size(), position);
+            const QSize frameSize = StoryboardFrameSize.scaled(contentRect.size(), Qt::KeepAspectRatio);
+            const QRect target(contentRect.left() + (contentRect.width() - frameSize.width()) / 2,
+                               contentRect.top() + (contentRect.height() - frameSize.height()) / 2,
+                               frameSize.width(), frameSize.height());
 
-        painter->drawPixmap(x, y, pix);
+            painter->setRenderHint(QPainter::SmoothPixmapTransform);
+            painter->drawPixmap(target, *storyboard, frame);
 
-        // 如果是视频，绘制播放三角形
-        bool isVideo = index.data(Qt::UserRole + 1).toBool();
-        if (isVideo) {
-            painter->setBrush(QColor(0, 0, 0, 150));
+            // 底部进度条
             painter->setPen(Qt::NoPen);
-            painter->drawEllipse(contentRect.center(), 20, 20);
-
-            painter->setBrush(Qt::white);
-            QPoint center = contentRect.center();
-            QPolygon tri;
-            tri << QPoint(center.x() - 6, center.y() - 8)
-                << QPoint(center.x() - 6, center.y() + 8)
-                << QPoint(center.x() + 8, center.y());
-            painter->drawPolygon(tri);
+            painter->setBrush(QColor(255, 255, 255, 60));
+            painter->drawRect(target.left(), target.bottom() - 2, target.width(), 3);
+            painter->setBrush(QColor(0xff, 0, 0));
+            painter->drawRect(target.left(), target.bottom() - 2, int(target.width() * position), 3);
+        } else {
+            if (entry->scaled) {
+                // 缓存里已经是最终尺寸，按原尺寸贴图
+                painter->drawPixmap(QPoint(x, y), entry->pixmap);
+            } else {
+                // 后台缩放还没回来：这一帧直接把 mip 图画进目标框
+                painter->drawPixmap(QRect(QPoint(x, y), pixSize), entry->pixmap);
+                if (view)
+                    m_viewport = view->viewport();
+            }
         }
+
+        // 如果是视频，绘制播放按钮（拖动预览时不遮挡画面）
+        if (isVideo && !storyboard)
+            painter->drawPixmap(contentRect.center() - QPoint(PlayOverlayRadius, PlayOverlayRadius),
+                                playOverlay(dpr));
     }
 
-    // 文字，超出用省略号
-    QRect textRect(rect.left() + 5,
-                   rect.bottom() - 30,
-                   rect.width() - 10,
-                   25);
-    painter->setPen((option.state & QStyle::State_Selected)
-                        ? Qt::black
-                        : QColor("#e0e0e0"));
-    painter->setFont(QFont("Segoe UI", 9));
+    // 角标：左上分辨率，右下时长（拖动预览时时长让位给进度条）
+    painter->setFont(m_badgeFont);
+    auto drawBadge = [&](const QStaticText &text, const QSize &size, bool bottomRight) {
+        const QPoint topLeft = bottomRight
+            ? QPoint(contentRect.right() - size.width() - 3, contentRect.bottom() - size.height() - 3)
+            : QPoint(contentRect.left() + 3, contentRect.top() + 3);
+        const QRect badge(topLeft, size);
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(BadgeColor);
+        painter->drawRoundedRect(badge, 3, 3);
+        painter->setPen(Qt::white);
+        painter->drawStaticText(centeredIn(badge, text), text);
+    };
 
-    QString elidedText =
-        painter->fontMetrics().elidedText(text, Qt::ElideRight, textRect.width());
-    painter->drawText(textRect, Qt::AlignCenter, elidedText);
+    if (!entry->resBadgeSize.isEmpty())
+        drawBadge(entry->resBadge, entry->resBadgeSize, false);
+    if (!entry->durationBadgeSize.isEmpty() && !storyboard)
+        drawBadge(entry->durationBadge, entry->durationBadgeSize, true);
+
+    // 文字，超出用省略号（缓存里已经省略好）
+    painter->setPen(selected ? QColor(Qt::black) : TitleColor);
+    painter->setFont(m_titleFont);
+    painter->drawStaticText(centeredIn(textRect, entry->title), entry->title);
 
     painter->restore();
 }
 
 QSize ThumbnailDelegate::sizeHint(const QStyleOptionViewItem &,
                                   const QModelIndex &) const {
-    return QSize(180, 160);
+    // 外边距 12、内边距 16、底部文字 40 固定，只有缩略图区域随缩放变化
+    const QSize thumb = thumbnailSize();
+    return QSize(thumb.width() + 12 + 16, thumb.height() + 12 + 40);
+}
+
+void ThumbnailDelegate::setZoom(qreal zoom) {
+    m_zoom = qBound<qreal>(0.5, zoom, 2.5);
+    m_paintCache.clear();   // 格子尺寸全变了，旧的缩放结果都用不上
+}
+
+QSize ThumbnailDelegate::thumbnailSize() const {
+    // 默认 152x108，与 paint 中 contentRect 的计算保持一致
+    return QSize(qRound(152 * m_zoom), qRound(108 * m_zoom));
+}
+
+int ThumbnailDelegate::mipLevelFor(const QSize &devicePixels) {
+    const int longEdge = qMax(devicePixels.width(), devicePixels.height());
+    for (int level = 128; level < MaxMipLevel; level *= 2) {
+        if (longEdge <= level)
+            return level;
+    }
+    return MaxMipLevel;
+}
+
+void ThumbnailDelegate::setStoryboard(const QString &path, const QImage &sheet) {
+    if (sheet.isNull())
+        return;
+    QPixmap *pix = new QPixmap(QPixmap::fromImage(sheet));
+    m_storyboards.insert(path, pix, qMax<qsizetype>(1, sheet.sizeInBytes() / 1024));
 }
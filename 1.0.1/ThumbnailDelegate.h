@@ -2,10 +2,20 @@
 #define THUMBNAILDELEGATE_H
 
 #include <QStyledItemDelegate>
+#include <QCache>
+#include <QPixmap>
+#include <QImage>
+#include <QFont>
+#include <QFontMetrics>
+#include <QStaticText>
+#include <QSet>
+#include <QPointer>
+#include <QThreadPool>
 
 class ThumbnailDelegate : public QStyledItemDelegate {
 public:
     explicit ThumbnailDelegate(QObject *parent = nullptr);
+    ~ThumbnailDelegate() override;
 
     void paint(QPainter *painter,
                const QStyleOptionViewItem &option,
@@ -13,6 +23,69 @@ public:
 
     QSize sizeHint(const QStyleOptionViewItem &option,
                    const QModelIndex &index) const override;
+
+    // 网格缩放倍数（1.0 = 180x160 的默认格子），由工具栏滑块调整
+    void setZoom(qreal zoom);
+    qreal zoom() const { return m_zoom; }
+
+    // 当前缩放下缩略图区域的逻辑尺寸
+    QSize thumbnailSize() const;
+
+    // 缩略图只按几档长边生成：128 / 256 / 512，按设备像素尺寸取不小于它的那一档
+    static const int MaxMipLevel = 512;
+    static int mipLevelFor(const QSize &devicePixels);
+
+    // 悬停拖动预览的故事板（内存中保留最近用过的若干张，paint 时不做任何 I/O）
+    void setStoryboard(const QString &path, const QImage &sheet);
+    bool hasStoryboard(const QString &path) const { return m_storyboards.contains(path); }
+    void removeStoryboard(const QString &path) { m_storyboards.remove(path); }
+
+    // 丢掉所有条目的绘制缓存（缩放时自动调用；基准测试用它测冷路径）
+    void clearPaintCache() { m_paintCache.clear(); }
+
+private:
+    // 每个条目（按路径）的绘制缓存：缩到最终尺寸的缩略图、省略好的文件名和角标文字。
+    // 每次 paint 只比较数据和尺寸，对得上就直接贴图、画文字，不缩放、不排版、不分配。
+    // 缩到最终尺寸在后台线程做；结果回来之前先把 mip 图按目标框直接画（不做平滑重采样）
+    struct PaintEntry {
+        qint64 decorationKey = 0;   // QPixmap / QIcon 的 cacheKey
+        QSize contentSize;
+        qreal dpr = 0.0;
+        QPixmap pixmap;             // scaled 时是设备像素的最终尺寸，drawPixmap 不再缩放
+        QSize pixmapSize;           // 逻辑尺寸
+        bool scaled = true;         // false：还是原来的 mip 图，后台缩放中
+
+        QString text;
+        int textWidth = -1;
+        QStaticText title;          // 已省略
+
+        QSize resolution;
+        double duration = -1.0;
+        QStaticText resBadge;
+        QStaticText durationBadge;
+        QSize resBadgeSize;         // 角标底框尺寸，空表示没有这个角标
+        QSize durationBadgeSize;
+    };
+
+    const PaintEntry *paintEntry(const QModelIndex &index, const QVariant &decoration,
+                                 const QSize &contentSize, int textWidth, qreal dpr) const;
+    const QPixmap &playOverlay(qreal dpr) const;   // 共用的播放按钮贴图
+    void requestScaled(const QString &path, const QPixmap &pix, qint64 decorationKey,
+                       const QSize &device, qreal dpr) const;
+    void applyScaled(const QString &path, qint64 decorationKey, qreal dpr, const QImage &scaled);
+
+    qreal m_zoom = 1.0;
+    QCache<QString, QPixmap> m_storyboards; // 路径 -> 雪碧图，代价按 KB 计
+    mutable QCache<QString, PaintEntry> m_paintCache; // 路径 -> 绘制缓存，代价按 KB 计
+    mutable PaintEntry m_oversizedEntry;    // 超过缓存上限的条目只用这一次
+    mutable QPixmap m_playOverlay;
+    mutable QThreadPool m_scalePool;        // 单线程，缩放到最终尺寸
+    mutable QSet<QString> m_scalePending;
+    mutable QPointer<QWidget> m_viewport;   // 缩放完成后刷新
+    QFont m_titleFont;
+    QFont m_badgeFont;
+    QFontMetrics m_titleMetrics;
+    QFontMetrics m_badgeMetrics;
 };
 
 #endif // THUMBNAILDELEGATE_H
@@ -1,6 +1,10 @@
 #include "VideoDetailWidget.h"
 #include "TagButton.h"
 #include "FfmpegUtil.h"
+#include "ImageScaler.h"
+#include "MediaProbe.h"
+#include "EmbeddedPreviewUtil.h"
+#include "MediaMetadata.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -12,6 +16,7 @@
 #include <QtConcurrent>
 #include <QDir>
 #include <QPixmap>
+#include <QImage>
 #include <QDesktopServices>
 #include <QUrl>
 #include <QMetaObject>
@@ -20,12 +25,29 @@
 #include <QLineEdit>
 #include <QCoreApplication>
 #include <QThreadPool>
+#include <QThread>
 #include <QCryptographicHash>
 #include <QMessageBox>      // 用于报错提示
 #include <QDialog>          // 用于自定义大窗口
 #include <QDialogButtonBox> // 用于确认/取消按钮
 #include <QEvent>
 
+namespace {
+
+// 在调用线程上读取并缩放（Lanczos-3），返回带 DPR 的 QImage；GUI 线程只需 QPixmap::fromImage
+QImage loadScaledImage(const QString &file, const QSize &box,
+                       Qt::AspectRatioMode mode, qreal dpr)
+{
+    QImage img(file);
+    if (img.isNull() || box.isEmpty())
+        return img;
+    img = scaleImage(img, box * dpr, mode, ScaleKernel::Lanczos3);
+    img.setDevicePixelRatio(dpr);
+    return img;
+}
+
+} // namespace
+
 VideoDetailWidget::VideoDetailWidget(QWidget *parent)
     : QWidget(parent)
 {
@@ -166,6 +188,12 @@ VideoDetailWidget::VideoDetailWidget(QWidget *parent)
     // === 详情页专用线程池，只跑一个截图任务，防止与目录缩略图抢资源 ===
     detailThreadPool = new QThreadPool(this);
     detailThreadPool->setMaxThreadCount(1);
+
+    // 预取在另一个单线程池里跑，线程优先级调低，不和打开的详情页抢 CPU
+    prefetchPool = new QThreadPool(this);
+    prefetchPool->setMaxThreadCount(1);
+    prefetchPool->setThreadPriority(QThread::LowPriority);
+    m_artifacts.setMaxCost(8);
 }
 
 // 事件过滤器：处理图片点击
@@ -262,26 +290,55 @@ void VideoDetailWidget::onRenameClicked() {
 }
 
 void VideoDetailWidget::setVideoPath(const QString &path) {
+    // 上一个视频还没做完的截图不再需要；这个视频如果正在预取，已产出的部分在缓存里，剩下的由前台接着做
+    if (m_currentJob)
+        m_currentJob->store(true);
+    if (const CancelToken pending = m_prefetchJobs.take(path))
+        pending->store(true);
+
     currentVideoPath = path;
     QFileInfo info(path);
     titleLabel->setText(info.fileName());
-    infoLabel->setText(QString("格式: %1 | 大小: %2 MB")
+    QString infoText = QString("格式: %1 | 大小: %2 MB")
                            .arg(info.suffix().toUpper())
-                           .arg(info.size() / 1024.0 / 1024.0, 0, 'f', 1));
+                           .arg(info.size() / 1024.0 / 1024.0, 0, 'f', 1);
+
+    // 后台爬虫探测过的话，补上时长、分辨率和编码
+    MediaMeta meta;
+    if (MetadataStore::instance().lookup(path, &meta)) {
+        if (meta.duration > 0)
+            infoText += QString(" | 时长: %1").arg(formatDuration(meta.duration));
+        if (!meta.resolution.isEmpty())
+            infoText += QString(" | %1x%2").arg(meta.resolution.width()).arg(meta.resolution.height());
+        if (!meta.codec.isEmpty())
+            infoText += QString(" | %1").arg(meta.codec);
+    }
+    infoLabel->setText(infoText);
+
+    // 预取过的产物直接显示，只补还没有的部分
+    const QVector<bool> need = missingArtifacts(path);
+    if (const DetailArtifacts *cached = cachedArtifacts(path)) {
+        if (!need[0])
+            showArtifact(0, cached->cover, QString());
+        for (int i = 0; i < ShotCount; ++i) {
+            if (!need[i + 1])
+                showArtifact(i + 1, cached->shots[i], cached->shotPaths[i]);
+        }
+    }
 
-    // 先尝试用目录缩略图缓存作为初始封面，避免首次全黑
-    bool coverSet = false;
+    // 没有封面时先尝试用目录缩略图缓存作为初始封面，避免首次全黑
+    bool coverSet = !need[0];
     QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
-    if (!cacheDir.isEmpty()) {
+    if (!coverSet && !cacheDir.isEmpty()) {
         QByteArray hash = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Md5);
         QString cacheFile = cacheDir + "/thumb_" + hash.toHex() + ".jpg";
         if (QFile::exists(cacheFile)) {
-            QPixmap p(cacheFile);
-            if (!p.isNull()) {
-                coverLabel->setPixmap(
-                    p.scaled(coverLabel->size(),
-                             Qt::KeepAspectRatioByExpanding,
-                             Qt::SmoothTransformation));
+            // 目录缩略图只有 320 宽，同步缩放的开销很小
+            const QImage img = loadScaledImage(cacheFile, coverLabel->size(),
+                                               Qt::KeepAspectRatioByExpanding,
+                                               devicePixelRatioF());
+            if (!img.isNull()) {
+                coverLabel->setPixmap(QPixmap::fromImage(img));
                 coverSet = true;
             }
         }
@@ -290,12 +347,111 @@ void VideoDetailWidget::setVideoPath(const QString &path) {
         coverLabel->setText("Loading...");
     }
 
-    for (auto l : screenshotLabels) {
-        l->clear();
-        l->setText("...");
+    for (int i = 0; i < screenshotLabels.size(); ++i) {
+        if (!need.value(i + 1))
+            continue;
+        screenshotLabels[i]->clear();
+        screenshotLabels[i]->setText("...");
+        if (i < m_screenshotPaths.size())
+            m_screenshotPaths[i].clear();
+    }
+
+    if (need.contains(true)) {
+        m_currentJob = std::make_shared<std::atomic_bool>(false);
+        startArtifactJob(path, detailThreadPool, m_currentJob, need);
+    }
+}
+
+void VideoDetailWidget::prefetch(const QStringList &paths)
+{
+    // 用户已经移开：还没开始的任务直接跳过，正在跑的在下一次截帧前退出
+    for (auto it = m_prefetchJobs.begin(); it != m_prefetchJobs.end();) {
+        if (paths.contains(it.key())) {
+            ++it;
+        } else {
+            it.value()->store(true);
+            it = m_prefetchJobs.erase(it);
+        }
+    }
+
+    for (const QString &path : paths) {
+        if (path.isEmpty() || path == currentVideoPath || m_prefetchJobs.contains(path))
+            continue;
+        const QVector<bool> need = missingArtifacts(path);
+        if (!need.contains(true))
+            continue;
+
+        const CancelToken token = std::make_shared<std::atomic_bool>(false);
+        m_prefetchJobs.insert(path, token);
+        startArtifactJob(path, prefetchPool, token, need);
+    }
+}
+
+const VideoDetailWidget::DetailArtifacts *VideoDetailWidget::cachedArtifacts(const QString &path) const
+{
+    const DetailArtifacts *entry = m_artifacts.object(path);
+    if (!entry || entry->dpr != devicePixelRatioF() || entry->coverSize != coverLabel->size())
+        return nullptr;
+    for (int i = 0; i < screenshotLabels.size(); ++i) {
+        if (entry->shotSizes.value(i) != screenshotLabels[i]->size())
+            return nullptr;
+    }
+    return entry;
+}
+
+QVector<bool> VideoDetailWidget::missingArtifacts(const QString &path) const
+{
+    QVector<bool> need(ShotCount + 1, true);
+    if (const DetailArtifacts *entry = cachedArtifacts(path)) {
+        need[0] = entry->cover.isNull();
+        for (int i = 0; i < ShotCount; ++i)
+            need[i + 1] = entry->shots[i].isNull();
+    }
+    return need;
+}
+
+void VideoDetailWidget::storeArtifact(const QString &path, int slot, const QImage &image,
+                                      const QString &file, qreal dpr, const QSize &coverSize,
+                                      const QList<QSize> &shotSizes)
+{
+    // 尺寸变了的旧产物整条作废
+    DetailArtifacts *entry = m_artifacts.object(path);
+    if (!entry || entry->dpr != dpr || entry->coverSize != coverSize || entry->shotSizes != shotSizes) {
+        entry = new DetailArtifacts;
+        entry->dpr = dpr;
+        entry->coverSize = coverSize;
+        entry->shotSizes = shotSizes;
+        entry->shots.resize(ShotCount);
+        entry->shotPaths.resize(ShotCount);
+        m_artifacts.insert(path, entry);
+    }
+    if (slot == 0)
+        entry->cover = image;
+    else {
+        entry->shots[slot - 1] = image;
+        entry->shotPaths[slot - 1] = file;
+    }
+
+    // 如果期间切换了视频，就不更新旧视频的截图
+    if (path == currentVideoPath)
+        showArtifact(slot, image, file);
+}
+
+void VideoDetailWidget::showArtifact(int slot, const QImage &image, const QString &file)
+{
+    if (slot == 0) {
+        if (!image.isNull())
+            coverLabel->setPixmap(QPixmap::fromImage(image));
+        return;
     }
 
-    generateScreenshots();
+    const int i = slot - 1;
+    // 保存生成好的文件路径到列表
+    if (i < m_screenshotPaths.size())
+        m_screenshotPaths[i] = file;
+
+    if (i < screenshotLabels.size() && !image.isNull())
+        screenshotLabels[i]->setPixmap(QPixmap::fromImage(image));
 }
 
 void VideoDetailWidget::setTags(const QStringList &tags) {
@@ -411,28 +567,42 @@ void VideoDetailWidget::handleTagInputFinished() {
     }
 }
 
-void VideoDetailWidget::generateScreenshots() {
-    // 不再阻止新的任务，让新视频可以覆盖旧视频的截图
-    auto future = QtConcurrent::run(detailThreadPool, [this, path = currentVideoPath]() {
-        // 1. ffprobe 获取时长
-        QProcess probe;
-        probe.start("ffprobe",
-                    QStringList()
-                        << "-v" << "error"
-                        << "-show_entries" << "format=duration"
-                        << "-of" << "default=noprint_wrappers=1:nokey=1"
-                        << path);
-        probe.waitForFinished();
-
-        QString durationStr = probe.readAllStandardOutput().trimmed();
-        double totalSeconds = durationStr.toDouble();
+void VideoDetailWidget::startArtifactJob(const QString &path, QThreadPool *pool,
+                                         const CancelToken &token, const QVector<bool> &need)
+{
+    // 标签尺寸和 DPR 只能在 GUI 线程读取，先取好再交给工作线程缩放
+    const qreal dpr = devicePixelRatioF();
+    const QSize coverSize = coverLabel->size();
+    QList<QSize> shotSizes;
+    for (QLabel *label : screenshotLabels)
+        shotSizes.append(label->size());
+    const bool isPrefetch = pool == prefetchPool;
+
+    // 每一步产出立即送回 GUI 线程，进缓存；正好是当前视频就直接显示
+    auto deliver = [this, path, dpr, coverSize, shotSizes](int slot, const QImage &img, const QString &file) {
+        QMetaObject::invokeMethod(this, [this, path, slot, img, file, dpr, coverSize, shotSizes]() {
+                storeArtifact(path, slot, img, file, dpr, coverSize, shotSizes);
+            }, Qt::QueuedConnection);
+    };
+
+    auto future = QtConcurrent::run(pool,
+                                    [this, path, dpr, coverSize, shotSizes, token, need, deliver]() {
+        // 取消只在两次截帧之间检查：正在跑的那一帧做完，之后的都不做
+        if (token->load())
+            return;
+
+        // 1. 进程内解析容器头部拿到时长和关键帧索引；不认识的容器再交给内置 ffmpeg
+        const MediaInfo media = probeMedia(path);
+        double totalSeconds = media.durationSeconds;
+        if (totalSeconds <= 0)
+            totalSeconds = probeDurationSeconds(path);
 
         if (totalSeconds <= 10)
             totalSeconds = 3;
 
-        // 2. 随机 5 个时间点
-        QVector<int> timePoints;
-        int shotCount = 5;
+        // 2. 随机 5 个时间点，再吸附到同一分段内最近的关键帧上
+        QVector<double> timePoints;
+        int shotCount = ShotCount;
         double segment = totalSeconds / shotCount;
 
         for (int i = 0; i < shotCount; i++) {
@@ -444,76 +614,72 @@ void VideoDetailWidget::generateScreenshots() {
             if (t < 2) t = 2;
             if (t > totalSeconds - 1) t = static_cast<int>(totalSeconds) - 1;
 
-            timePoints.append(t);
+            timePoints.append(nearestKeyframe(media, t, qMax(minT, 2), maxT));
         }
 
         QString tempPath = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
 
         // 3. 封面：10% 处
-        int coverTime = static_cast<int>(totalSeconds * 0.10);
-        if (coverTime < 5) coverTime = 5;
-
-        QString coverShot = tempPath + "/cover_" + QFileInfo(path).fileName() + ".jpg";
-        executeFFmpeg(path, coverTime, coverShot);
-
-        QMetaObject::invokeMethod(this, [this, path, coverShot]() {
-                // 如果期间切换了视频，就不更新旧视频的截图
-                if (path != currentVideoPath)
-                    return;
-
-                QPixmap p(coverShot);
-                if (!p.isNull()) {
-                    coverLabel->setPixmap(
-                        p.scaled(coverLabel->size(),
-                                 Qt::KeepAspectRatioByExpanding,
-                                 Qt::SmoothTransformation));
-                }
-            }, Qt::QueuedConnection);
+        if (need.value(0) && !token->load()) {
+            int coverTime = static_cast<int>(totalSeconds * 0.10);
+            if (coverTime < 5) coverTime = 5;
+            const double coverSeek = nearestKeyframe(media, coverTime, coverTime - 2, coverTime + 3);
+
+            // 优先使用容器内嵌的封面图（通常是竖版海报，完整显示不裁切），没有再截一帧
+            QImage coverImg = loadVideoCoverArt(path, coverSize * dpr);
+            if (!coverImg.isNull()) {
+                coverImg.setDevicePixelRatio(dpr);
+            } else {
+                QString coverShot = tempPath + "/cover_" + QFileInfo(path).fileName() + ".jpg";
+                executeFFmpeg(path, coverSeek, coverShot);
+                coverImg = loadScaledImage(coverShot, coverSize,
+                                           Qt::KeepAspectRatioByExpanding, dpr);
+            }
+            deliver(0, coverImg, QString());
+        }
 
         // 4. 详情预览图
         for (int i = 0; i < timePoints.size(); i++) {
-            int t = timePoints[i];
+            if (!need.value(i + 1))
+                continue;
+            if (token->load())
+                return;
+
+            const double t = timePoints[i];
             QString shotPath = tempPath +
                                QString("/shot_%1_%2_%3.jpg")
                                    .arg(QFileInfo(path).fileName())
                                    .arg(i)
-                                   .arg(t);
+                                   .arg(t, 0, 'f', 2);
 
             executeFFmpeg(path, t, shotPath);
 
-            QMetaObject::invokeMethod(
-                this,
-                [this, path, i, shotPath]() {
-                    if (path != currentVideoPath)
-                        return;
-
-                    // 保存生成好的文件路径到列表
-                    if (i < m_screenshotPaths.size()) {
-                        m_screenshotPaths[i] = shotPath;
-                    }
-
-                    if (i < screenshotLabels.size()) {
-                        QPixmap p(shotPath);
-                        if (!p.isNull()) {
-                            screenshotLabels[i]->setPixmap(
-                                p.scaled(screenshotLabels[i]->size(),
-                                         Qt::KeepAspectRatio,
-                                         Qt::SmoothTransformation));
-                        }
-                    }
-                }, Qt::QueuedConnection);
+            const QImage shotImg = loadScaledImage(shotPath, shotSizes.value(i),
+                                                   Qt::KeepAspectRatio, dpr);
+            deliver(i + 1, shotImg, shotPath);
         }
     });
 
-    shotWatcher.setFuture(future);
+    if (isPrefetch) {
+        // 预取做完（或被取消）后从进行中的列表里移除，同一视频之后还能再预取
+        auto *watcher = new QFutureWatcher<void>(this);
+        connect(watcher, &QFutureWatcher<void>::finished, this, [this, watcher, path, token]() {
+            if (m_prefetchJobs.value(path) == token)
+                m_prefetchJobs.remove(path);
+            watcher->deleteLater();
+        });
+        watcher->setFuture(future);
+    } else {
+        shotWatcher.setFuture(future);
+    }
 }
 
 void VideoDetailWidget::executeFFmpeg(const QString &input,
-                                      int seconds,
+                                      double seconds,
                                       const QString &output)
 {
     QStringList args;
-    args << "-ss" << QString::number(seconds)
+    args << "-ss" << QString::number(seconds, 'f', 3)
          << "-i" << input
          << "-frames:v" << "1"
          << "-q:v" << "3"
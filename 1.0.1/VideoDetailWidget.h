@@ -7,6 +7,12 @@
 #include <QFutureWatcher>
 #include <QStringList>
 #include <QThreadPool>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QVector>
+#include <atomic>
+#include <memory>
 
 // 前置声明：防止编译时报 "unknown type name"
 class QVBoxLayout;
@@ -21,6 +27,9 @@ public:
 
     void setVideoPath(const QString &path);
     void setTags(const QStringList &tags);
+    // 预取封面和预览图（悬停的视频、详情页前后相邻的视频），低优先级后台生成；
+    // 不在这次列表里的预取任务取消
+    void prefetch(const QStringList &paths);
 
 signals:
     void backRequested();
@@ -39,8 +48,26 @@ private slots:
     void onRenameClicked();
 
 private:
-    void generateScreenshots();
-    void executeFFmpeg(const QString &input, int seconds, const QString &output);
+    // 一个视频的详情页产物：槽位 0 是封面，1..ShotCount 是预览图；按生成时的标签尺寸和 DPR 缓存
+    struct DetailArtifacts {
+        qreal dpr = 1.0;
+        QSize coverSize;
+        QList<QSize> shotSizes;
+        QImage cover;
+        QVector<QImage> shots;
+        QStringList shotPaths;
+    };
+    using CancelToken = std::shared_ptr<std::atomic_bool>;
+    static const int ShotCount = 5;
+
+    void startArtifactJob(const QString &path, QThreadPool *pool,
+                          const CancelToken &token, const QVector<bool> &need);
+    void storeArtifact(const QString &path, int slot, const QImage &image, const QString &file,
+                       qreal dpr, const QSize &coverSize, const QList<QSize> &shotSizes);
+    void showArtifact(int slot, const QImage &image, const QString &file);
+    const DetailArtifacts *cachedArtifacts(const QString &path) const; // 只返回和当前标签尺寸一致的
+    QVector<bool> missingArtifacts(const QString &path) const;
+    void executeFFmpeg(const QString &input, double seconds, const QString &output);
     void showTagInput(QPushButton *addBtn); // 辅助函数
 
 private:
@@ -57,6 +84,10 @@ private:
     // 追踪当前的输入框
     QLineEdit *m_tagInput = nullptr;
     QThreadPool *detailThreadPool = nullptr;  // 详情页专用线程池
+    QThreadPool *prefetchPool = nullptr;      // 预取专用，低优先级线程
+    CancelToken m_currentJob;                 // 当前详情页的截图任务，切换视频时取消
+    QHash<QString, CancelToken> m_prefetchJobs; // 路径 -> 进行中的预取任务
+    QCache<QString, DetailArtifacts> m_artifacts; // 最近几个视频的封面和预览图
 
     // 保存截图文件的路径，以便点击打开
     QStringList m_screenshotPaths;
@@ -2,6 +2,19 @@
 #include "ThumbnailDelegate.h"
 #include "VideoDetailWidget.h"
 #include "FfmpegUtil.h"
+#include "ImageDecoder.h"
+#include "EmbeddedPreviewUtil.h"
+#include "ImageScaler.h"
+#include "StoryboardUtil.h"
+#include "MediaMetadata.h"
+#include "ImageHeader.h"
+#include "MediaSort.h"
+#include "DirectoryWatcher.h"
+#include "LibraryIndex.h"
+#include "SessionSnapshot.h"
+#include "FolderHistory.h"
+#include "FolderTreeModel.h"
+#include "FolderStatsAggregator.h"
 
 #include <QHBoxLayout>
 #include <QVBoxLayout>
@@ -15,8 +28,6 @@
 #include <QDesktopServices>
 #include <QUrl>
 #include <QCryptographicHash>
-#include <QImageReader>
-#include <QProcess>
 #include <QtConcurrent>
 #include <QAbstractItemView>
 #include <QFile>
@@ -25,51 +36,180 @@
 #include <QJsonArray>
 #include <QTimer>
 #include <QThreadPool>
+#include <QThread>
 #include <QScrollBar>
 #include <QEvent>
-#include <QScrollArea>
+#include <QTreeView>
+#include <QHeaderView>
+#include <QSlider>
+#include <QComboBox>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QBuffer>
+#include <QSignalBlocker>
+#include <QElapsedTimer>
+#include <QDirIterator>
+
+#include <algorithm>
+
+namespace {
+
+// 生成一个网格缩略图（工作线程调用）：视频取封面图或 ffmpeg 截帧缓存，图片走解码器注册表，
+// 缩到 mipBox 以内并转成 QPixmap 的原生格式。allowFfmpeg 为 false 时视频只用已有的截帧缓存，
+// 图片也不走 ffmpeg 解码器（HEIF、没有 libwebp 时的 WebP）
+QImage loadGridThumbnail(const QString &path, bool isVideo, const QSize &mipBox, qreal dpr,
+                         bool allowFfmpeg)
+{
+    // ffmpeg 截帧缓存按最大档位的宽度生成，任一档位都可以从它缩出
+    const int THUMB_WIDTH  = ThumbnailDelegate::MaxMipLevel;
+    QImage img;
+
+    if (isVideo) {
+        QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        QDir().mkpath(cacheDir);
+
+        QByteArray hash = QCryptographicHash::hash(
+            path.toUtf8(), QCryptographicHash::Md5);
+        QString cacheFile = cacheDir + "/thumb_" + hash.toHex() + ".jpg";
+
+        // 容器里有封面图就直接用，省掉一次视频解码，也避开片头黑屏
+        if (!QFile::exists(cacheFile)) {
+            const QImage art = loadVideoCoverArt(path, QSize(THUMB_WIDTH, THUMB_WIDTH));
+            if (!art.isNull())
+                art.save(cacheFile, "JPG", 90);
+        }
+
+        if (allowFfmpeg && !QFile::exists(cacheFile)) {
+            QStringList args;
+            args << "-ss" << "5"
+                 << "-i" << path
+                 << "-frames:v" << "1"
+                 << "-q:v" << "5"
+                 << "-threads" << "1"
+                 << "-vf" << QString("scale=%1:-1").arg(THUMB_WIDTH)
+                 << cacheFile << "-y";
+
+            // 这里在后台线程调用，不会阻塞 UI
+            runFfmpegBlocking(args);
+        }
+
+        // 缓存的 jpg 同样走解码器注册表（缩放解码 + SIMD 缩放）
+        if (QFile::exists(cacheFile))
+            img = ImageDecoderRegistry::instance().decode(cacheFile, mipBox);
+    } else {
+        // 按格式路由到最快的进程内解码器，全部失败才回退到 ffmpeg（allowFfmpeg 为 false 时不回退）
+        img = ImageDecoderRegistry::instance().decode(path, mipBox, allowFfmpeg);
+    }
+
+    if (!img.isNull()) {
+        // 只缩小不放大：小图按原尺寸保留，绘制时再放进格子
+        const QSize fitted = img.size().scaled(mipBox, Qt::KeepAspectRatio);
+        if (fitted.width() < img.width())
+            img = scaleImage(img, fitted);
+        // 转成 QPixmap 的原生格式，GUI 线程上传时不用再逐像素转换
+        const QImage::Format native = img.hasAlphaChannel()
+                                          ? QImage::Format_ARGB32_Premultiplied
+                                          : QImage::Format_RGB32;
+        if (img.format() != native)
+            img = img.convertToFormat(native);
+        img.setDevicePixelRatio(dpr);
+    }
+    return img;
+}
+
+const QStringList &imageNameFilters()
+{
+    static const QStringList filters = {
+        "*.jpg", "*.jpeg", "*.png", "*.bmp", "*.gif", "*.webp", "*.tiff", "*.tif",
+        "*.heic", "*.heif", "*.hif",
+        "*.cr2", "*.nef", "*.nrw", "*.arw", "*.sr2", "*.dng",
+        "*.orf", "*.rw2", "*.pef", "*.raf",
+    };
+    return filters;
+}
+
+const QStringList &videoNameFilters()
+{
+    static const QStringList filters = {
+        "*.mp4", "*.mkv", "*.avi", "*.mov", "*.webm", "*.flv", "*.wmv", "*.m4v",
+    };
+    return filters;
+}
+
+// 目录预热的预算，可用环境变量调整：
+//   XSM_WARM_FOLDERS      每轮预热几个预测目录（0 关闭预热）
+//   XSM_WARM_MAX_ENTRIES  I/O 预算：目录里超过这么多媒体文件就不预热
+//   XSM_WARM_THUMBS       每个目录最多预生成多少张缩略图（约第一屏）
+//   XSM_WARM_CPU_MS       CPU 预算：每个目录生成缩略图最多用多少毫秒
+struct WarmBudget {
+    int folders;
+    int maxEntries;
+    int thumbs;
+    int cpuMs;
+};
+
+int envInt(const char *name, int fallback)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? qMax(0, value) : fallback;
+}
+
+const WarmBudget &warmBudget()
+{
+    static const WarmBudget budget = {
+        envInt("XSM_WARM_FOLDERS", 2),
+        envInt("XSM_WARM_MAX_ENTRIES", 5000),
+        envInt("XSM_WARM_THUMBS", 48),
+        envInt("XSM_WARM_CPU_MS", 400),
+    };
+    return budget;
+}
+
+} // namespace
 
 YouTubeStyleManager::YouTubeStyleManager(QWidget *parent) : QMainWindow(parent) {
     setWindowTitle("XSimple Media Manager");
     resize(1280, 800);
-    updatingFolderChecks = false;
 
     // 初始路径：视频目录，不存在则使用 home
     currentPath = QStandardPaths::writableLocation(QStandardPaths::MoviesLocation);
     if (currentPath.isEmpty()) currentPath = QDir::homePath();
 
-    // 异步缩略图 watcher
-    iconWatcher = new QFutureWatcher<QPair<int, QIcon>>(this);
-    connect(iconWatcher, &QFutureWatcher<QPair<int, QIcon>>::resultReadyAt,
-            this, &YouTubeStyleManager::onThumbnailLoaded);
+    // 异步缩略图 watcher：结果不走 future，工作线程直接放进无锁队列
+    iconWatcher = new QFutureWatcher<int>(this);
 
-    // 每批缩略图生成完成后，尝试启动下一批
-    connect(iconWatcher, &QFutureWatcher<QPair<int, QIcon>>::finished,
-            this, [this]() { tryStartNextThumbBatch(); });
+    // GUI 线程按帧预算分批应用结果，一帧里剩下的留到下一轮事件循环
+    thumbApplyTimer = new QTimer(this);
+    thumbApplyTimer->setSingleShot(true);
+    thumbApplyTimer->setInterval(0);
+    connect(thumbApplyTimer, &QTimer::timeout,
+            this, &YouTubeStyleManager::applyThumbnailResults);
 
     // === 限制全局线程池并发，防止一次性开太多 ffmpeg ===
     QThreadPool::globalInstance()->setMaxThreadCount(2);
-
-    connect(iconWatcher, &QFutureWatcher<QPair<int, QIcon>>::finished,
+    sortPool.setMaxThreadCount(1);
+    storePool.setMaxThreadCount(1);
+    m_dirCache.setMaxCost(DirCacheMaxKB);
+    m_thumbCache.setMaxCost(ThumbCacheMaxKB);
+    warmPool.setMaxThreadCount(1);
+    warmPool.setThreadPriority(QThread::LowPriority);
+    storyboardPool.setMaxThreadCount(1);
+
+    // 空闲一会儿后按导航历史预热下一个可能打开的目录
+    warmTimer = new QTimer(this);
+    warmTimer->setSingleShot(true);
+    connect(warmTimer, &QTimer::timeout, this, &YouTubeStyleManager::warmPredictedFolders);
+
+    connect(iconWatcher, &QFutureWatcher<int>::finished,
             this, [this]() {
-                auto future = iconWatcher->future();
-                const int n = future.resultCount();
-                for (int i = 0; i < n; ++i) {
-                    const QPair<int, QIcon> pair = future.resultAt(i);
-                    const int index = pair.first;
-                    const QIcon &icon = pair.second;
-
-                    if (!icon.isNull()) {
-                        QListWidgetItem *item = contentGrid->item(index);
-                        if (item)
-                            item->setIcon(icon);
-                    }
-
-                    thumbReady.insert(index);
-                }
-
+                // 结果（包括失败的）都由 applyThumbnailResults 逐个应用和标记，这里不再碰
                 // 这个批次结束后，再看视口附近是否有新的任务需要启动
                 tryStartNextThumbBatch();
+                if (!iconWatcher->isRunning()) {
+                    metaCrawler->setPaused(false);
+                    warmTimer->start(WarmIdleMs);   // 当前目录忙完了，空闲时再预热
+                }
             });
 
     mainStack = new QStackedWidget(this);
@@ -142,9 +282,52 @@ YouTubeStyleManager::YouTubeStyleManager(QWidget *parent) : QMainWindow(parent)
             this, &YouTubeStyleManager::goUpDirectory);
     topBarLayout->addWidget(backButton);
 
-    // 右侧搜索框
+    // 右侧排序 + 缩放滑块 + 搜索框
     topBarLayout->addStretch();
 
+    sortCombo = new QComboBox(this);
+    sortCombo->setObjectName("sortCombo");
+    sortCombo->addItem("名称", int(SortField::Name));
+    sortCombo->addItem("修改日期", int(SortField::Date));
+    sortCombo->addItem("大小", int(SortField::Size));
+    sortCombo->addItem("时长", int(SortField::Duration));
+    sortCombo->addItem("分辨率", int(SortField::Resolution));
+    sortCombo->setToolTip("排序方式");
+    connect(sortCombo, &QComboBox::currentIndexChanged, this, [this]() { requestSort(); });
+    topBarLayout->addWidget(sortCombo);
+
+    // 时长、分辨率由元数据爬虫陆续送来：合并一段时间内到达的结果再重排
+    metaSortTimer = new QTimer(this);
+    metaSortTimer->setSingleShot(true);
+    metaSortTimer->setInterval(500);
+    connect(metaSortTimer, &QTimer::timeout, this, [this]() { requestSort(); });
+
+    sortOrderButton = new QPushButton("↑", this);
+    sortOrderButton->setObjectName("sortOrderBtn");
+    sortOrderButton->setFixedSize(32, 32);
+    sortOrderButton->setCheckable(true);     // 按下为降序
+    sortOrderButton->setCursor(Qt::PointingHandCursor);
+    sortOrderButton->setToolTip("升序 / 降序");
+    connect(sortOrderButton, &QPushButton::toggled, this, [this](bool descending) {
+        sortOrderButton->setText(descending ? "↓" : "↑");
+        requestSort();
+    });
+    topBarLayout->addWidget(sortOrderButton);
+    topBarLayout->addSpacing(12);
+
+    zoomSlider = new QSlider(Qt::Horizontal, this);
+    zoomSlider->setObjectName("zoomSlider");
+    zoomSlider->setRange(60, 200);   // 百分比
+    zoomSlider->setSingleStep(10);
+    zoomSlider->setPageStep(20);
+    zoomSlider->setValue(100);
+    zoomSlider->setFixedWidth(120);
+    zoomSlider->setToolTip("缩略图大小（Ctrl + 滚轮）");
+    connect(zoomSlider, &QSlider::valueChanged,
+            this, &YouTubeStyleManager::setGridZoom);
+    topBarLayout->addWidget(zoomSlider);
+    topBarLayout->addSpacing(12);
+
     searchEdit = new QLineEdit(this);
     searchEdit->setPlaceholderText("搜索...");
     searchEdit->setFixedWidth(240);
@@ -172,6 +355,7 @@ YouTubeStyleManager::YouTubeStyleManager(QWidget *parent) : QMainWindow(parent)
 
     // 内容网格
     contentGrid = new QListWidget(this);
+    contentGrid->setObjectName("contentGrid");
     contentGrid->setViewMode(QListWidget::IconMode);
     contentGrid->setResizeMode(QListWidget::Adjust);
     contentGrid->setSpacing(12);
@@ -180,7 +364,8 @@ YouTubeStyleManager::YouTubeStyleManager(QWidget *parent) : QMainWindow(parent)
     contentGrid->setStyleSheet(
         "QListWidget { background-color: #0f0f0f; border: none; outline: none; }"
         "QListWidget::item { color: #f1f1f1; }");
-    contentGrid->setItemDelegate(new ThumbnailDelegate(this));
+    thumbDelegate = new ThumbnailDelegate(this);
+    contentGrid->setItemDelegate(thumbDelegate);
 
     // === 统一 item 尺寸，减少布局成本 ===
     contentGrid->setUniformItemSizes(true);
@@ -197,14 +382,20 @@ YouTubeStyleManager::YouTubeStyleManager(QWidget *parent) : QMainWindow(parent)
 
     // 视口变化时（滚动 / 尺寸改变）按需调度缩略图
     contentGrid->verticalScrollBar()->setSingleStep(24); // 可选：细腻滚动
+    scrollClock.start();
     connect(contentGrid->verticalScrollBar(), &QScrollBar::valueChanged,
-            this, [this](int) {
-                // 每次滚动都重置计时器，只有停下来才会触发 timeout
+            this, [this](int value) {
+                trackScrollVelocity(value);
+                // 每次滚动都重置计时器，停下来后按静止状态再调度一次
                 scrollDebounceTimer->start();
+                // 滚动过程中也节流地调度，快速甩动时缩略图不必等到停下才开始生成
+                if (scrollClock.elapsed() - lastScheduleMs >= ScrollScheduleIntervalMs)
+                    onContentViewportChanged();
             });
 
-    // 监听视口尺寸改变
+    // 监听视口尺寸改变；悬停拖动预览需要无按键时的鼠标移动事件
     contentGrid->viewport()->installEventFilter(this);
+    contentGrid->setMouseTracking(true);
 
     // 详情页
     detailPage = new VideoDetailWidget(this);
@@ -217,16 +408,7 @@ YouTubeStyleManager::YouTubeStyleManager(QWidget *parent) : QMainWindow(parent)
 
     // 信号连接
     auto onFilterChanged = [this](bool) {
-        // 过滤条件变了，清除当前路径的缓存，强制重新扫描
-        if (m_dirCache.contains(currentPath)) {
-            qDeleteAll(m_dirCache[currentPath].items);
-            m_dirCache.remove(currentPath);
-        }
-        // 也可以选择 clearAllCache() 清除所有，防止“返回上一级”时看到旧的过滤结果
-        // 建议：简单起见，清除所有缓存，保证数据一致性
-        clearAllCache();
-        m_lastLoadedPath.clear(); // 重置，确保 loadContent 不会尝试保存当前错误的列表
-
+        // 列表缓存里是全部媒体文件，过滤只是换一个视图，不用重新扫描；缩略图从缩略图缓存挂回
         loadContent();
     };
 
@@ -237,6 +419,15 @@ YouTubeStyleManager::YouTubeStyleManager(QWidget *parent) : QMainWindow(parent)
     connect(detailPage, &VideoDetailWidget::backRequested,
             this, &YouTubeStyleManager::showBrowser);
 
+    // 在视频格子上停留 300 ms：后台预取它的详情页封面和预览图
+    hoverPrefetchTimer = new QTimer(this);
+    hoverPrefetchTimer->setSingleShot(true);
+    hoverPrefetchTimer->setInterval(HoverPrefetchDelayMs);
+    connect(hoverPrefetchTimer, &QTimer::timeout, this, [this]() {
+        if (!hoveredVideoPath.isEmpty() && mainStack->currentWidget() == browserPage)
+            detailPage->prefetch(QStringList() << hoveredVideoPath);
+    });
+
     // 详情页标签变更信号
     connect(detailPage, &VideoDetailWidget::tagsChanged,
             this, &YouTubeStyleManager::updateVideoTags);
@@ -247,25 +438,44 @@ YouTubeStyleManager::YouTubeStyleManager(QWidget *parent) : QMainWindow(parent)
     folderAreaLayout->setContentsMargins(0, 0, 0, 0);
     folderAreaLayout->setSpacing(4);
 
-    // 子文件夹列表布局，后面由 rebuildFolderList() 填充
-    folderListLayout = new QVBoxLayout();
-    folderListLayout->setContentsMargins(10, 0, 5, 0);  // 左缩进，类似资源管理器
-    folderListLayout->setSpacing(2);
-
-    QWidget *folderListWidget = new QWidget(folderListContainer);
-    folderListWidget->setLayout(folderListLayout);
-    folderListWidget->setStyleSheet("background: transparent;"); // 确保背景透明
-
-    // 2. [关键] 创建 ScrollArea 包裹列表控件
-    QScrollArea *scrollArea = new QScrollArea(folderListContainer);
-    scrollArea->setWidget(folderListWidget);
-    scrollArea->setWidgetResizable(true); // 让内部控件随 ScrollArea 大小调整
-    scrollArea->setFrameShape(QFrame::NoFrame); // 去掉默认边框
-    scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff); // 禁用水平滚动
-    scrollArea->setStyleSheet("background: transparent;"); // 确保 ScrollArea 背景透明
+    // 子文件夹树：模型按需在后台枚举，视图只绘制可见行，几千个子目录也不会卡
+    folderModel = new FolderTreeModel(style()->standardIcon(QStyle::SP_DirIcon), this);
+    connect(folderModel, &FolderTreeModel::rootChildrenLoaded, this, [this](const QStringList &names) {
+        folderListNames = names;
+    });
+    folderStats = new FolderStatsAggregator(this);
+    connect(folderStats, &FolderStatsAggregator::statsChanged,
+            folderModel, &FolderTreeModel::refreshStats);
+
+    folderTree = new QTreeView(folderListContainer);
+    folderTree->setObjectName("folderTree");
+    folderTree->setModel(folderModel);
+    folderTree->setHeaderHidden(true);
+    folderTree->setUniformRowHeights(true);     // 行高一致，滚动时不用逐行测量
+    folderTree->setIndentation(14);
+    folderTree->setIconSize(QSize(24, 24));     // 图标是目录内容的拼图，太小看不出来
+    folderTree->setFrameShape(QFrame::NoFrame);
+    folderTree->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    folderTree->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    folderTree->setSelectionMode(QAbstractItemView::SingleSelection);
+    folderTree->setMouseTracking(true);         // entered 信号用来记录悬停
+    folderTree->setCursor(Qt::PointingHandCursor);
+    folderTree->header()->setStretchLastSection(false);
+    folderTree->header()->setSectionResizeMode(FolderTreeModel::NameColumn, QHeaderView::Stretch);
+    folderTree->header()->setSectionResizeMode(FolderTreeModel::CountColumn, QHeaderView::Fixed);
+    folderTree->header()->resizeSection(FolderTreeModel::CountColumn, 48);
+    connect(folderTree, &QTreeView::clicked,
+            this, &YouTubeStyleManager::handleFolderActivated);
+    connect(folderTree, &QTreeView::entered, this, [this](const QModelIndex &index) {
+        // 悬停在侧栏子目录上：很可能马上要点进去，记下来并尽快预热
+        const QString path = index.data(FolderTreeModel::PathRole).toString();
+        if (path.isEmpty())
+            return;
+        FolderHistory::instance().recordHover(QDir::cleanPath(currentPath), path);
+        warmTimer->start(WarmHoverDelayMs);
+    });
 
-    // 将 ScrollArea 加入布局，而不是直接加入 folderListWidget
-    folderAreaLayout->addWidget(scrollArea);
+    folderAreaLayout->addWidget(folderTree);
 
     // 底部“打开文件夹”按钮（仍然调用 openFolder，实现选择根目录）
     QPushButton *btnOpen = new QPushButton("打开文件夹", folderListContainer);
@@ -274,34 +484,69 @@ YouTubeStyleManager::YouTubeStyleManager(QWidget *parent) : QMainWindow(parent)
     folderAreaLayout->addWidget(btnOpen);
 
     // 添加到左侧面板布局时，参数 1 表示“尽可能占用剩余空间”
-    // 这样 ScrollArea 才有空间展开，否则会缩成一团
+    // 这样文件夹树才有空间展开，否则会缩成一团
     leftLayout->addWidget(folderListContainer, 1);
     connect(btnOpen, &QPushButton::clicked, this, &YouTubeStyleManager::openFolder);
 
     applyStyle();
 
+    // 后台元数据爬虫：最低优先级线程，先处理当前目录，再接着爬媒体库
+    metaCrawler = new MetadataCrawler(this);
+    connect(metaCrawler, &MetadataCrawler::metadataReady,
+            this, &YouTubeStyleManager::onMetadataReady);
+    metaCrawler->start(QThread::LowestPriority);
+
+    // 目录索引先在后台加载；文件夹树的合计从工作线程取，索引就绪前先显示本层数
+    QtConcurrent::run(&storePool, []() { LibraryIndex::instance(); });
+
     // 启动时加载已经保存的标签
     loadTags();
-    loadContent();
-    rebuildFolderList();   // 初次构建子文件夹列表
+    // 有上次会话的快照就直接画出来，和磁盘的比对放到后台；没有才同步枚举
+    if (!restoreSession()) {
+        loadContent();
+        rebuildFolderList();   // 初次构建子文件夹列表
+    }
     updateBackButtonState();   // 根据当前路径决定是否显示返回按钮
 
-    // 初始化目录监视器，监听当前路径
-    dirWatcher = new QFileSystemWatcher(this);
-    dirWatcher->addPath(currentPath);
-    connect(dirWatcher, &QFileSystemWatcher::directoryChanged,
-            this, &YouTubeStyleManager::onDirectoryChanged);
+    // 目录变化合并处理：第一次变化后等一会儿，期间的变化一起比对
+    dirChangeTimer = new QTimer(this);
+    dirChangeTimer->setSingleShot(true);
+    dirChangeTimer->setInterval(300);
+    connect(dirChangeTimer, &QTimer::timeout,
+            this, &YouTubeStyleManager::applyDirectoryDiff);
+
+    // 目录监视：整棵媒体库递归监视，当前目录不在库里时单独监视
+    dirWatcher = new DirectoryWatcher(this);
+    dirWatcher->setCurrentDirectory(currentPath);
+    connect(dirWatcher, &DirectoryWatcher::directoriesChanged,
+            this, &YouTubeStyleManager::onDirectoriesChanged);
+    connect(dirWatcher, &DirectoryWatcher::treeInvalidated,
+            this, &YouTubeStyleManager::onTreeInvalidated);
+    connect(dirWatcher, &DirectoryWatcher::pathRenamed,
+            this, &YouTubeStyleManager::onPathRenamed);
+
+    // 库根目录记在元数据库里，取它要加载整个库：放到后台线程，取到后再加监视
+    QtConcurrent::run(&storePool, [this]() {
+        const QStringList roots = MetadataStore::instance().libraryRoots();
+        QMetaObject::invokeMethod(this, [this, roots]() {
+                for (const QString &root : roots)
+                    dirWatcher->addTree(root);
+            }, Qt::QueuedConnection);
+    });
 }
 
 YouTubeStyleManager::~YouTubeStyleManager()
 {
+    // 条目和缩略图还在，先把当前目录存成快照，下次启动直接画出来
+    saveSession();
+
     // 清空等待队列，不再分发新任务
     thumbTaskQueue.clear();
 
     // 强制取消正在进行的异步任务，并等待后台线程安全归位
     if (iconWatcher) {
         if (iconWatcher->isRunning()) {
-            iconWatcher->cancel();
+            cancelThumbnailBatch();
             iconWatcher->waitForFinished();
         }
     }
@@ -310,8 +555,29 @@ YouTubeStyleManager::~YouTubeStyleManager()
     // 保险：窗口销毁时尝试清理所有仍在运行的 ffmpeg 子进程
     killAllFfmpegProcesses();
 
-    // 清理缓存中的 Item
-    clearAllCache();
+    // 预热和排序的结果都会投递回本对象，先等这两个线程结束
+    cancelFolderWarming();
+    warmPool.clear();
+    warmPool.waitForDone();
+    FolderHistory::instance().save();
+
+    sortPool.clear();
+    sortPool.waitForDone();
+    // 索引记录不要丢，等它写完；文件头读取、快照校验和库根目录会投递回本对象，先取消文件头
+    if (headerCancel)
+        headerCancel->store(true);
+    storePool.waitForDone();
+
+    // 故事板任务同样投递回本对象；ffmpeg 上面已经杀掉，这里很快就能等到
+    storyboardPool.clear();
+    storyboardPool.waitForDone();
+
+    // 停掉元数据爬虫（内部会把进度落盘）
+    if (metaCrawler) {
+        metaCrawler->stop();
+        metaCrawler->wait();
+    }
+
 }
 
 // 2. 实现槽函数
@@ -324,31 +590,19 @@ void YouTubeStyleManager::handleVideoRenamed(const QString &oldPath, const QStri
         saveTags(); // 立即持久化
     }
 
-    // B. 更新列表界面中的 Item 数据
-    // 遍历所有 Item，找到对应的那个 (使用 UserRole 存储的完整路径作为 ID)
-    for (int i = 0; i < contentGrid->count(); ++i) {
-        QListWidgetItem *item = contentGrid->item(i);
-        if (item->data(Qt::UserRole).toString() == oldPath) {
-            // 更新路径数据
-            item->setData(Qt::UserRole, newPath);
-            // 更新显示文本
-            item->setText(QFileInfo(newPath).fileName());
-            break;
-        }
+    // B. 更新列表界面中的 Item 数据（详情页改名和目录监视报告的改名都会走到这里）
+    if (QListWidgetItem *item = itemsByPath.take(oldPath)) {
+        // 更新路径数据
+        item->setData(Qt::UserRole, newPath);
+        itemsByPath.insert(newPath, item);
+        // 更新显示文本
+        item->setText(QFileInfo(newPath).fileName());
     }
 
     // C. 清除旧路径的缓存（如果存在），防止缩略图混乱
     // 这里简单处理：不做深度清理，因为缩略图是按内容哈希的，或者下次加载会重新生成
 }
 
-void YouTubeStyleManager::clearAllCache()
-{
-    for (auto &cache : m_dirCache) {
-        qDeleteAll(cache.items); // 销毁所有缓存的 Item
-    }
-    m_dirCache.clear();
-}
-
 void YouTubeStyleManager::applyStyle() {
     QString qss = R"(
         QToolTip {
@@ -406,28 +660,29 @@ void YouTubeStyleManager::applyStyle() {
     )";
 
     qss += R"(
-        QCheckBox#folderItem {
+        QTreeView#folderTree {
             background-color: transparent;
             color: #cccccc;
-            padding: 6px 10px;
-            border-radius: 6px;
             font-size: 13px;
-            spacing: 8px;
+            border: none;
+            outline: none;
+            margin-left: 10px;
+            margin-right: 5px;
         }
-        QCheckBox::indicator#folderItem {
-            width: 0px;
-            height: 0px;
+        QTreeView#folderTree::item {
+            padding: 6px 4px;
             border: none;
         }
-        QCheckBox#folderItem:hover {
+        QTreeView#folderTree::item:hover {
             background-color: #1f1f1f;
             color: white;
         }
-        QCheckBox#folderItem:checked {
+        QTreeView#folderTree::item:selected {
             background-color: #1f1f1f;
             color: white;
-            font-weight: 500;
-            border-left: 3px solid #3ea6ff;
+        }
+        QTreeView#folderTree::branch {
+            background-color: transparent;
         }
     )";
 
@@ -446,6 +701,42 @@ void YouTubeStyleManager::applyStyle() {
         QPushButton#backBtn:pressed {
             background-color: #1a1a1a;
         }
+        QSlider#zoomSlider::groove:horizontal {
+            height: 4px;
+            background: #333333;
+            border-radius: 2px;
+        }
+        QSlider#zoomSlider::handle:horizontal {
+            background: #aaaaaa;
+            width: 12px;
+            margin: -4px 0;
+            border-radius: 6px;
+        }
+        QSlider#zoomSlider::handle:horizontal:hover {
+            background: #3ea6ff;
+        }
+        QComboBox#sortCombo {
+            background-color: #202020;
+            border: 1px solid #3a3a3a;
+            border-radius: 16px;
+            padding: 5px 12px;
+            color: #ffffff;
+            font-size: 13px;
+        }
+        QComboBox#sortCombo:hover { border-color: #3ea6ff; }
+        QComboBox#sortCombo::drop-down { border: none; width: 16px; }
+        QComboBox#sortCombo QAbstractItemView {
+            background-color: #202020;
+            border: 1px solid #3a3a3a;
+            selection-background-color: #3ea6ff;
+        }
+        QPushButton#sortOrderBtn {
+            background-color: #202020;
+            border-radius: 16px;
+            border: 1px solid #3a3a3a;
+            color: #ffffff;
+        }
+        QPushButton#sortOrderBtn:hover { border-color: #3ea6ff; }
     )";
 
     qss += R"(
@@ -478,72 +769,27 @@ void YouTubeStyleManager::applyStyle() {
 
 void YouTubeStyleManager::rebuildFolderList()
 {
-    if (!folderListLayout || !folderListContainer)
+    if (!folderModel)
         return;
 
-    // 清空旧的复选框
-    while (QLayoutItem *item = folderListLayout->takeAt(0)) {
-        if (QWidget *w = item->widget())
-            w->deleteLater();
-        delete item;
-    }
-
-    QDir dir(currentPath);
-    // 按名称排序，仿资源管理器
-    QFileInfoList subdirs = dir.entryInfoList(
-        QDir::Dirs | QDir::NoDotAndDotDot,
-        QDir::Name | QDir::IgnoreCase
-        );
-
-    for (const QFileInfo &info : subdirs) {
-        QCheckBox *cb = new QCheckBox(info.fileName(), folderListContainer);
-        // === 设置鼠标悬停提示 ===
-        // 方案 A: 只显示完整的文件夹名字（推荐，适合名字被截断时查看）
-        cb->setToolTip(info.fileName());
-
-        // 方案 B: 如果您想显示完整的磁盘路径 (如 D:/Videos/Action)，请用下面这行代替上一行
-        // cb->setToolTip(info.absoluteFilePath());
-        cb->setObjectName("folderItem");
-        cb->setCursor(Qt::PointingHandCursor);
-        cb->setIcon(style()->standardIcon(QStyle::SP_DirIcon));
-        cb->setProperty("folderPath", info.absoluteFilePath());
-
-        connect(cb, &QCheckBox::toggled,
-                this, &YouTubeStyleManager::handleFolderCheckBoxToggled);
-
-        folderListLayout->addWidget(cb);
-    }
-
-    // 让列表从顶部开始排列
-    folderListLayout->addStretch();
+    // 子目录在模型的工作线程里枚举（顺手记进媒体库索引），到了再插入行
+    folderModel->setRootPath(currentPath);
+    folderStats->aggregate(currentPath);
 }
 
-void YouTubeStyleManager::handleFolderCheckBoxToggled(bool checked)
+void YouTubeStyleManager::showFolderList(const QStringList &names)
 {
-    if (!checked)
-        return; // 只对“勾选”事件做处理
-
-    if (updatingFolderChecks)
-        return;
-
-    QCheckBox *cb = qobject_cast<QCheckBox *>(sender());
-    if (!cb)
-        return;
+    // 会话快照里的子目录名直接作为根的子节点，不再枚举
+    folderModel->setRootPath(currentPath, names);
+    folderStats->aggregate(currentPath);
+}
 
-    QString folderPath = cb->property("folderPath").toString();
+void YouTubeStyleManager::handleFolderActivated(const QModelIndex &index)
+{
+    const QString folderPath = index.data(FolderTreeModel::PathRole).toString();
     if (folderPath.isEmpty())
         return;
 
-    // 只允许一个子文件夹选中：仿资源管理器单选效果
-    updatingFolderChecks = true;
-    for (int i = 0; i < folderListLayout->count(); ++i) {
-        QWidget *w = folderListLayout->itemAt(i)->widget();
-        QCheckBox *other = qobject_cast<QCheckBox *>(w);
-        if (other && other != cb)
-            other->setChecked(false);
-    }
-    updatingFolderChecks = false;
-
     // 切换当前路径并刷新内容
     currentPath = folderPath;
     pathLabel->setText(folderPath);
@@ -552,19 +798,8 @@ void YouTubeStyleManager::handleFolderCheckBoxToggled(bool checked)
     updateBackButtonState(); // 更新返回按钮
 
     // 更新目录监视器监听的路径
-    if (dirWatcher) {
-        dirWatcher->removePaths(dirWatcher->directories());
-        dirWatcher->addPath(currentPath);
-    }
-}
-
-void YouTubeStyleManager::onDirectoryChanged(const QString &path)
-{
-    Q_UNUSED(path);
-
-    // 如果正在浏览的路径被修改，刷新内容区和子目录列表
-    loadContent();
-    rebuildFolderList();
+    if (dirWatcher)
+        dirWatcher->setCurrentDirectory(currentPath);
 }
 
 void YouTubeStyleManager::updateBackButtonState()
@@ -592,226 +827,832 @@ void YouTubeStyleManager::goUpDirectory()
     updateBackButtonState();
 
     // 更新目录监视器监听的路径
-    if (dirWatcher) {
-        dirWatcher->removePaths(dirWatcher->directories());
-        dirWatcher->addPath(currentPath);
-    }
+    if (dirWatcher)
+        dirWatcher->setCurrentDirectory(currentPath);
 }
 
-void YouTubeStyleManager::onThumbnailLoaded(int resultIndex) {
-    if (resultIndex < 0)
-        return;
-
-    QPair<int, QIcon> result = iconWatcher->resultAt(resultIndex);
-    int row = result.first;
+void YouTubeStyleManager::applyThumbnailResults()
+{
+    // 一次最多占用 ThumbApplyBudgetUs：一整批结果同时到达时分几帧上传，滚动不卡顿
+    QElapsedTimer budget;
+    budget.start();
+    thumbPending.append(thumbResults.takeAll());
+
+    while (!thumbPending.isEmpty()) {
+        ThumbResult result = thumbPending.dequeue();
+        // 换目录、重新排序后取消的批次，行号已经失效
+        if (result.generation != thumbGeneration)
+            continue;
 
-    if (row >= 0 && row < contentGrid->count()) {
-        QListWidgetItem *item = contentGrid->item(row);
+        // 条目 setData 只会重绘它自己的格子，不刷新整个视口
+        applyThumbnail(result.row, std::move(result.image), result.mipLevel);
+        thumbReady.insert(result.row); // 失败也标记完成，避免同一档位反复重试
 
-        // 只有当结果有效时才更新，否则保持默认图标
-        if (item && !result.second.isNull()){
-            item->setIcon(result.second);
-            thumbReady.insert(row); // 标记该条目缩略图已生成
-        }
+        if (budget.nsecsElapsed() > ThumbApplyBudgetUs * 1000)
+            break;
     }
+
+    if (!thumbPending.isEmpty())
+        thumbApplyTimer->start();
 }
 
-void YouTubeStyleManager::loadContent()
+void YouTubeStyleManager::cancelThumbnailBatch()
 {
-    // 1. 停止当前的异步任务
+    // 正在跑的批次按旧行号产出结果：作废这一代，已经排队和之后到达的都丢掉
     if (iconWatcher->isRunning())
         iconWatcher->cancel();
+    ++thumbGeneration;
+    thumbPending.clear();
+    thumbResults.takeAll();
+}
+
+bool YouTubeStyleManager::applyThumbnail(int row, QImage img, int mipLevel)
+{
+    if (row < 0 || row >= contentGrid->count())
+        return false;
+
+    QListWidgetItem *item = contentGrid->item(row);
+    if (!item)
+        return false;
+
+    // 失败也记下档位，避免同一档位下反复重试
+    item->setData(MipLevelRole, mipLevel);
+    if (img.isNull())
+        return false;   // 结果无效时保持默认图标
+
+    // 工作线程已经缩放到目标档位并转好格式，GUI 线程只做一次上传；每个条目只保留这一档
+    const qreal dpr = img.devicePixelRatio();
+    QPixmap pix = QPixmap::fromImage(std::move(img));
+    pix.setDevicePixelRatio(dpr);
+    item->setData(Qt::DecorationRole, pix);
+    return true;
+}
+
+void YouTubeStyleManager::loadContent()
+{
+    // 1. 停止当前的异步任务（预热也让路，当前目录加载完再按新位置预测）
+    cancelThumbnailBatch();
+    cancelFolderWarming();
+    warmTimer->start(WarmIdleMs);
+
+    const bool leaving = !m_lastLoadedPath.isEmpty() && m_lastLoadedPath != currentPath;
+    if (leaving)
+        FolderHistory::instance().recordVisit(QDir::cleanPath(m_lastLoadedPath), QDir::cleanPath(currentPath));
 
     thumbTaskQueue.clear();
     thumbRequested.clear(); // 新页面重新调度
+    itemsByPath.clear();    // 条目即将被销毁，加载完再重建
 
     // ---------------------------------------------------------
-    // A. [保存现场] 离开当前文件夹前，把 Item 存入缓存
+    // A. [保存现场] 离开当前文件夹：记下滚动位置，已生成的缩略图留进缩略图缓存，条目销毁
     // ---------------------------------------------------------
-    // 只有当路径发生变化，且旧路径有效时才缓存
-    if (!m_lastLoadedPath.isEmpty() && m_lastLoadedPath != currentPath) {
-        DirCache cache;
-        cache.scrollPosition = contentGrid->verticalScrollBar()->value();
-        cache.thumbReady = thumbReady; // 保存已加载状态
-
-        // 关键：使用 takeItem 将 Item 从列表中“剥离”出来，而不是删除
-        // 这样 Item 里的 Icon 和数据都完好无损
-        const int count = contentGrid->count();
-        for (int i = 0; i < count; ++i) {
-            cache.items.append(contentGrid->takeItem(0));
-        }
-
-        m_dirCache.insert(m_lastLoadedPath, cache);
+    if (leaving) {
+        if (DirListing *previous = m_dirCache.object(QDir::cleanPath(m_lastLoadedPath)))
+            previous->scrollPosition = contentGrid->verticalScrollBar()->value();
     }
-    // 如果是路径没变（比如刷新），或者是过滤器变化导致的重载，则应该销毁旧 Item
-    else {
-        contentGrid->clear();
-        // 并在这种情况下，通常意味着当前路径的缓存也失效了（比如切换了图片/视频过滤）
-        if (m_dirCache.contains(currentPath)) {
-            qDeleteAll(m_dirCache[currentPath].items);
-            m_dirCache.remove(currentPath);
-        }
-    }
-
+    stashThumbnails();
     contentGrid->setUpdatesEnabled(false);
+    contentGrid->clear();
+    thumbReady.clear(); // 清空已就绪标记
 
     // ---------------------------------------------------------
-    // B. [尝试恢复] 检查新路径是否有缓存
+    // B. [列表] 缓存里有且目录 mtime 没变就直接用（一次 stat），否则重新枚举
     // ---------------------------------------------------------
-    if (m_dirCache.contains(currentPath)) {
-        DirCache &cache = m_dirCache[currentPath];
-
-        // 恢复所有 Item
-        for (QListWidgetItem *item : cache.items) {
-            contentGrid->addItem(item);
-        }
-
-        // 恢复状态
-        thumbReady = cache.thumbReady;
-
-        // 恢复滚动条位置 (需要一点延迟等待布局完成)
-        QTimer::singleShot(0, this, [this, pos = cache.scrollPosition]() {
-            contentGrid->verticalScrollBar()->setValue(pos);
-            onContentViewportChanged(); // 触发一次检查，万一视口变了
+    const QString dirKey = QDir::cleanPath(currentPath);
+    const qint64 dirMtime = QFileInfo(currentPath).lastModified().toMSecsSinceEpoch();
+    DirListing listing;
+    int scrollPosition = -1;
+    const DirListing *cached = m_dirCache.object(dirKey);
+    if (cached && cached->dirMtime == dirMtime) {
+        listing = *cached;      // 记录是隐式共享的，不复制
+        if (leaving)
+            scrollPosition = cached->scrollPosition;
+    } else {
+        readDirListing(currentPath, &listing);
+
+        // 这次枚举就是该目录完整的媒体文件列表，顺手记进目录索引
+        QStringList fileNames;
+        fileNames.reserve(listing.files.size());
+        for (const FileRecord &record : std::as_const(listing.files))
+            fileNames << record.name;
+        const qint64 listingMtime = listing.dirMtime;
+        QtConcurrent::run(&storePool, [dirKey, listingMtime, fileNames]() {
+            LibraryIndex::instance().recordFiles(dirKey, listingMtime, fileNames);
         });
 
-        // 更新追踪变量
-        m_lastLoadedPath = currentPath;
-        contentGrid->setUpdatesEnabled(true);
-        return; // <--- 直接返回，不再执行耗时的文件扫描
+        m_dirCache.insert(dirKey, new DirListing(listing), listingCost(listing));
     }
 
     // ---------------------------------------------------------
-    // C. [全量加载] 如果没有缓存，走常规流程
+    // C. [视图] 按图片/视频勾选筛出要显示的记录
     // ---------------------------------------------------------
-    thumbReady.clear(); // 清空已就绪标记
+    const bool showImages = checkImages->isChecked();
+    const bool showVideos = checkVideos->isChecked();
+    const QDir dir(currentPath);
+    QStringList unprobed;
+    for (const FileRecord &record : std::as_const(listing.files)) {
+        if (record.isVideo ? !showVideos : !showImages)
+            continue;
+        contentGrid->addItem(createMediaItem(dir.absoluteFilePath(record.name),
+                                             record.size, record.mtime, &unprobed));
+    }
 
-    QDir dir(currentPath);
+    // 缓存里有的缩略图直接挂上；档位不对的先顶着，调度时按当前档位重新生成
+    for (int i = 0; i < contentGrid->count(); ++i) {
+        QListWidgetItem *item = contentGrid->item(i);
+        const CachedThumb *thumb = m_thumbCache.object(item->data(Qt::UserRole).toString());
+        if (!thumb || thumb->mtime != item->data(MTimeRole).toLongLong())
+            continue;
+        item->setData(Qt::DecorationRole, thumb->pixmap);
+        item->setData(MipLevelRole, thumb->mipLevel);
+        thumbReady.insert(i);
+    }
+
+    probeMetadata(unprobed, true);
+
+    m_lastLoadedPath = currentPath; // 更新追踪变量
+    rebuildItemIndex();
+    contentGrid->setUpdatesEnabled(true);
+    // 自然排序和其他排序方式在排序线程里做；第一批缩略图等排序结果回来再按最终行号调度，
+    // 否则名字里带数字（ep2/ep10）时刚开始的批次会被重排取消
+    awaitingFirstSort = contentGrid->count() > 0;
+    requestSort();
+
+    // 回到离开过的目录：恢复滚动条位置（等布局完成）
+    QTimer::singleShot(0, this, [this, scrollPosition]() {
+        if (scrollPosition >= 0)
+            contentGrid->verticalScrollBar()->setValue(scrollPosition);
+        onContentViewportChanged();
+    });
+}
+
+QStringList YouTubeStyleManager::mediaNameFilters() const
+{
     QStringList filters;
     if (checkImages->isChecked())
-        filters << "*.jpg" << "*.jpeg" << "*.png" << "*.bmp" << "*.gif" << "*.webp" << "*.tiff" << "*.tif";
+        filters << imageNameFilters();
     if (checkVideos->isChecked())
-        filters << "*.mp4" << "*.mkv" << "*.avi" << "*.mov" << "*.webm" << "*.flv" << "*.wmv" << "*.m4v";
+        filters << videoNameFilters();
+    return filters;
+}
 
-    dir.setNameFilters(filters);
-    QFileInfoList list = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot,
-                                           QDir::Name | QDir::IgnoreCase);
+bool YouTubeStyleManager::readDirListing(const QString &dir, DirListing *listing, int maxEntries,
+                                         const std::atomic_bool *cancel)
+{
+    // 目录 mtime 要在枚举之前取：枚举期间发生的变化会让记录的 mtime 过期，下次重扫
+    listing->dirMtime = QFileInfo(dir).lastModified().toMSecsSinceEpoch();
+    listing->files.clear();
+
+    // 不看勾选，图片和视频都记下；过滤在显示时做
+    QDirIterator it(dir, imageNameFilters() + videoNameFilters(), QDir::Files | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        if (cancel && cancel->load())
+            return false;
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        FileRecord record;
+        record.name = info.fileName();
+        record.size = info.size();
+        record.mtime = info.lastModified().toMSecsSinceEpoch();
+        record.isVideo = isVideoSuffix(info.suffix().toLower());
+        listing->files.append(record);
+        if (maxEntries >= 0 && listing->files.size() > maxEntries)
+            return false;
+    }
 
-    for (const QFileInfo &info : list) {
-        QListWidgetItem *item = new QListWidgetItem(info.fileName());
-        const QString filePath = info.absoluteFilePath();
-        const QString suffix   = info.suffix().toLower();
-        const bool isVideo     = (suffix == "mp4" || suffix == "mkv"
-                              || suffix == "avi" || suffix == "mov"
-                              || suffix == "webm" || suffix == "flv"
-                              || suffix == "wmv" || suffix == "m4v");
+    // 和 QDir::Name | QDir::IgnoreCase 一致，其他排序方式在排序线程里做
+    std::sort(listing->files.begin(), listing->files.end(), [](const FileRecord &a, const FileRecord &b) {
+        return a.name.compare(b.name, Qt::CaseInsensitive) < 0;
+    });
+    return true;
+}
 
-        item->setData(Qt::UserRole,     filePath);
-        item->setData(Qt::UserRole + 1, isVideo);
-        item->setData(Qt::UserRole + 10, videoTags.value(filePath));
+int YouTubeStyleManager::listingCost(const DirListing &listing)
+{
+    qint64 bytes = sizeof(DirListing);
+    for (const FileRecord &record : listing.files)
+        bytes += sizeof(FileRecord) + record.name.size() * sizeof(QChar) + 32; // 32：QString 头部
+    return int(bytes / 1024) + 1;
+}
+
+void YouTubeStyleManager::stashThumbnails()
+{
+    for (int i = 0; i < contentGrid->count(); ++i) {
+        QListWidgetItem *item = contentGrid->item(i);
+        const QVariant decoration = item->data(Qt::DecorationRole);
+        if (decoration.userType() != QMetaType::QPixmap)
+            continue;   // 还是默认图标
+
+        auto *thumb = new CachedThumb;
+        thumb->pixmap = decoration.value<QPixmap>();
+        thumb->mipLevel = item->data(MipLevelRole).toInt();
+        thumb->mtime = item->data(MTimeRole).toLongLong();
+        const qint64 bytes = qint64(thumb->pixmap.width()) * thumb->pixmap.height() * 4;
+        m_thumbCache.insert(item->data(Qt::UserRole).toString(), thumb, int(bytes / 1024) + 1);
+    }
+}
+
+QListWidgetItem *YouTubeStyleManager::createMediaItem(const QString &filePath, qint64 size, qint64 mtime,
+                                                      QStringList *unprobed)
+{
+    const QFileInfo info(filePath);     // 只取文件名和后缀，不 stat
+    QListWidgetItem *item = new SortableListItem(info.fileName());
+    const bool isVideo     = isVideoSuffix(info.suffix().toLower());
+
+    item->setData(Qt::UserRole,     filePath);
+    item->setData(Qt::UserRole + 1, isVideo);
+    item->setData(Qt::UserRole + 10, videoTags.value(filePath));
+
+    item->setIcon(isVideo
+                      ? style()->standardIcon(QStyle::SP_MediaPlay)
+                      : style()->standardIcon(QStyle::SP_FileIcon));
+
+    updateItemFileInfo(item, size, mtime, unprobed);
+    return item;
+}
 
+void YouTubeStyleManager::updateItemFileInfo(QListWidgetItem *item, qint64 size, qint64 mtime,
+                                             QStringList *unprobed)
+{
+    const QString filePath = item->data(Qt::UserRole).toString();
+    item->setData(Qt::UserRole + 2, size);
+    item->setData(MTimeRole,        mtime);
+
+    // 元数据库里已有且未过期的直接显示角标；其余交给 probeMetadata（图片在后台读文件头）
+    MediaMeta meta;
+    if (MetadataStore::instance().lookup(filePath, &meta) && meta.mtime == mtime && meta.size == size) {
+        applyMetadata(item, meta);
+        return;
+    }
+
+    applyMetadata(item, MediaMeta()); // 旧的角标作废
+    *unprobed << filePath;
+}
+
+void YouTubeStyleManager::probeMetadata(const QStringList &paths, bool replace)
+{
+    // 图片只读文件头（每个几百字节）：在工作线程里整批读完，不等爬虫排队也不受它暂停影响，
+    // 结果和爬虫一样经 onMetadataReady 回来；读不出头的（HEIF/RAW）和视频交给爬虫
+    QStringList images, others;
+    for (const QString &path : paths)
+        (isVideoSuffix(QFileInfo(path).suffix().toLower()) ? others : images) << path;
+
+    if (replace || !headerCancel) {
+        if (headerCancel)
+            headerCancel->store(true);
+        headerCancel = std::make_shared<std::atomic_bool>(false);
+    }
+    if (replace || !others.isEmpty())
+        metaCrawler->prioritize(others, replace);
+    if (images.isEmpty())
+        return;
+
+    const auto token = headerCancel;
+    QtConcurrent::run(&storePool, [this, images, token]() {
+        MetadataStore &store = MetadataStore::instance();
+        QStringList unreadable;
+        QVector<QPair<QString, MediaMeta>> batch;
+        auto flush = [this, &batch]() {
+            if (batch.isEmpty())
+                return;
+            QMetaObject::invokeMethod(this, [this, batch]() {
+                    for (const auto &entry : batch)
+                        onMetadataReady(entry.first, entry.second);
+                }, Qt::QueuedConnection);
+            batch.clear();
+        };
+
+        for (const QString &path : images) {
+            if (token->load())
+                return;
+            const ImageHeaderInfo header = readImageHeader(path);
+            if (!header.valid) {
+                unreadable << path;
+                continue;
+            }
+            const QFileInfo info(path);
+            MediaMeta meta;
+            meta.mtime = info.lastModified().toMSecsSinceEpoch();
+            meta.size = info.size();
+            meta.resolution = header.displaySize();
+            store.insert(path, meta);
+            batch.append({ path, meta });
+            if (batch.size() >= HeaderBatchSize)
+                flush();    // 按块送回，GUI 线程每次只更新一小批角标
+        }
+        flush();
+        if (!unreadable.isEmpty() && !token->load())
+            metaCrawler->prioritize(unreadable, false);
+    });
+}
+
+void YouTubeStyleManager::onDirectoriesChanged(const QStringList &dirs)
+{
+    const QString current = QDir::cleanPath(currentPath);
+    for (const QString &dir : dirs) {
+        // 正在浏览的目录：做增量比对；复制大量文件时会连续触发，攒一批再处理
+        if (dir == current) {
+            if (!dirChangeTimer->isActive())
+                dirChangeTimer->start();
+            continue;
+        }
+        // 离开时缓存的目录已经过期，下次进入重新扫描
+        dropDirCache(dir, false);
+        // 左侧树里展开过的子目录：增删变化的行
+        folderModel->refreshChildren(dir);
+    }
+
+    // 元数据索引：只重扫这些目录本身的文件；文件夹统计同样只重算本层，合计由索引向上汇总
+    metaCrawler->rescan(dirs, false);
+    folderStats->rescan(dirs, false);
+}
+
+void YouTubeStyleManager::onTreeInvalidated(const QString &root)
+{
+    // 事件丢失：这棵树下缓存的列表都不可信了
+    dropDirCache(root, true);
+    const QString current = QDir::cleanPath(currentPath);
+    if (current == root || current.startsWith(root + '/')) {
+        if (!dirChangeTimer->isActive())
+            dirChangeTimer->start();
+    }
+    metaCrawler->rescan(QStringList() << root, true);
+    folderStats->rescan(QStringList() << root, true);
+}
+
+void YouTubeStyleManager::onPathRenamed(const QString &oldPath, const QString &newPath)
+{
+    const QString current = QDir::cleanPath(currentPath);
+    if (current == oldPath || current.startsWith(oldPath + '/')) {
+        // 正在浏览的目录（或它的上级）被改名：跟着走，条目路径全部失效，重新加载
+        dropDirCache(oldPath, true);
+        currentPath = newPath + current.mid(oldPath.size());
+        pathLabel->setText(currentPath);
+        m_lastLoadedPath.clear();
+        loadContent();
+        rebuildFolderList();
+        dirWatcher->setCurrentDirectory(currentPath);
+        return;
+    }
+
+    if (QFileInfo(newPath).isDir()) {
+        dropDirCache(oldPath, true);
+        return;
+    }
+
+    // 文件改名：条目、标签、元数据和缩略图缓存都跟过去，不必重新生成
+    MetadataStore::instance().rename(oldPath, newPath);
+    moveThumbnailCache(oldPath, newPath, isVideoSuffix(QFileInfo(newPath).suffix().toLower()));
+    handleVideoRenamed(oldPath, newPath);
+}
+
+void YouTubeStyleManager::dropDirCache(const QString &dir, bool recursive)
+{
+    const QList<QString> keys = m_dirCache.keys();
+    for (const QString &key : keys) {
+        if (key == dir || (recursive && key.startsWith(dir + '/')))
+            m_dirCache.remove(key);
+    }
+}
+
+void YouTubeStyleManager::cancelFolderWarming()
+{
+    // 还没开始的目录直接跳过，正在跑的在下一个文件前退出
+    if (warmCancel)
+        warmCancel->store(true);
+    warmCancel.reset();
+    ++warmGeneration;
+}
+
+void YouTubeStyleManager::warmPredictedFolders()
+{
+    const WarmBudget &budget = warmBudget();
+    if (budget.folders <= 0 || currentPath.isEmpty())
+        return;
+
+    // 当前目录的缩略图还在生成：等它做完（iconWatcher 结束时会重新计时）
+    if (iconWatcher->isRunning() || !thumbTaskQueue.isEmpty())
+        return;
+
+    // 候选：侧栏的子目录和上一级；历史里从这里去过的目录由模型自己补上
+    const QString from = QDir::cleanPath(currentPath);
+    const QDir dir(currentPath);
+    QStringList candidates;
+    for (const QString &name : std::as_const(folderListNames))
+        candidates << QDir::cleanPath(dir.absoluteFilePath(name));
+    QDir parent(currentPath);
+    if (parent.cdUp())
+        candidates << QDir::cleanPath(parent.absolutePath());
+
+    const bool showImages = checkImages->isChecked();
+    const bool showVideos = checkVideos->isChecked();
+    const int mipLevel = currentMipLevel();
+    QStringList targets;
+    for (const QString &path : FolderHistory::instance().predict(from, candidates, budget.folders * 3)) {
+        if (targets.size() >= budget.folders)
+            break;
+        if (!QFileInfo(path).isDir())
+            continue;
+        // 列表已经在缓存里且目录没变（离开过或上一轮预热过）：不用再预热
+        const DirListing *cached = m_dirCache.object(path);
+        if (cached && cached->dirMtime == QFileInfo(path).lastModified().toMSecsSinceEpoch())
+            continue;
+        targets << path;
+    }
+    if (targets.isEmpty())
+        return;
+
+    cancelFolderWarming();
+    warmCancel = std::make_shared<std::atomic_bool>(false);
+    const auto token = warmCancel;
+    const int generation = warmGeneration;
+    const qreal dpr = contentGrid->devicePixelRatioF();
+    const QSize mipBox(mipLevel, mipLevel);
+
+    for (const QString &path : std::as_const(targets)) {
+        QtConcurrent::run(&warmPool, [this, path, showImages, showVideos, mipLevel, mipBox, dpr,
+                                      token, generation]() {
+            const WarmBudget &budget = warmBudget();
+            if (token->load())
+                return;
+
+            // 逐个枚举，超出 I/O 预算就放弃这个目录（不完整的列表不能用）
+            DirListing listing;
+            if (!readDirListing(path, &listing, budget.maxEntries, token.get()))
+                return;
+
+            // 第一屏缩略图（按当前勾选的视图），受 CPU 预算限制；视频只用已有的封面或截帧缓存，
+            // 不为预热启动 ffmpeg
+            const QDir dir(path);
+            QHash<QString, QImage> thumbs;
+            QElapsedTimer cpu;
+            cpu.start();
+            for (const FileRecord &record : std::as_const(listing.files)) {
+                if (thumbs.size() >= budget.thumbs || token->load() || cpu.elapsed() >= budget.cpuMs)
+                    break;
+                if (record.isVideo ? !showVideos : !showImages)
+                    continue;
+                const QString filePath = dir.absoluteFilePath(record.name);
+                const QImage img = loadGridThumbnail(filePath, record.isVideo, mipBox, dpr, false);
+                if (!img.isNull())
+                    thumbs.insert(filePath, img);
+            }
+
+            QMetaObject::invokeMethod(this, [this, path, listing, thumbs, mipLevel, generation]() {
+                // 期间又导航或开始生成缩略图了：这一轮的结果不要
+                if (generation != warmGeneration || QDir::cleanPath(currentPath) == path)
+                    return;
+
+                m_dirCache.insert(path, new DirListing(listing), listingCost(listing));
+                const QDir dir(path);
+                for (const FileRecord &record : listing.files) {
+                    const QString filePath = dir.absoluteFilePath(record.name);
+                    const auto it = thumbs.constFind(filePath);
+                    if (it == thumbs.cend())
+                        continue;
+                    auto *thumb = new CachedThumb;
+                    thumb->pixmap = QPixmap::fromImage(*it);
+                    thumb->pixmap.setDevicePixelRatio(it->devicePixelRatio());
+                    thumb->mipLevel = mipLevel;
+                    thumb->mtime = record.mtime;
+                    const qint64 bytes = qint64(it->width()) * it->height() * 4;
+                    m_thumbCache.insert(filePath, thumb, int(bytes / 1024) + 1);
+                }
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void YouTubeStyleManager::applyDirectoryDiff()
+{
+    // 目录本身被删除或改名：没有可比对的了，走全量流程
+    if (!QFileInfo(currentPath).isDir()) {
+        loadContent();
+        rebuildFolderList();
+        return;
+    }
+
+    QDir dir(currentPath);
+    const QFileInfoList subdirs = dir.entryInfoList(
+        QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name | QDir::IgnoreCase);
+    dir.setNameFilters(mediaNameFilters());
+    applyDirectoryListing(subdirs, dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot));
+}
+
+void YouTubeStyleManager::applyDirectoryListing(const QFileInfoList &subdirs, const QFileInfoList &list)
+{
+    // 子目录有增减：树已经是这个目录时只增删变化的行，保留展开状态
+    QStringList subdirNames;
+    for (const QFileInfo &info : subdirs)
+        subdirNames << info.fileName();
+    if (subdirNames != folderListNames) {
+        if (folderModel->rootPath() == QDir::cleanPath(currentPath) && folderModel->isRootFetched())
+            folderModel->refreshChildren(currentPath);
+        else
+            rebuildFolderList();
+    }
+
+    QHash<QString, QFileInfo> onDisk;
+    onDisk.reserve(list.size());
+    for (const QFileInfo &info : list)
+        onDisk.insert(info.absoluteFilePath(), info);
+
+    // 和当前列表比对：删除、修改（大小或修改时间变了）、新增
+    QList<QListWidgetItem *> removed;
+    QStringList unprobed;
+    int modified = 0;
+    for (auto it = itemsByPath.cbegin(); it != itemsByPath.cend(); ++it) {
+        auto disk = onDisk.constFind(it.key());
+        if (disk == onDisk.cend()) {
+            removed << it.value();
+            continue;
+        }
+
+        QListWidgetItem *item = it.value();
+        if (item->data(Qt::UserRole + 2).toLongLong() == disk->size()
+            && item->data(MTimeRole).toLongLong() == disk->lastModified().toMSecsSinceEpoch())
+            continue;
+
+        // 内容变了：缩略图和故事板缓存都按路径命名，先删掉再重新生成
+        const bool isVideo = item->data(Qt::UserRole + 1).toBool();
+        removeThumbnailCache(it.key(), isVideo);
+        thumbDelegate->removeStoryboard(it.key());
+        item->setData(MipLevelRole, QVariant());
         item->setIcon(isVideo
                           ? style()->standardIcon(QStyle::SP_MediaPlay)
                           : style()->standardIcon(QStyle::SP_FileIcon));
+        updateItemFileInfo(item, disk->size(), disk->lastModified().toMSecsSinceEpoch(), &unprobed);
+        ++modified;
+    }
+
+    QList<QListWidgetItem *> added;
+    for (auto it = onDisk.cbegin(); it != onDisk.cend(); ++it) {
+        if (!itemsByPath.contains(it.key()))
+            added << createMediaItem(it.key(), it->size(), it->lastModified().toMSecsSinceEpoch(), &unprobed);
+    }
+
+    if (removed.isEmpty() && added.isEmpty() && modified == 0)
+        return;
+
+    // 缓存的列表已经过期（原地改写文件不会改变目录 mtime，这里一并作废），下次进入重新枚举
+    m_dirCache.remove(QDir::cleanPath(currentPath));
+
+    // 只改动涉及的行，其余条目的缩略图和滚动位置都保留
+    const int scrollPos = contentGrid->verticalScrollBar()->value();
+    contentGrid->setUpdatesEnabled(false);
+    for (QListWidgetItem *item : std::as_const(removed)) {
+        if (item->data(Qt::UserRole).toString() == hoveredVideoPath)
+            hoveredVideoPath.clear();
+        delete item;    // 析构时自动从列表移除
+    }
+    for (QListWidgetItem *item : std::as_const(added))
+        contentGrid->addItem(item);
+    rebuildItemIndex();
+    contentGrid->setUpdatesEnabled(true);
+    contentGrid->verticalScrollBar()->setValue(scrollPos);
+
+    if (!unprobed.isEmpty())
+        probeMetadata(unprobed, false);
+
+    // 新条目也要服从当前的搜索词；新增或修改过的按当前排序方式归位
+    if (!added.isEmpty())
+        filterContent(searchEdit->text());
+    resetThumbnailRows();
+    if (!added.isEmpty() || modified > 0)
+        requestSort();
+}
+
+void YouTubeStyleManager::resetThumbnailRows()
+{
+    // 行号变了：正在跑的批次按旧行号回填，先取消，再按新行号调度
+    cancelThumbnailBatch();
+    thumbTaskQueue.clear();
+    thumbRequested.clear();
+
+    // 条目上记着档位的就是处理过的，按新行号重建
+    thumbReady.clear();
+    for (int i = 0; i < contentGrid->count(); ++i) {
+        if (contentGrid->item(i)->data(MipLevelRole).isValid())
+            thumbReady.insert(i);
+    }
 
+    onContentViewportChanged();
+}
+
+bool YouTubeStyleManager::restoreSession()
+{
+    SessionSnapshot snapshot;
+    if (!loadSessionSnapshot(&snapshot) || !QFileInfo(snapshot.path).isDir())
+        return false;
+
+    // 过滤、排序和缩放先恢复，不触发重新加载；快照里的顺序就是按它们排好的
+    {
+        const QSignalBlocker blockImages(checkImages), blockVideos(checkVideos);
+        const QSignalBlocker blockSort(sortCombo), blockOrder(sortOrderButton);
+        checkImages->setChecked(snapshot.showImages);
+        checkVideos->setChecked(snapshot.showVideos);
+        const int sortIndex = sortCombo->findData(snapshot.sortField);
+        if (sortIndex >= 0)
+            sortCombo->setCurrentIndex(sortIndex);
+        sortOrderButton->setChecked(snapshot.descending);
+        sortOrderButton->setText(snapshot.descending ? "↓" : "↑");
+    }
+    zoomSlider->setValue(snapshot.zoom);
+
+    currentPath = snapshot.path;
+    pathLabel->setText(currentPath);
+    showFolderList(snapshot.subdirs);
+
+    // 条目直接用快照里的大小、修改时间和角标，不枚举也不 stat；缩略图只解码快照里那一屏
+    const QDir dir(currentPath);
+    const QIcon videoIcon = style()->standardIcon(QStyle::SP_MediaPlay);
+    const QIcon imageIcon = style()->standardIcon(QStyle::SP_FileIcon);
+    QStringList unprobed;
+    thumbReady.clear();
+    contentGrid->setUpdatesEnabled(false);
+    for (const SessionItem &entry : std::as_const(snapshot.items)) {
+        const QString filePath = dir.absoluteFilePath(entry.name);
+        QListWidgetItem *item = new SortableListItem(entry.name);
+        item->setData(Qt::UserRole,     filePath);
+        item->setData(Qt::UserRole + 1, entry.isVideo);
+        item->setData(Qt::UserRole + 2, entry.size);
+        item->setData(MTimeRole,        entry.mtime);
+        item->setData(Qt::UserRole + 10, videoTags.value(filePath));
+
+        MediaMeta meta;
+        meta.duration = entry.duration;
+        meta.resolution = entry.resolution;
+        meta.codec = entry.codec;
+        applyMetadata(item, meta);
+        if (entry.isVideo ? entry.duration <= 0 : entry.resolution.isEmpty())
+            unprobed << filePath;
+
+        item->setIcon(entry.isVideo ? videoIcon : imageIcon);
         contentGrid->addItem(item);
+
+        if (entry.mipLevel > 0) {
+            QImage img;
+            if (img.loadFromData(entry.thumbnail, "JPG")) {
+                img.setDevicePixelRatio(snapshot.thumbnailDpr);
+                if (applyThumbnail(contentGrid->count() - 1, std::move(img), entry.mipLevel))
+                    thumbReady.insert(contentGrid->count() - 1);
+            }
+        }
     }
 
-    m_lastLoadedPath = currentPath; // 更新追踪变量
+    m_lastLoadedPath = currentPath;
+    rebuildItemIndex();
     contentGrid->setUpdatesEnabled(true);
+    if (!unprobed.isEmpty())
+        probeMetadata(unprobed, true);
 
-    QTimer::singleShot(0, this, [this]() { onContentViewportChanged(); });
+    // 布局要等窗口第一次显示时才有视口尺寸，滚动位置到那时再设
+    pendingScrollPosition = snapshot.scrollPosition;
+    revalidateSession();
+    return true;
 }
 
-void YouTubeStyleManager::startThumbnailGeneration()
+void YouTubeStyleManager::revalidateSession()
 {
-    if (pendingThumbTasks.isEmpty())
+    // 快照可能已经过期：在后台重新枚举（连同 stat），结果回到 GUI 线程走增量比对
+    const QString dirPath = currentPath;
+    const QStringList filters = mediaNameFilters();
+    QtConcurrent::run(&storePool, [this, dirPath, filters]() {
+        QDir dir(dirPath);
+        const QFileInfoList subdirs = dir.entryInfoList(
+            QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name | QDir::IgnoreCase);
+        dir.setNameFilters(filters);
+        const QFileInfoList files = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+        for (const QFileInfo &info : files)
+            info.lastModified();    // 让 stat 发生在这个线程，GUI 线程只读缓存
+        const bool exists = QFileInfo(dirPath).isDir();
+
+        QMetaObject::invokeMethod(this, [this, dirPath, filters, subdirs, files, exists]() {
+                // 期间换了目录或过滤条件：当前列表已经是新枚举的，不需要了
+                if (currentPath != dirPath || m_lastLoadedPath != dirPath
+                    || filters != mediaNameFilters())
+                    return;
+                if (!exists) {
+                    applyDirectoryDiff();   // 目录没了，走它的全量流程
+                    return;
+                }
+                applyDirectoryListing(subdirs, files);
+            }, Qt::QueuedConnection);
+    });
+}
+
+void YouTubeStyleManager::saveSession() const
+{
+    if (m_lastLoadedPath != currentPath)
         return;
 
-    // 再次防御：如果 watcher 正在监控旧任务，先取消
-    if (iconWatcher->isRunning())
-        iconWatcher->cancel();
+    SessionSnapshot snapshot;
+    snapshot.path = QDir::cleanPath(currentPath);
+    snapshot.showImages = checkImages->isChecked();
+    snapshot.showVideos = checkVideos->isChecked();
+    snapshot.sortField = sortCombo->currentData().toInt();
+    snapshot.descending = sortOrderButton->isChecked();
+    snapshot.zoom = zoomSlider->value();
+    // 搜索过滤后的滚动位置对完整列表没有意义
+    if (searchEdit->text().trimmed().isEmpty())
+        snapshot.scrollPosition = contentGrid->verticalScrollBar()->value();
+    snapshot.thumbnailDpr = contentGrid->devicePixelRatioF();
+    snapshot.subdirs = folderListNames;
+
+    // 缩略图只存视口里的：下次启动第一屏就是它们，其余的照常按需生成
+    const QRect viewportRect = contentGrid->viewport()->rect();
+    snapshot.items.reserve(contentGrid->count());
+    for (int i = 0; i < contentGrid->count(); ++i) {
+        const QListWidgetItem *item = contentGrid->item(i);
+        SessionItem entry;
+        entry.name = QFileInfo(item->data(Qt::UserRole).toString()).fileName();
+        entry.isVideo = item->data(Qt::UserRole + 1).toBool();
+        entry.size = item->data(Qt::UserRole + 2).toLongLong();
+        entry.mtime = item->data(MTimeRole).toLongLong();
+        entry.duration = item->data(Qt::UserRole + 4).toDouble();
+        entry.resolution = item->data(Qt::UserRole + 5).toSize();
+        entry.codec = item->data(Qt::UserRole + 6).toString();
+
+        const QVariant decoration = item->data(Qt::DecorationRole);
+        if (!item->isHidden() && decoration.userType() == QMetaType::QPixmap
+            && contentGrid->visualItemRect(item).intersects(viewportRect)) {
+            QBuffer buffer(&entry.thumbnail);
+            buffer.open(QIODevice::WriteOnly);
+            if (decoration.value<QPixmap>().toImage().save(&buffer, "JPG", 85))
+                entry.mipLevel = item->data(MipLevelRole).toInt();
+            else
+                entry.thumbnail.clear();
+        }
+        snapshot.items.append(entry);
+    }
 
-    // 统一缩略图尺寸
-    const int THUMB_WIDTH = 320;
-    const int THUMB_HEIGHT = 240;
-
-    auto future = QtConcurrent::mapped(pendingThumbTasks,
-                                       [=](const LoadTask &task) {
-                                           QIcon icon;
-
-                                           if (task.isVideo) {
-                                               QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
-                                               QDir().mkpath(cacheDir);
-
-                                               QByteArray hash = QCryptographicHash::hash(
-                                                   task.path.toUtf8(), QCryptographicHash::Md5);
-                                               QString cacheFile = cacheDir + "/thumb_" + hash.toHex() + ".jpg";
-
-                                               if (!QFile::exists(cacheFile)) {
-                                                   // ffmpeg 截图并缩放
-                                                   QProcess::execute(ffmpegExecutablePath(),
-                                                                     QStringList()
-                                                                         << "-ss" << "5"
-                                                                         << "-i" << task.path
-                                                                         << "-frames:v" << "1"
-                                                                         << "-q:v" << "5"
-                                                                         << "-threads" << "1"
-                                                                         << "-vf"
-                                                                         << QString("scale=%1:-1").arg(THUMB_WIDTH)
-                                                                         << cacheFile << "-y");
-                                               }
-
-                                               if (QFile::exists(cacheFile)) {
-                                                   QImageReader reader(cacheFile);
-                                                   if (reader.canRead()) {
-                                                       QSize size = reader.size();
-                                                       if (size.isValid()) {
-                                                           reader.setScaledSize(
-                                                               size.scaled(THUMB_WIDTH, THUMB_HEIGHT,
-                                                                           Qt::KeepAspectRatio));
-                                                       }
-                                                       QImage img = reader.read();
-                                                       if (!img.isNull())
-                                                           icon = QIcon(QPixmap::fromImage(img));
-                                                   }
-                                               }
-                                           } else {
-                                               QImageReader reader(task.path);
-                                               reader.setAutoTransform(true);
-
-                                               if (reader.canRead()) {
-                                                   QSize size = reader.size();
-                                                   if (size.isValid()) {
-                                                       reader.setScaledSize(
-                                                           size.scaled(THUMB_WIDTH, THUMB_HEIGHT,
-                                                                       Qt::KeepAspectRatio));
-                                                   }
-                                                   QImage img = reader.read();
-                                                   if (!img.isNull())
-                                                       icon = QIcon(QPixmap::fromImage(img));
-                                               }
-                                           }
-
-                                           return qMakePair(task.index, icon);
-                                       });
+    saveSessionSnapshot(snapshot);
+}
 
-    iconWatcher->setFuture(future);
+void YouTubeStyleManager::moveThumbnailCache(const QString &oldPath, const QString &newPath, bool isVideo)
+{
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    const QString oldHash = QCryptographicHash::hash(oldPath.toUtf8(), QCryptographicHash::Md5).toHex();
+    const QString newHash = QCryptographicHash::hash(newPath.toUtf8(), QCryptographicHash::Md5).toHex();
+    if (isVideo) {
+        QFile::rename(cacheDir + "/thumb_" + oldHash + ".jpg", cacheDir + "/thumb_" + newHash + ".jpg");
+        QFile::rename(storyboardCachePath(oldPath), storyboardCachePath(newPath));
+    } else {
+        QFile::rename(cacheDir + "/thumb_img_" + oldHash + ".jpg", cacheDir + "/thumb_img_" + newHash + ".jpg");
+    }
+}
+
+void YouTubeStyleManager::removeThumbnailCache(const QString &path, bool isVideo)
+{
+    // 与缩略图工作线程、ImageDecoder 的缓存命名保持一致
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    const QString hash = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Md5).toHex();
+    if (isVideo) {
+        QFile::remove(cacheDir + "/thumb_" + hash + ".jpg");
+        QFile::remove(storyboardCachePath(path));
+    } else {
+        QFile::remove(cacheDir + "/thumb_img_" + hash + ".jpg");
+    }
 }
 
 void YouTubeStyleManager::openFolder() {
     QString dir = QFileDialog::getExistingDirectory(this, "选择文件夹", currentPath);
-    if (!dir.isEmpty()) {
-        currentPath = dir;
-        pathLabel->setText(dir);
-        loadContent();
-        rebuildFolderList();    // 根路径变更后，子文件夹列表一起刷新
-        updateBackButtonState();
+    if (!dir.isEmpty())
+        openDirectory(dir);
+}
+
+void YouTubeStyleManager::openDirectory(const QString &dir)
+{
+    currentPath = dir;
+    pathLabel->setText(dir);
+    metaCrawler->addRoot(dir);   // 打开过的文件夹作为媒体库根目录，后台持续爬取
+    loadContent();
+    rebuildFolderList();    // 根路径变更后，子文件夹列表一起刷新
+    updateBackButtonState();
+
+    // 新的库根目录整棵监视；当前目录换成它
+    if (dirWatcher) {
+        dirWatcher->addTree(dir);
+        dirWatcher->setCurrentDirectory(currentPath);
+    }
+}
 
-        // 更新目录监视器监听的路径
-        if (dirWatcher) {
-            dirWatcher->removePaths(dirWatcher->directories());
-            dirWatcher->addPath(currentPath);
+void YouTubeStyleManager::openPath(const QString &path)
+{
+    // 命令行或其他实例转来的路径：目录直接打开，文件打开所在目录并选中它
+    const QFileInfo info(path);
+    if (!info.exists())
+        return;
+
+    showBrowser();
+    const QString dir = info.isDir() ? info.absoluteFilePath() : info.absolutePath();
+    if (QDir::cleanPath(dir) != QDir::cleanPath(currentPath))
+        openDirectory(dir);
+
+    if (!info.isDir()) {
+        if (QListWidgetItem *item = itemsByPath.value(info.absoluteFilePath())) {
+            contentGrid->setCurrentItem(item);
+            contentGrid->scrollToItem(item, QAbstractItemView::PositionAtCenter);
         }
     }
 }
@@ -828,6 +1669,9 @@ void YouTubeStyleManager::handleItemClicked(QListWidgetItem *item) {
         detailPage->setTags(tags);
 
         mainStack->setCurrentWidget(detailPage);
+
+        // 详情页打开期间准备好前后两个视频，接着看下一个时整页直接出来
+        detailPage->prefetch(adjacentVideoPaths(item));
     } else {
         QDesktopServices::openUrl(QUrl::fromLocalFile(filePath));
     }
@@ -835,6 +1679,7 @@ void YouTubeStyleManager::handleItemClicked(QListWidgetItem *item) {
 
 void YouTubeStyleManager::showBrowser() {
     mainStack->setCurrentWidget(browserPage);
+    detailPage->prefetch(QStringList());   // 回到网格：相邻视频的预取不再需要
 }
 
 void YouTubeStyleManager::filterContent(const QString &text) {
@@ -953,13 +1798,232 @@ bool YouTubeStyleManager::eventFilter(QObject *obj, QEvent *event)
         if (event->type() == QEvent::Resize || event->type() == QEvent::Show) {
             scrollDebounceTimer->start();
         }
+        // 快照恢复的滚动位置：第一次显示时视口尺寸才确定，在第一帧之前先布局再滚动
+        if (event->type() == QEvent::Show && pendingScrollPosition >= 0) {
+            contentGrid->doItemsLayout();
+            contentGrid->verticalScrollBar()->setValue(pendingScrollPosition);
+            pendingScrollPosition = -1;
+        }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+        // 窗口拖到不同缩放比例的屏幕上：需要的缩略图档位可能变了
+        if (event->type() == QEvent::DevicePixelRatioChange) {
+            // 和 setGridZoom 一样：档位变了，已经请求过的条目也要按新档位重新生成
+            if (currentMipLevel() != scheduledMipLevel) {
+                thumbTaskQueue.clear();
+                thumbRequested.clear();
+            }
+            scrollDebounceTimer->start();
+        }
+#endif
+        if (event->type() == QEvent::MouseMove)
+            handleGridHover(static_cast<QMouseEvent *>(event)->position().toPoint());
+        if (event->type() == QEvent::Leave)
+            clearHoveredVideo();
+
+        // Ctrl + 滚轮调整网格大小
+        if (event->type() == QEvent::Wheel) {
+            auto *wheel = static_cast<QWheelEvent *>(event);
+            if (wheel->modifiers() & Qt::ControlModifier) {
+                const int steps = wheel->angleDelta().y() / 120;
+                if (steps != 0)
+                    zoomSlider->setValue(zoomSlider->value() + steps * zoomSlider->singleStep());
+                return true;
+            }
+        }
     }
     return QMainWindow::eventFilter(obj, event);
 }
 
+void YouTubeStyleManager::setGridZoom(int percent)
+{
+    const int oldLevel = currentMipLevel();
+    thumbDelegate->setZoom(percent / 100.0);
+    contentGrid->setIconSize(QSize(180, 120) * thumbDelegate->zoom());
+    contentGrid->doItemsLayout();
+
+    // 档位变了：排队中的旧档位任务作废，视口内的条目按新档位重新生成
+    if (currentMipLevel() != oldLevel) {
+        thumbTaskQueue.clear();
+        thumbRequested.clear();
+    }
+    scrollDebounceTimer->start();
+}
+
+void YouTubeStyleManager::rebuildItemIndex()
+{
+    itemsByPath.clear();
+    itemsByPath.reserve(contentGrid->count());
+    for (int i = 0; i < contentGrid->count(); ++i) {
+        QListWidgetItem *item = contentGrid->item(i);
+        itemsByPath.insert(item->data(Qt::UserRole).toString(), item);
+    }
+}
+
+void YouTubeStyleManager::applyMetadata(QListWidgetItem *item, const MediaMeta &meta)
+{
+    // UserRole+4 时长（秒），+5 分辨率，+6 编码；delegate 据此画角标
+    item->setData(Qt::UserRole + 4, meta.duration);
+    item->setData(Qt::UserRole + 5, meta.resolution);
+    item->setData(Qt::UserRole + 6, meta.codec);
+}
+
+void YouTubeStyleManager::onMetadataReady(const QString &path, const MediaMeta &meta)
+{
+    // 爬虫也会处理其他目录，只更新当前列表里有的
+    QListWidgetItem *item = itemsByPath.value(path);
+    if (!item)
+        return;
+    applyMetadata(item, meta);
+
+    // 排序键依赖元数据时，新到的值可能改变顺序
+    const SortField field = SortField(sortCombo->currentData().toInt());
+    if ((field == SortField::Duration || field == SortField::Resolution) && !metaSortTimer->isActive())
+        metaSortTimer->start();
+}
+
+void YouTubeStyleManager::handleGridHover(const QPoint &pos)
+{
+    QListWidgetItem *item = contentGrid->itemAt(pos);
+    if (!item || !item->data(Qt::UserRole + 1).toBool()) {
+        clearHoveredVideo();
+        return;
+    }
+
+    // 光标每次移动都重绘这一格，由 delegate 按光标位置选帧
+    contentGrid->viewport()->update(contentGrid->visualItemRect(item));
+
+    const QString path = item->data(Qt::UserRole).toString();
+    if (path == hoveredVideoPath)
+        return;
+    hoveredVideoPath = path;
+    hoverPrefetchTimer->start();
+    if (!thumbDelegate->hasStoryboard(path))
+        requestStoryboard(path);
+}
+
+void YouTubeStyleManager::clearHoveredVideo()
+{
+    if (hoveredVideoPath.isEmpty())
+        return;
+    hoveredVideoPath.clear();
+    hoverPrefetchTimer->stop();
+    // 详情页打开期间预取的是相邻视频，不受网格悬停影响
+    if (mainStack->currentWidget() == browserPage)
+        detailPage->prefetch(QStringList());
+}
+
+QStringList YouTubeStyleManager::adjacentVideoPaths(QListWidgetItem *item) const
+{
+    // 按网格当前顺序找前后各一个没被筛选隐藏的视频
+    QStringList paths;
+    const int row = contentGrid->row(item);
+    for (int step : { 1, -1 }) {
+        for (int i = row + step; i >= 0 && i < contentGrid->count(); i += step) {
+            QListWidgetItem *other = contentGrid->item(i);
+            if (!other->isHidden() && other->data(Qt::UserRole + 1).toBool()) {
+                paths << other->data(Qt::UserRole).toString();
+                break;
+            }
+        }
+    }
+    return paths;
+}
+
+void YouTubeStyleManager::requestSort()
+{
+    // 先作废还没回来的旧结果，空目录也一样
+    const int generation = ++sortGeneration;
+    if (contentGrid->count() == 0)
+        return;
+
+    // GUI 线程只做一次快照，排序本身（含排序键计算）在排序线程里
+    QVector<SortEntry> entries;
+    entries.reserve(contentGrid->count());
+    for (int i = 0; i < contentGrid->count(); ++i) {
+        const QListWidgetItem *item = contentGrid->item(i);
+        SortEntry e;
+        e.path     = item->data(Qt::UserRole).toString();
+        e.name     = item->text();
+        e.size     = item->data(Qt::UserRole + 2).toLongLong();
+        e.mtime    = item->data(MTimeRole).toLongLong();
+        e.duration = item->data(Qt::UserRole + 4).toDouble();
+        const QSize res = item->data(Qt::UserRole + 5).toSize();
+        if (!res.isEmpty())
+            e.pixels = qint64(res.width()) * res.height();
+        entries.append(e);
+    }
+
+    const SortField field = SortField(sortCombo->currentData().toInt());
+    const bool descending = sortOrderButton->isChecked();
+
+    QtConcurrent::run(&sortPool, [this, entries, field, descending, generation]() {
+        const QStringList sorted = sortEntries(entries, field, descending);
+        QMetaObject::invokeMethod(this, [this, sorted, generation]() {
+                // 期间又换了目录或排序方式，这个结果作废
+                if (generation == sortGeneration)
+                    applySortOrder(sorted);
+            }, Qt::QueuedConnection);
+    });
+}
+
+void YouTubeStyleManager::applySortOrder(const QStringList &sortedPaths)
+{
+    const bool firstSort = awaitingFirstSort;
+    awaitingFirstSort = false;
+
+    // 顺序没变（比如回到缓存的目录）就什么都不做，不打断正在跑的缩略图批次；
+    // 刚打开的目录这时才开始调度缩略图
+    bool unchanged = sortedPaths.size() == contentGrid->count();
+    for (int i = 0; unchanged && i < sortedPaths.size(); ++i)
+        unchanged = contentGrid->item(i)->data(Qt::UserRole).toString() == sortedPaths.at(i);
+    if (unchanged) {
+        if (firstSort)
+            onContentViewportChanged();
+        return;
+    }
+
+    for (int i = 0; i < sortedPaths.size(); ++i) {
+        if (auto *item = dynamic_cast<SortableListItem *>(itemsByPath.value(sortedPaths.at(i))))
+            item->setSortRank(i);
+    }
+
+    contentGrid->sortItems(Qt::AscendingOrder);
+    resetThumbnailRows();
+}
+
+void YouTubeStyleManager::requestStoryboard(const QString &path)
+{
+    if (storyboardBusy) {
+        storyboardNext = path; // 快速划过多个视频时，只生成最后停留的那个
+        return;
+    }
+    storyboardBusy = true;
+
+    QtConcurrent::run(&storyboardPool, [this, path]() {
+        const QImage sheet = loadOrCreateStoryboard(path);
+        QMetaObject::invokeMethod(this, [this, path, sheet]() {
+                storyboardBusy = false;
+                thumbDelegate->setStoryboard(path, sheet);
+                if (path == hoveredVideoPath)
+                    contentGrid->viewport()->update();
+
+                const QString next = storyboardNext;
+                storyboardNext.clear();
+                if (!next.isEmpty() && next == hoveredVideoPath && !thumbDelegate->hasStoryboard(next))
+                    requestStoryboard(next);
+            }, Qt::QueuedConnection);
+    });
+}
+
+int YouTubeStyleManager::currentMipLevel() const
+{
+    return ThumbnailDelegate::mipLevelFor(thumbDelegate->thumbnailSize()
+                                          * contentGrid->devicePixelRatioF());
+}
+
 void YouTubeStyleManager::onContentViewportChanged()
 {
-    if (!contentGrid || contentGrid->count() == 0)
+    if (!contentGrid || contentGrid->count() == 0 || awaitingFirstSort)
         return;
 
     QWidget *vp = contentGrid->viewport();
@@ -970,9 +2034,29 @@ void YouTubeStyleManager::onContentViewportChanged()
     if (vpRect.isEmpty())
         return;
 
-    // 1. 扩大视口区域（上下各预加载一屏），保证滚动时不会露白
-    const int extra = vpRect.height();
-    vpRect.adjust(0, -extra, 0, extra);
+    // 1. 预取窗口：静止时上下各一屏；滚动中按速度预测一段时间后的视口位置，
+    //    窗口一直延伸到预测位置，两屏的预取量越快越偏向前进方向
+    lastScheduleMs = scrollClock.elapsed();
+    const double velocity = (lastScheduleMs - lastScrollMs > ScrollIdleMs) ? 0.0 : scrollVelocity;
+    const int screen = vpRect.height();
+    const int travel = qBound(-3 * screen, int(velocity * ScrollLookaheadMs), 3 * screen);
+    const double bias = qBound(0.0, qAbs(velocity) / FlingVelocity, 1.0);
+    const int ahead = int(screen * (1.0 + bias));
+    const int behind = screen * 2 - ahead;
+    const QRect predicted = vpRect.translated(0, travel);
+    if (velocity >= 0)
+        vpRect.adjust(0, -behind, 0, travel + ahead);
+    else
+        vpRect.adjust(0, travel - ahead, 0, behind);
+
+    const int scrollValue = contentGrid->verticalScrollBar()->value();
+    thumbWindowTop = vpRect.top() + scrollValue;
+    thumbWindowBottom = vpRect.bottom() + scrollValue;
+
+    // 还没开始的任务按新窗口重新规划，免得预取额度花在已经离开的方向上
+    for (const LoadTask &task : std::as_const(thumbTaskQueue))
+        thumbRequested.remove(task.index);
+    thumbTaskQueue.clear();
 
     const int itemCount = contentGrid->count();
 
@@ -986,26 +2070,38 @@ void YouTubeStyleManager::onContentViewportChanged()
     QListWidgetItem *topItem = contentGrid->itemAt(20, 20);
     // 如果左上角没踩到（可能是padding），尝试探测视口中心
     if (!topItem) {
-        topItem = contentGrid->itemAt(vpRect.center());
+        topItem = contentGrid->itemAt(contentGrid->viewport()->rect().center());
         // 如果中心点踩到了，我们往回倒推一些，确保覆盖前面
         if (topItem) {
             // 拿到中心元素的索引，稍微多减一点，比如减100，保证回溯到顶部
             start = qMax(0, contentGrid->row(topItem) - 100);
         }
     } else {
+        // 向上滚动时窗口可能超出视口好几屏，按每行条目数倒推到窗口顶部
+        const QRect topRect = contentGrid->visualItemRect(topItem);
+        const int perRow = qMax(1, contentGrid->viewport()->width() / qMax(1, topRect.width()));
+        const int rowsAbove = qMax(0, topRect.top() - vpRect.top()) / qMax(1, topRect.height()) + 1;
         start = contentGrid->row(topItem);
-        start = qMax(0, start - 60);
+        start = qMax(0, start - qMax(60, rowsAbove * perRow));
     }
 
+    // 缩放或 DPR 变化后，已有缩略图的档位不对也要重新生成
+    const int mipLevel = currentMipLevel();
+    scheduledMipLevel = mipLevel;
+
     // 从计算出的 start 开始遍历，而不是从 0 开始
     for (int i = start; i < itemCount; ++i) {
-        // 已经生成过或正在生成的，跳过
-        if (thumbReady.contains(i) || thumbRequested.contains(i))
+        // 正在生成的，跳过
+        if (thumbRequested.contains(i))
             continue;
 
         QListWidgetItem *item = contentGrid->item(i);
         if (!item) continue;
 
+        // 已经按当前档位生成过的，跳过
+        if (thumbReady.contains(i) && item->data(MipLevelRole).toInt() == mipLevel)
+            continue;
+
         // 获取 item 在视口中的几何位置
         // 注意：visualItemRect 在大量调用时有性能开销，但因为我们限制了循环次数，所以这里很快
         const QRect itemRect = contentGrid->visualItemRect(item);
@@ -1032,15 +2128,47 @@ void YouTubeStyleManager::onContentViewportChanged()
         task.index   = i;
         task.path    = path;
         task.isVideo = isVideo;
+        task.cost    = isVideo
+                        ? VideoThumbCost
+                        : ImageDecoderRegistry::instance().estimateCost(
+                              QFileInfo(path).suffix().toLower(),
+                              item->data(Qt::UserRole + 2).toLongLong());
+
+        // 离预测视口越近越先做，按屏分档
+        task.band    = qAbs(itemRect.center().y() - predicted.center().y()) / qMax(1, screen);
 
         thumbTaskQueue.enqueue(task);
         thumbRequested.insert(i);
     }
     // === 核心优化 END ===
 
+    // 同一档里便宜的任务先做：同一屏里的 JPEG 不必排在慢速视频截帧后面
+    std::stable_sort(thumbTaskQueue.begin(), thumbTaskQueue.end(),
+                     [](const LoadTask &a, const LoadTask &b) {
+                         return a.band != b.band ? a.band < b.band : a.cost < b.cost;
+                     });
+
     tryStartNextThumbBatch();
 }
 
+void YouTubeStyleManager::trackScrollVelocity(int value)
+{
+    const qint64 now = scrollClock.elapsed();
+    const qint64 dt = now - lastScrollMs;
+    const int delta = value - lastScrollValue;
+    lastScrollValue = value;
+    lastScrollMs = now;
+
+    // 停顿之后的第一下没有可信的时间间隔，从零开始
+    if (dt > ScrollIdleMs) {
+        scrollVelocity = 0.0;
+        return;
+    }
+    // 滚轮和拖动的事件间隔不均匀，做一次指数平滑
+    const double instant = double(delta) / qMax<qint64>(1, dt);
+    scrollVelocity = 0.5 * scrollVelocity + 0.5 * instant;
+}
+
 void YouTubeStyleManager::tryStartNextThumbBatch()
 {
     // 已有一个 future 在跑，就不要再开新的
@@ -1051,17 +2179,17 @@ void YouTubeStyleManager::tryStartNextThumbBatch()
         return;
 
     QList<LoadTask> batch;
-    QRect viewportRect = contentGrid->viewport()->rect(); // 获取当前视口
+    const int scrollValue = contentGrid->verticalScrollBar()->value();
     while (!thumbTaskQueue.isEmpty() && batch.size() < ThumbBatchSize) {
         LoadTask task = thumbTaskQueue.dequeue();
 
         // --- 新增优化：二次可见性检查 ---
         QListWidgetItem* item = contentGrid->item(task.index);
         if (item) {
-            QRect itemRect = contentGrid->visualItemRect(item);
-            // 如果任务取出来时，已经不在视口内了（比如用户又滑走了），直接丢弃！
+            const QRect itemRect = contentGrid->visualItemRect(item).translated(0, scrollValue);
+            // 如果任务取出来时，已经不在最近的预取窗口内了（比如用户又滑走了），直接丢弃！
             // 注意：这里放宽一点判定范围，避免边缘闪烁
-            if (itemRect.bottom() < -500 || itemRect.top() > viewportRect.height() + 500) {
+            if (itemRect.bottom() < thumbWindowTop - 500 || itemRect.top() > thumbWindowBottom + 500) {
                 thumbRequested.remove(task.index); // 移除占用标记
                 continue; // 跳过此任务，取下一个
             }
@@ -1074,98 +2202,23 @@ void YouTubeStyleManager::tryStartNextThumbBatch()
     if (batch.isEmpty())
         return;
 
-    const int THUMB_WIDTH  = 320;
-    const int THUMB_HEIGHT = 240;
-
-    auto future = QtConcurrent::mapped(batch, [=](const LoadTask &task) {
-        QIcon icon;
-
-        if (task.isVideo) {
-            QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
-            QDir().mkpath(cacheDir);
-
-            QByteArray hash = QCryptographicHash::hash(
-                task.path.toUtf8(), QCryptographicHash::Md5);
-            QString cacheFile = cacheDir + "/thumb_" + hash.toHex() + ".jpg";
-
-            if (!QFile::exists(cacheFile)) {
-                QStringList args;
-                args << "-ss" << "5"
-                     << "-i" << task.path
-                     << "-frames:v" << "1"
-                     << "-q:v" << "5"
-                     << "-threads" << "1"
-                     << "-vf" << QString("scale=%1:-1").arg(THUMB_WIDTH)
-                     << cacheFile << "-y";
-
-                // 这里在后台线程调用，不会阻塞 UI
-                runFfmpegBlocking(args);
-            }
-
-            if (QFile::exists(cacheFile)) {
-                QImageReader reader(cacheFile);
-                if (reader.canRead()) {
-                    QSize size = reader.size();
-                    if (size.isValid()) {
-                        reader.setScaledSize(
-                            size.scaled(THUMB_WIDTH, THUMB_HEIGHT,
-                                        Qt::KeepAspectRatio));
-                    }
-                    QImage img = reader.read();
-                    if (!img.isNull())
-                        icon = QIcon(QPixmap::fromImage(img));
-                }
-            }
-        } else {
-            QImage img;
+    // 缩略图是交互任务，运行期间元数据爬虫和目录预热都让路
+    metaCrawler->setPaused(true);
+    cancelFolderWarming();
 
-            // 1. 优先尝试使用 Qt 自带解码器读取 (速度快，支持 JPG/PNG/BMP 等)
-            QImageReader reader(task.path);
-            reader.setAutoTransform(true);
+    // 档位和 DPR 只能在 GUI 线程取，整批任务共用
+    const qreal dpr = contentGrid->devicePixelRatioF();
+    const int mipLevel = currentMipLevel();
+    const QSize mipBox(mipLevel, mipLevel);
+    const int generation = thumbGeneration;
 
-            if (reader.canRead()) {
-                QSize size = reader.size();
-                if (size.isValid()) {
-                    reader.setScaledSize(
-                        size.scaled(THUMB_WIDTH, THUMB_HEIGHT,
-                                    Qt::KeepAspectRatio));
-                }
-                img = reader.read();
-            }
-
-            // 2. [关键修改] 如果 Qt 读不出来 (img为空，例如 WebP/HEIC)，则通过 FFmpeg 转换
-            if (img.isNull()) {
-                // 准备缓存路径
-                QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
-                QDir().mkpath(cacheDir);
-                QByteArray hash = QCryptographicHash::hash(task.path.toUtf8(), QCryptographicHash::Md5);
-                QString cacheFile = cacheDir + "/thumb_img_" + hash.toHex() + ".jpg";
-
-                // 如果缓存不存在，调用 ffmpeg 转换第一帧
-                if (!QFile::exists(cacheFile)) {
-                    QStringList args;
-                    args << "-i" << task.path
-                         << "-frames:v" << "1"      // 只取1帧
-                         << "-q:v" << "5"           // 质量
-                         << "-vf" << QString("scale=%1:-1").arg(THUMB_WIDTH) // 缩放
-                         << cacheFile << "-y";
-
-                    // 使用之前封装好的阻塞调用
-                    runFfmpegBlocking(args);
-                }
-
-                // 尝试加载转换后的缓存文件
-                if (QFile::exists(cacheFile)) {
-                    img.load(cacheFile);
-                }
-            }
-
-            // 3. 设置图标
-            if (!img.isNull())
-                icon = QIcon(QPixmap::fromImage(img));
-        }
+    auto future = QtConcurrent::mapped(batch, [=](const LoadTask &task) {
+        const QImage img = loadGridThumbnail(task.path, task.isVideo, mipBox, dpr, true);
 
-        return qMakePair(task.index, icon);
+        // 放进无锁队列；队列原本是空的才需要叫醒 GUI 线程
+        if (thumbResults.push(ThumbResult { task.index, mipLevel, generation, img }))
+            QMetaObject::invokeMethod(thumbApplyTimer, qOverload<>(&QTimer::start), Qt::QueuedConnection);
+        return task.index;
     });
 
     iconWatcher->setFuture(future);
@@ -11,7 +11,9 @@
 #include <QLineEdit>
 #include <QPair>
 #include <QIcon>
+#include <QImage>
 #include <QMap>
+#include <QHash>
 #include <QStringList>
 #include <QJsonObject>
 #include <QJsonDocument>
@@ -19,18 +21,33 @@
 #include <QFile>
 #include <QStandardPaths>
 #include <QDir>
-#include <QFileSystemWatcher>
 #include <QVector>
 #include <QSet>
 #include <QQueue>
 #include <QEvent>
 #include <QTimer>
+#include <QThreadPool>
+#include <QCache>
+#include <QPixmap>
+#include <QElapsedTimer>
+#include "LockFreeQueue.h"
+#include <atomic>
+#include <memory>
 
 // 前置声明
 class VideoDetailWidget;
+class MetadataCrawler;
+class DirectoryWatcher;
+struct MediaMeta;
+class ThumbnailDelegate;
+class QSlider;
+class QComboBox;
 class QVBoxLayout;
 class QWidget;
 class QCheckBox;
+class QTreeView;
+class FolderTreeModel;
+class FolderStatsAggregator;
 
 class YouTubeStyleManager : public QMainWindow {
     Q_OBJECT
@@ -43,41 +60,86 @@ public slots:
     void loadContent();
     void handleItemClicked(QListWidgetItem *item);
     void openFolder();
+    void openPath(const QString &path);     // 打开目录，或打开文件所在目录并选中它
     void showBrowser();
 
 private slots:
-    void onThumbnailLoaded(int index);
+    void applyThumbnailResults();           // 按帧预算应用工作线程送来的缩略图
     void filterContent(const QString &text); // 筛选内容的槽函数
     void updateVideoTags(const QString &path, const QStringList &tags);
     void goUpDirectory();   // 返回上一级目录
-    void onDirectoryChanged(const QString &path);   // 监控目录变化
+    void onDirectoriesChanged(const QStringList &dirs); // 目录内容变化（已合并）
+    void onTreeInvalidated(const QString &root);        // 监视事件丢失，整棵树重扫
+    void onPathRenamed(const QString &oldPath, const QString &newPath);
     void handleVideoRenamed(const QString &oldPath, const QString &newPath);
+    void onMetadataReady(const QString &path, const MediaMeta &meta);
 
 private:
     void applyStyle();
+    void openDirectory(const QString &dir);  // 切到目录并加入媒体库
     void loadTags();
     void saveTags() const;
     void rebuildFolderList();   // 重新构建左侧子文件夹列表
-    void handleFolderCheckBoxToggled(bool checked); // 子文件夹勾选变化
+    void showFolderList(const QStringList &names);  // 按给定的子目录名填充文件夹树（不再枚举）
+    void handleFolderActivated(const QModelIndex &index); // 点击文件夹树里的目录
     void updateBackButtonState();   // 更新返回按钮显隐
     void scheduleVisibleThumbnails();  // 根据视口把“附近条目”加入任务队列
     void tryStartNextThumbBatch();     // 从队列取下一批任务交给 QtConcurrent 跑
     void onContentViewportChanged();
+    void trackScrollVelocity(int value);  // 记录滚动速度和方向，供预取窗口预测落点
     void updateVisibleThumbnails();     // 根据当前视口调度缩略图
+    bool applyThumbnail(int row, QImage img, int mipLevel); // 把工作线程的结果设置到条目上
+    void cancelThumbnailBatch();        // 取消正在跑的批次，丢弃它还没应用的结果
+    void setGridZoom(int percent);      // 网格缩放滑块
+    int currentMipLevel() const;        // 当前缩放和 DPR 下需要的缩略图档位
+    void handleGridHover(const QPoint &pos);          // 悬停在视频上：刷新拖动预览
+    void clearHoveredVideo();                         // 离开视频格子：取消悬停预取
+    QStringList adjacentVideoPaths(QListWidgetItem *item) const; // 前后相邻的可见视频
+    void rebuildItemIndex();                          // 重建 路径 -> 条目 索引
+    static void applyMetadata(QListWidgetItem *item, const MediaMeta &meta);
+    void requestStoryboard(const QString &path);      // 后台读取/生成故事板
+    void requestSort();                               // 在排序线程里按当前排序方式重排
+    void applySortOrder(const QStringList &sortedPaths);
+    QStringList mediaNameFilters() const;             // 按图片/视频勾选生成的名称过滤
+    QListWidgetItem *createMediaItem(const QString &filePath, qint64 size, qint64 mtime, QStringList *unprobed);
+    void updateItemFileInfo(QListWidgetItem *item, qint64 size, qint64 mtime, QStringList *unprobed);
+    void probeMetadata(const QStringList &paths, bool replace); // 图片在后台整批读文件头，其余交给爬虫
+    void applyDirectoryDiff();                        // 只增删改变化的条目，不重建整个网格
+    void applyDirectoryListing(const QFileInfoList &subdirs, const QFileInfoList &files);
+    bool restoreSession();                            // 用上次会话的快照直接画出第一屏
+    void revalidateSession();                         // 后台重新枚举快照里的目录，再增量比对
+    void saveSession() const;                         // 退出时保存当前目录的快照
+    void resetThumbnailRows();                        // 行号变化后重建缩略图调度状态
+    static void removeThumbnailCache(const QString &path, bool isVideo);
+    static void moveThumbnailCache(const QString &oldPath, const QString &newPath, bool isVideo);
+    void dropDirCache(const QString &dir, bool recursive); // 丢弃过期的目录缓存
+    void warmPredictedFolders();                      // 按导航历史预测下一个目录，空闲时提前枚举和生成缩略图
+    void cancelFolderWarming();
 
     QString tagFilePath() const;
     QTimer *scrollDebounceTimer;
 
+    // 滚动速度：快速滚动时不等停下就按预测落点请求缩略图，预取窗口偏向前进方向
+    QElapsedTimer scrollClock;
+    int lastScrollValue = 0;
+    qint64 lastScrollMs = 0;
+    qint64 lastScheduleMs = -1;
+    double scrollVelocity = 0.0;        // 像素/毫秒，平滑后的值，向下为正
+    int thumbWindowTop = 0;             // 最近一次预取窗口，内容坐标
+    int thumbWindowBottom = 0;
+    static const int ScrollIdleMs = 150;            // 超过这么久没有滚动事件视为已停下
+    static const int ScrollScheduleIntervalMs = 60; // 滚动中最多每 60 ms 调度一次
+    static const int ScrollLookaheadMs = 400;       // 预测多久之后的视口位置（约一批缩略图的耗时）
+    static constexpr double FlingVelocity = 3.0;    // 达到这个速度时预取全部放在前方
+
     // === 缩略图任务结构 + 待处理列表 ===
     struct LoadTask {
         int index;
         QString path;
         bool isVideo;
+        int cost = 0;   // 解码器预估代价，越小越先处理
+        int band = 0;   // 距预测视口的屏数，越小越先处理
     };
-    QVector<LoadTask> pendingThumbTasks;
-    // === 启动缩略图生成的内部函数 ===
-    void startThumbnailGeneration();
-
     // 等待生成缩略图的任务队列
     QQueue<LoadTask> thumbTaskQueue;
     // 已经请求过生成（在队列或正在执行）的条目索引
@@ -85,43 +147,118 @@ private:
     // 已经成功生成缩略图的条目索引
     QSet<int> thumbReady;
     static const int ThumbBatchSize = 32; // 一次最多处理多少个缩略图
+    static const int VideoThumbCost = 150; // 视频截帧要启动 ffmpeg，代价按固定值估算
+    static const int MipLevelRole = Qt::UserRole + 3; // 条目上当前缩略图的档位
+    int scheduledMipLevel = 0;             // 上一次排程用的档位，DPR 变化时据此判断要不要重新生成
+
+    // 工作线程产出的缩略图：无锁队列 -> GUI 线程按帧预算取出应用
+    struct ThumbResult {
+        int row;
+        int mipLevel;
+        int generation;     // 与 thumbGeneration 不同的是已取消批次的结果
+        QImage image;
+    };
+    LockFreeQueue<ThumbResult> thumbResults;
+    QQueue<ThumbResult> thumbPending;      // 已取出、这一帧没来得及应用的
+    QTimer *thumbApplyTimer = nullptr;
+    int thumbGeneration = 0;
+    static const int ThumbApplyBudgetUs = 4000; // 每一轮最多占用 GUI 线程 4 ms
+    static const int MTimeRole = Qt::UserRole + 7;    // 修改时间（毫秒），按日期排序用
+
+    // 排序：单独一个线程，只跑排序，不和缩略图任务、元数据库加载抢线程；只应用最新一次请求的结果
+    QThreadPool sortPool;
+    bool awaitingFirstSort = false;        // 刚打开的目录等第一次排序结果再调度缩略图
+    // 元数据库和目录索引的加载、索引记录、图片文件头的批量读取、启动时的快照校验：
+    // 第一次取这两个单例会读整个文件，GUI 线程不碰它们
+    QThreadPool storePool;
+    std::shared_ptr<std::atomic_bool> headerCancel;  // 换目录时置位，旧目录的文件头不再读
+    static const int HeaderBatchSize = 256;          // 文件头结果每块送回的条数
+    int sortGeneration = 0;
+    int pendingScrollPosition = -1;        // 快照恢复的滚动位置，视口第一次显示时应用
+
+    // 悬停拖动预览：同一时间只跑一个故事板任务，期间只记住最后悬停的视频
+    QString hoveredVideoPath;
+    QTimer *hoverPrefetchTimer = nullptr;  // 在视频上停留一会儿才预取详情页
+    static const int HoverPrefetchDelayMs = 300;
+
+    // 后台元数据爬虫（时长/分辨率角标），缩略图批次运行时暂停
+    MetadataCrawler *metaCrawler = nullptr;
+    QHash<QString, QListWidgetItem *> itemsByPath; // 当前列表的 路径 -> 条目
+    bool storyboardBusy = false;
+    QString storyboardNext;
+    QThreadPool storyboardPool;               // 同一时间只跑一个故事板任务，析构时等它结束
 
     QStackedWidget *mainStack;
     QWidget *browserPage;
     VideoDetailWidget *detailPage;
     QListWidget *contentGrid;
+    ThumbnailDelegate *thumbDelegate = nullptr;
+    QSlider *zoomSlider = nullptr;      // 网格缩放
+    QComboBox *sortCombo = nullptr;     // 排序方式
+    QPushButton *sortOrderButton = nullptr; // 升序 / 降序
+    QTimer *metaSortTimer = nullptr;    // 元数据陆续到达时合并重排
     QCheckBox *checkImages;
     QCheckBox *checkVideos;
     QLabel *pathLabel;
     QString currentPath;
     QLineEdit *searchEdit; // 搜索框指针
-    QFutureWatcher<QPair<int, QIcon>> *iconWatcher; // 异步缩略图加载器
+    QFutureWatcher<int> *iconWatcher; // 异步缩略图批次（结果经 thumbResults 送回）
     QMap<QString, QStringList> videoTags;   // 路径 -> 标签
     QWidget *folderListContainer = nullptr;   // 底部区域容器
-    QVBoxLayout *folderListLayout = nullptr;  // 子文件夹复选框列表布局
+    QTreeView *folderTree = nullptr;          // 子文件夹树（懒加载，只绘制可见行）
+    FolderTreeModel *folderModel = nullptr;
+    FolderStatsAggregator *folderStats = nullptr;   // 后台统计子树的文件数和大小，显示为文件夹树的角标
     QPushButton *backButton = nullptr; // 返回按钮
-    QFileSystemWatcher *dirWatcher = nullptr;   // 目录监视器
+    DirectoryWatcher *dirWatcher = nullptr;     // 目录监视（库目录树 + 当前目录）
+    QTimer *dirChangeTimer = nullptr;           // 合并连续的目录变化
+    QStringList folderListNames;                // 左侧列表当前显示的子目录（根下一层）
 
-    bool updatingFolderChecks = false;        // 防止递归更新
     // 用于跟踪视口变化（滚动 / 尺寸变化）
     bool eventFilter(QObject *obj, QEvent *event) override;
 
-    // --- 缓存相关结构 ---
-    struct DirCache {
-        QList<QListWidgetItem*> items; // 保存所有的 Item 指针（带图标）
-        int scrollPosition;            // 保存离开时的滚动条位置
-        QSet<int> thumbReady;          // 保存哪些缩略图已经加载好了
+    // --- 目录列表缓存 ---
+    // 只存轻量的文件记录（不存控件），代价按 KB 计、LRU 淘汰；重新进入目录时 stat 一次
+    // 目录 mtime，没变就直接用。记录包含全部媒体文件，图片/视频勾选只是它上面的视图
+    struct FileRecord {
+        QString name;
+        qint64 size = 0;
+        qint64 mtime = 0;           // 毫秒
+        bool isVideo = false;
+    };
+    struct DirListing {
+        qint64 dirMtime = 0;        // 枚举前取的目录 mtime
+        QVector<FileRecord> files;  // 按名称排序
+        int scrollPosition = -1;    // 离开时的滚动条位置
+    };
+    QCache<QString, DirListing> m_dirCache;   // cleanPath -> 列表
+    static const int DirCacheMaxKB = 16 * 1024;
+
+    // 离开目录或切换过滤时条目会销毁，已生成的缩略图按路径留在这里，回来时直接挂上
+    struct CachedThumb {
+        QPixmap pixmap;
+        int mipLevel = 0;
+        qint64 mtime = 0;           // 文件修改时间，对不上就不用
     };
+    QCache<QString, CachedThumb> m_thumbCache; // 路径 -> 缩略图，代价按 KB 计
+    static const int ThumbCacheMaxKB = 64 * 1024;
+
+    // 枚举目录下全部媒体文件（工作线程也会调用）；超过 maxEntries 或被取消时返回 false
+    static bool readDirListing(const QString &dir, DirListing *listing, int maxEntries = -1,
+                               const std::atomic_bool *cancel = nullptr);
+    static int listingCost(const DirListing &listing);
+    void stashThumbnails();     // 当前条目的缩略图放进 m_thumbCache
 
-    // 路径 -> 缓存数据
-    QMap<QString, DirCache> m_dirCache;
+    // 预热：历史预测的下一个目录，提前把列表放进 m_dirCache、第一屏缩略图放进 m_thumbCache
+    QThreadPool warmPool;                     // 单线程、低优先级，析构时等它结束
+    QTimer *warmTimer = nullptr;              // 导航、悬停或缩略图做完后重新计时
+    std::shared_ptr<std::atomic_bool> warmCancel;
+    int warmGeneration = 0;
+    static const int WarmIdleMs = 1500;
+    static const int WarmHoverDelayMs = 300;
 
     // 记录上一次显示的路径，用于判断是“离开”还是“刷新”
     QString m_lastLoadedPath;
 
-    // 辅助函数：清空所有缓存（防止内存泄漏）
-    void clearAllCache();
-
     static bool isVideoSuffix(const QString &suffix) {
         return (suffix == "mp4" || suffix == "mkv" || suffix == "avi" || suffix == "mov" ||
                 suffix == "webm" || suffix == "flv" || suffix == "wmv" || suffix == "m4v");
@@ -1,11 +1,69 @@
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
 #include <cstdlib>
 #include "YouTubeStyleManager.h"
 #include "FfmpegUtil.h"
+#include "Benchmarks.h"
+#include "SingleInstance.h"
 
 int main(int argc, char *argv[]) {
+    QElapsedTimer launchTimer;  // 启动基准从这里开始计时
+    launchTimer.start();
     QApplication app(argc, argv);
 
+    // 性能基准：跑完直接退出，不创建主窗口
+    const QStringList args = app.arguments();
+    if (args.contains("--bench-scaler"))
+        return runScalerBenchmark();
+    if (args.size() > 1 && args.at(1) == "--bench-probe")
+        return runProbeBenchmark(args.mid(2));
+    if (args.size() > 1 && args.at(1) == "--bench-rescan")
+        return runRescanBenchmark(args.value(2));
+    if (args.contains("--bench-startup"))
+        return runStartupBenchmark(launchTimer);
+    if (args.contains("--bench-ffmpeg"))
+        return runFfmpegLocateBenchmark();
+    if (args.contains("--bench-paint"))
+        return runPaintBenchmark();
+
+    // 命令行里第一个不是选项的参数是要打开的目录或文件；转给其他进程前先变成绝对路径
+    QString requestedPath;
+    for (const QString &arg : args.mid(1)) {
+        if (!arg.startsWith("--")) {
+            requestedPath = QFileInfo(arg).absoluteFilePath();
+            break;
+        }
+    }
+    if (args.size() > 1 && args.at(1) == "--bench-instance")
+        return runInstanceBenchmark(launchTimer, requestedPath);
+
+    // 已经有实例在运行：交给它打开，本进程直接退出。--new-instance 强制另起一个
+    const bool newInstance = args.contains("--new-instance");
+    if (!newInstance) {
+        switch (SingleInstance::forwardToRunning(requestedPath)) {
+        case SingleInstance::Forwarded:
+            return 0;
+        case SingleInstance::Unreachable:
+            qWarning("MediaManager is already running but not responding; use --new-instance to start another");
+            return 1;
+        case SingleInstance::NoInstance:
+            break;
+        }
+    }
+
+    // 没有转出去就马上占住服务名，再建窗口；之后启动的进程会排队等本进程打开
+    SingleInstance instance;
+    if (!newInstance) {
+        const SingleInstance::ListenResult listened = instance.listen(requestedPath);
+        if (listened == SingleInstance::Handed)
+            return 0;
+        if (listened == SingleInstance::Busy) {
+            qWarning("MediaManager is already running but not responding; use --new-instance to start another");
+            return 1;
+        }
+    }
+
     QObject::connect(&app, &QCoreApplication::aboutToQuit, []() {
         killAllFfmpegProcesses();
 
@@ -19,6 +77,20 @@ int main(int argc, char *argv[]) {
     });
 
     YouTubeStyleManager w;
+    if (!requestedPath.isEmpty())
+        w.openPath(requestedPath);
     w.show();
+
+    if (!newInstance) {
+        QObject::connect(&instance, &SingleInstance::openRequested, &w, [&w](const QString &path) {
+            if (!path.isEmpty())
+                w.openPath(path);
+            // 最小化的话先还原，再提到前台
+            w.setWindowState((w.windowState() & ~Qt::WindowMinimized) | Qt::WindowActive);
+            w.raise();
+            w.activateWindow();
+        });
+    }
+    prepareFfmpegAsync();   // 窗口出来以后再在后台定位 ffmpeg，第一次截帧时通常已经就绪
     return app.exec();
 }